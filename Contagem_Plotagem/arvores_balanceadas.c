@@ -0,0 +1,253 @@
+// Árvores balanceadas (AVL e rubro-negra) com inserção e busca iterativas.
+// Com chaves em ordem crescente a BST de contagem.c vira uma lista; estas continuam com altura
+// O(log n), então o número de comparações volta a refletir a estrutura e não a ordem das chaves.
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "estruturas.h"
+
+// Altura máxima de uma AVL com 2^31 nós é cerca de 1,44 * 31 < 64.
+#define ALTURA_MAXIMA_AVL 64
+
+// ==================== Árvore AVL =======================
+
+// Altura de uma subárvore (a subárvore vazia tem altura 0).
+static int altura(NoAVL* no) {
+    return no ? no->altura : 0;
+}
+
+// Recalcula a altura de um nó a partir das alturas dos filhos.
+static void atualizar_altura(NoAVL* no) {
+    int esq = altura(no->esquerda), dir = altura(no->direita);
+    no->altura = 1 + (esq > dir ? esq : dir);
+}
+
+// Rotação à direita: o filho esquerdo sobe e o nó desce para a direita.
+static NoAVL* rotacionar_direita(NoAVL* no) {
+    NoAVL* filho = no->esquerda;
+    no->esquerda = filho->direita;
+    filho->direita = no;
+    atualizar_altura(no);
+    atualizar_altura(filho);
+    return filho;
+}
+
+// Rotação à esquerda: o filho direito sobe e o nó desce para a esquerda.
+static NoAVL* rotacionar_esquerda(NoAVL* no) {
+    NoAVL* filho = no->direita;
+    no->direita = filho->esquerda;
+    filho->esquerda = no;
+    atualizar_altura(no);
+    atualizar_altura(filho);
+    return filho;
+}
+
+// Corrige um nó com fator de balanceamento +-2 e retorna a nova raiz da subárvore.
+static NoAVL* balancear(NoAVL* no) {
+    atualizar_altura(no);
+    int fator = altura(no->esquerda) - altura(no->direita);
+
+    if (fator > 1) {
+        // Caso esquerda-direita: primeiro gira o filho para virar esquerda-esquerda.
+        if (altura(no->esquerda->esquerda) < altura(no->esquerda->direita))
+            no->esquerda = rotacionar_esquerda(no->esquerda);
+        return rotacionar_direita(no);
+    }
+    if (fator < -1) {
+        // Caso direita-esquerda, simétrico.
+        if (altura(no->direita->direita) < altura(no->direita->esquerda))
+            no->direita = rotacionar_direita(no->direita);
+        return rotacionar_esquerda(no);
+    }
+    return no;
+}
+
+// Insere sem recursão: desce guardando o endereço de cada ponteiro percorrido e, depois de
+// pendurar o novo nó, sobe pelo mesmo caminho atualizando alturas e rotacionando onde preciso.
+// Retorna 0, ou -1 se faltou memória (a árvore fica como estava).
+int inserir_avl(NoAVL** raiz, int chave) {
+    NoAVL** caminho[ALTURA_MAXIMA_AVL];
+    int profundidade = 0;
+    NoAVL** ligacao = raiz;
+
+    while (*ligacao != NULL) {
+        if (chave == (*ligacao)->chave)
+            return 0; // chave repetida: nada muda
+        caminho[profundidade++] = ligacao;
+        ligacao = (chave < (*ligacao)->chave) ? &(*ligacao)->esquerda : &(*ligacao)->direita;
+    }
+
+    NoAVL* novo = (NoAVL*)malloc(sizeof(NoAVL));
+    if (novo == NULL)
+        return -1;
+    novo->chave = chave;
+    novo->altura = 1;
+    novo->esquerda = novo->direita = NULL;
+    *ligacao = novo;
+
+    // Sobe até a raiz; quando a altura de um nó não muda, os ancestrais também não mudam.
+    while (profundidade > 0) {
+        NoAVL** atual = caminho[--profundidade];
+        int altura_antes = (*atual)->altura;
+        *atual = balancear(*atual);
+        if ((*atual)->altura == altura_antes)
+            break;
+    }
+    return 0;
+}
+
+// Mesma busca da BST: uma comparação por nó visitado.
+int buscar_avl(const NoAVL* no, int chave) {
+    int comparacoes = 0;
+    while (no != NULL) {
+        comparacoes++;
+        if (chave == no->chave)
+            return comparacoes;
+        no = (chave < no->chave) ? no->esquerda : no->direita;
+    }
+    return comparacoes;
+}
+
+// Busca em lote, como buscar_arvore_lote de contagem.c.
+DEFINIR_BUSCA_LOTE(buscar_avl_lote, const NoAVL*, const NoAVL*, NULL, RAIZ_PONTEIRO, NO_PONTEIRO)
+
+// A altura é logarítmica, então a recursão é rasa.
+void liberar_avl(NoAVL* no) {
+    if (no == NULL) return;
+    liberar_avl(no->esquerda);
+    liberar_avl(no->direita);
+    free(no);
+}
+
+// ==================== Árvore rubro-negra =======================
+
+// Rotações com ponteiro para o pai; retornam a raiz da árvore inteira, que pode mudar.
+static NoRB* rotacionar_esquerda_rb(NoRB* raiz, NoRB* no) {
+    NoRB* filho = no->direita;
+    no->direita = filho->esquerda;
+    if (filho->esquerda)
+        filho->esquerda->pai = no;
+    filho->pai = no->pai;
+    if (no->pai == NULL)
+        raiz = filho;
+    else if (no == no->pai->esquerda)
+        no->pai->esquerda = filho;
+    else
+        no->pai->direita = filho;
+    filho->esquerda = no;
+    no->pai = filho;
+    return raiz;
+}
+
+static NoRB* rotacionar_direita_rb(NoRB* raiz, NoRB* no) {
+    NoRB* filho = no->esquerda;
+    no->esquerda = filho->direita;
+    if (filho->direita)
+        filho->direita->pai = no;
+    filho->pai = no->pai;
+    if (no->pai == NULL)
+        raiz = filho;
+    else if (no == no->pai->direita)
+        no->pai->direita = filho;
+    else
+        no->pai->esquerda = filho;
+    filho->direita = no;
+    no->pai = filho;
+    return raiz;
+}
+
+// Inserção iterativa (Cormen): desce como na BST, pendura um nó vermelho e sobe recolorindo e
+// rotacionando enquanto houver dois vermelhos seguidos. Retorna 0, ou -1 se faltou memória.
+int inserir_rb(NoRB** raiz_arvore, int chave) {
+    NoRB* raiz = *raiz_arvore;
+    NoRB* pai = NULL;
+    NoRB* atual = raiz;
+
+    while (atual != NULL) {
+        if (chave == atual->chave)
+            return 0; // chave repetida
+        pai = atual;
+        atual = (chave < atual->chave) ? atual->esquerda : atual->direita;
+    }
+
+    NoRB* no = (NoRB*)malloc(sizeof(NoRB));
+    if (no == NULL)
+        return -1;
+    no->chave = chave;
+    no->cor = RB_VERMELHO;
+    no->esquerda = no->direita = NULL;
+    no->pai = pai;
+
+    if (pai == NULL)
+        raiz = no;
+    else if (chave < pai->chave)
+        pai->esquerda = no;
+    else
+        pai->direita = no;
+
+    while (no->pai != NULL && no->pai->cor == RB_VERMELHO) {
+        NoRB* avo = no->pai->pai; // existe: a raiz é sempre preta
+        if (no->pai == avo->esquerda) {
+            NoRB* tio = avo->direita;
+            if (tio != NULL && tio->cor == RB_VERMELHO) {
+                // Tio vermelho: só recolore e continua a partir do avô.
+                no->pai->cor = RB_PRETO;
+                tio->cor = RB_PRETO;
+                avo->cor = RB_VERMELHO;
+                no = avo;
+            } else {
+                // Tio preto: no máximo duas rotações e termina.
+                if (no == no->pai->direita) {
+                    no = no->pai;
+                    raiz = rotacionar_esquerda_rb(raiz, no);
+                }
+                no->pai->cor = RB_PRETO;
+                avo->cor = RB_VERMELHO;
+                raiz = rotacionar_direita_rb(raiz, avo);
+            }
+        } else {
+            // Simétrico, com o pai à direita do avô.
+            NoRB* tio = avo->esquerda;
+            if (tio != NULL && tio->cor == RB_VERMELHO) {
+                no->pai->cor = RB_PRETO;
+                tio->cor = RB_PRETO;
+                avo->cor = RB_VERMELHO;
+                no = avo;
+            } else {
+                if (no == no->pai->esquerda) {
+                    no = no->pai;
+                    raiz = rotacionar_direita_rb(raiz, no);
+                }
+                no->pai->cor = RB_PRETO;
+                avo->cor = RB_VERMELHO;
+                raiz = rotacionar_esquerda_rb(raiz, avo);
+            }
+        }
+    }
+
+    raiz->cor = RB_PRETO;
+    *raiz_arvore = raiz;
+    return 0;
+}
+
+int buscar_rb(const NoRB* no, int chave) {
+    int comparacoes = 0;
+    while (no != NULL) {
+        comparacoes++;
+        if (chave == no->chave)
+            return comparacoes;
+        no = (chave < no->chave) ? no->esquerda : no->direita;
+    }
+    return comparacoes;
+}
+
+// Busca em lote, como buscar_arvore_lote de contagem.c.
+DEFINIR_BUSCA_LOTE(buscar_rb_lote, const NoRB*, const NoRB*, NULL, RAIZ_PONTEIRO, NO_PONTEIRO)
+
+// Altura no máximo 2 log2(n + 1): recursão rasa.
+void liberar_rb(NoRB* no) {
+    if (no == NULL) return;
+    liberar_rb(no->esquerda);
+    liberar_rb(no->direita);
+    free(no);
+}
@@ -0,0 +1,123 @@
+// Gerador xoshiro256** e permutação de chaves de 31 bits (ver chaves.h).
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "chaves.h"
+
+// Todas as contas da permutação são feitas módulo 2^31.
+#define MASCARA_31 0x7FFFFFFFu
+#define RODADAS 3
+
+// splitmix64: espalha uma semente qualquer em valores de 64 bits bem misturados.
+static uint64_t splitmix64(uint64_t* estado) {
+    uint64_t z = (*estado += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static uint64_t rotacionar(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+void semear_gerador(GeradorAleatorio* g, uint64_t semente) {
+    for (int i = 0; i < 4; i++)
+        g->s[i] = splitmix64(&semente);
+}
+
+uint64_t proximo_aleatorio(GeradorAleatorio* g) {
+    uint64_t* s = g->s;
+    uint64_t resultado = rotacionar(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotacionar(s[3], 45);
+    return resultado;
+}
+
+// Multiplica 32 bits aleatórios pelo limite e fica com a parte alta (método de Lemire); o viés
+// que sobra é menor que limite / 2^32, desprezível para as buscas.
+uint32_t sortear_ate(GeradorAleatorio* g, uint32_t limite) {
+    return (uint32_t)(((proximo_aleatorio(g) >> 32) * (uint64_t)limite) >> 32);
+}
+
+double sortear_real(GeradorAleatorio* g) {
+    return (double)((proximo_aleatorio(g) >> 11) + 1) * 0x1.0p-53;
+}
+
+// Chaves das rodadas da permutação, tiradas da semente.
+static void chaves_rodadas(uint64_t semente, uint32_t rodadas[RODADAS]) {
+    for (int r = 0; r < RODADAS; r++)
+        rodadas[r] = (uint32_t)splitmix64(&semente);
+}
+
+// Cada passo tem inversa módulo 2^31 (somar, multiplicar por ímpar e x ^= x >> k), então a
+// composição é uma bijeção de [0, 2^31) nele mesmo; três rodadas bastam para que índices vizinhos
+// virem chaves sem relação aparente.
+static int permutar(uint32_t x, const uint32_t rodadas[RODADAS]) {
+    for (int r = 0; r < RODADAS; r++) {
+        x = (x + rodadas[r]) & MASCARA_31;
+        x = (x * 0x2c1b3c6du) & MASCARA_31; // multiplicadores ímpares
+        x ^= x >> 15;
+        x = (x * 0x297a2d39u) & MASCARA_31;
+        x ^= x >> 12;
+    }
+    return (int)x;
+}
+
+int chave_permutada(uint32_t i, uint64_t semente) {
+    uint32_t rodadas[RODADAS];
+    chaves_rodadas(semente, rodadas);
+    return permutar(i & MASCARA_31, rodadas);
+}
+
+void gerar_chaves_unicas(int* valores, uint32_t n, uint64_t semente) {
+    uint32_t rodadas[RODADAS];
+    chaves_rodadas(semente, rodadas);
+    for (uint32_t i = 0; i < n; i++)
+        valores[i] = permutar(i, rodadas);
+}
+
+// ==================== Ordem de inserção =======================
+
+// Compara dois inteiros para o qsort (ordem crescente).
+static int comparar_crescente(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+const char* nomes_ordens[QUANT_ORDENS] = {"aleatoria", "crescente", "decrescente", "zipf"};
+
+// Reorganiza o vetor de chaves na ordem pedida.
+void ordenar_chaves(int* valores, int n, int ordem, GeradorAleatorio* gerador) {
+    if (ordem == ORDEM_ALEATORIA)
+        return;
+
+    qsort(valores, n, sizeof(int), comparar_crescente);
+
+    if (ordem == ORDEM_DECRESCENTE) {
+        // Inverte o vetor ordenado.
+        for (int i = 0, j = n - 1; i < j; i++, j--) {
+            int tmp = valores[i];
+            valores[i] = valores[j];
+            valores[j] = tmp;
+        }
+    } else if (ordem == ORDEM_ZIPF) {
+        // Troca cada chave com a que está d posições à frente, onde P(d >= k) = 1/(k + 1):
+        // metade das chaves fica no lugar, poucas vão longe (Zipf com expoente 2).
+        for (int i = 0; i < n; i++) {
+            double u = sortear_real(gerador); // uniforme em (0, 1]
+            long long d = (long long)(1.0 / u) - 1;
+            if (d > 0 && i + d < n) {
+                int tmp = valores[i];
+                valores[i] = valores[i + d];
+                valores[i + d] = tmp;
+            }
+        }
+    }
+}
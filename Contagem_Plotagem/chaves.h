@@ -0,0 +1,47 @@
+#ifndef CHAVES_H_INCLUDED
+#define CHAVES_H_INCLUDED
+
+#include <stdint.h>
+
+// Geração de chaves para os testes de busca, no lugar de rand():
+// - xoshiro256** dá 64 bits por chamada, com período 2^256 - 1, e a mesma semente sempre
+//   reproduz a mesma execução;
+// - as chaves únicas saem de uma permutação dos inteiros de 31 bits, então não é preciso
+//   procurar repetidas: gerar n chaves custa O(n).
+
+// Estado do xoshiro256**.
+typedef struct {
+    uint64_t s[4];
+} GeradorAleatorio;
+
+// Semeia o gerador expandindo a semente com o splitmix64 (qualquer semente serve, até 0).
+void semear_gerador(GeradorAleatorio* g, uint64_t semente);
+uint64_t proximo_aleatorio(GeradorAleatorio* g);
+// Inteiro uniforme em [0, limite), sem o viés do "% limite".
+uint32_t sortear_ate(GeradorAleatorio* g, uint32_t limite);
+// Real uniforme em (0, 1].
+double sortear_real(GeradorAleatorio* g);
+
+// Maior quantidade de chaves únicas: todos os inteiros não negativos de 31 bits.
+#define CHAVES_MAXIMO 0x80000000u
+
+// i-ésima chave da permutação definida pela semente: i diferentes dão chaves diferentes, todas em
+// [0, 2^31). Índices a partir de n dão chaves que com certeza não estão entre as n primeiras.
+int chave_permutada(uint32_t i, uint64_t semente);
+// Preenche valores[0..n) com as n primeiras chaves da permutação.
+void gerar_chaves_unicas(int* valores, uint32_t n, uint64_t semente);
+
+// ==================== Ordem de inserção =======================
+
+// Ordens de inserção das chaves.
+#define ORDEM_ALEATORIA 0   // como foram geradas
+#define ORDEM_CRESCENTE 1   // a BST vira uma lista
+#define ORDEM_DECRESCENTE 2
+#define ORDEM_ZIPF 3        // quase ordenada: cada chave sai do lugar por uma distância com distribuição de Zipf
+#define QUANT_ORDENS 4
+extern const char* nomes_ordens[QUANT_ORDENS];
+
+// Reorganiza o vetor de chaves na ordem pedida (o gerador só é usado pela ordem zipf).
+void ordenar_chaves(int* valores, int n, int ordem, GeradorAleatorio* gerador);
+
+#endif // CHAVES_H_INCLUDED
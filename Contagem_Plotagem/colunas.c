@@ -0,0 +1,283 @@
+// Escrita e leitura do formato binário em colunas (ver colunas.h).
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "colunas.h"
+#include "../Huffman/Huffman/headers/huffman.h"
+
+// Pior caso de uma coluna de um grupo: 10 bytes por valor (varint de 64 bits).
+#define MAXIMO_VARINTS ((size_t)GRUPO_LINHAS * 10)
+
+// Leva inteiros com sinal para sem sinal de forma que valores pequenos (positivos ou negativos)
+// continuem pequenos: 0, -1, 1, -2, 2... viram 0, 1, 2, 3, 4...
+static uint64_t zigzag(int64_t valor) {
+    return ((uint64_t)valor << 1) ^ (uint64_t)(valor >> 63);
+}
+
+static int64_t desfazer_zigzag(uint64_t valor) {
+    return (int64_t)(valor >> 1) ^ -(int64_t)(valor & 1);
+}
+
+// Tamanho em bytes de um varint: 7 bits de dados por byte.
+static size_t tamanho_varint(uint64_t valor) {
+    size_t tamanho = 1;
+    while (valor >= 0x80) {
+        valor >>= 7;
+        tamanho++;
+    }
+    return tamanho;
+}
+
+// Grava um varint e retorna quantos bytes ocupou. O bit mais alto de cada byte diz se há mais bytes.
+static size_t escrever_varint(unsigned char* destino, uint64_t valor) {
+    size_t pos = 0;
+    while (valor >= 0x80) {
+        destino[pos++] = (unsigned char)(valor | 0x80);
+        valor >>= 7;
+    }
+    destino[pos++] = (unsigned char)valor;
+    return pos;
+}
+
+// ==================== Escritor =======================
+
+int abrir_escritor_colunas(EscritorColunas* e, const char* caminho, int quant_colunas, const char* nomes[]) {
+    memset(e, 0, sizeof(EscritorColunas));
+
+    if (quant_colunas < 1 || quant_colunas > COLUNAS_MAXIMO)
+        return -1;
+
+    e->arquivo = fopen(caminho, "wb");
+    e->quant_colunas = quant_colunas;
+    e->valores = (int64_t*)malloc((size_t)quant_colunas * GRUPO_LINHAS * sizeof(int64_t));
+    e->varints = (unsigned char*)malloc(MAXIMO_VARINTS);
+
+    // O compactador nunca passa do próprio limite, então o rascunho é alocado uma vez só.
+    HUFF_CONTEXTO ctx;
+    huff_inicializar_contexto(&ctx);
+    e->compactado = (unsigned char*)malloc(huff_limite_compactado(&ctx, MAXIMO_VARINTS));
+
+    if (e->arquivo == NULL || e->valores == NULL || e->varints == NULL || e->compactado == NULL) {
+        if (e->arquivo != NULL)
+            fclose(e->arquivo);
+        free(e->valores);
+        free(e->varints);
+        free(e->compactado);
+        return -1;
+    }
+
+    // Buffer grande: cada grupo vira poucas chamadas de escrita ao sistema.
+    setvbuf(e->arquivo, NULL, _IOFBF, 1 << 20);
+
+    // Cabeçalho: mágico, versão, número de colunas e os nomes.
+    unsigned char cabecalho[6];
+    memcpy(cabecalho, COLUNAS_MAGICO, 4);
+    cabecalho[4] = COLUNAS_VERSAO;
+    cabecalho[5] = (unsigned char)quant_colunas;
+    fwrite(cabecalho, 1, sizeof(cabecalho), e->arquivo);
+
+    for (int c = 0; c < quant_colunas; c++) {
+        size_t tamanho = strlen(nomes[c]);
+        if (tamanho >= COLUNAS_NOME)
+            tamanho = COLUNAS_NOME - 1;
+        fwrite(nomes[c], 1, tamanho, e->arquivo);
+        fputc('\0', e->arquivo);
+    }
+
+    e->bytes_gravados = sizeof(cabecalho);
+    return ferror(e->arquivo) ? -1 : 0;
+}
+
+// Codifica e grava o grupo atual, coluna por coluna.
+static int gravar_grupo(EscritorColunas* e) {
+    unsigned char numero[4];
+    HUFF_CONTEXTO ctx;
+
+    huff_inicializar_contexto(&ctx);
+
+    escrever_u32(numero, (uint32_t)e->linhas);
+    fwrite(numero, 1, 4, e->arquivo);
+    e->bytes_gravados += 4;
+
+    for (int c = 0; c < e->quant_colunas; c++) {
+        int64_t* coluna = e->valores + (size_t)c * GRUPO_LINHAS;
+
+        // Decide entre valores e diferenças pelo tamanho total dos varints.
+        size_t tam_valores = 0, tam_delta = 0;
+        int64_t anterior = 0;
+        for (int i = 0; i < e->linhas; i++) {
+            tam_valores += tamanho_varint(zigzag(coluna[i]));
+            tam_delta += tamanho_varint(zigzag((int64_t)((uint64_t)coluna[i] - (uint64_t)anterior)));
+            anterior = coluna[i];
+        }
+
+        int codificacao = (tam_delta < tam_valores) ? COLUNA_DELTA : COLUNA_VALORES;
+        size_t tam_varints = 0;
+        anterior = 0;
+        for (int i = 0; i < e->linhas; i++) {
+            int64_t valor = coluna[i];
+            if (codificacao == COLUNA_DELTA)
+                valor = (int64_t)((uint64_t)coluna[i] - (uint64_t)anterior);
+            tam_varints += escrever_varint(e->varints + tam_varints, zigzag(valor));
+            anterior = coluna[i];
+        }
+
+        // Os varints passam pelo compactador de Huffman do projeto.
+        size_t tam_compactado;
+        size_t capacidade = huff_limite_compactado(&ctx, MAXIMO_VARINTS);
+        if (huff_compactar_buffer(&ctx, e->varints, tam_varints, e->compactado, capacidade, &tam_compactado) != HUFF_OK)
+            return -1;
+
+        unsigned char cabecalho[5];
+        cabecalho[0] = (unsigned char)codificacao;
+        escrever_u32(cabecalho + 1, (uint32_t)tam_compactado);
+        fwrite(cabecalho, 1, 5, e->arquivo);
+        fwrite(e->compactado, 1, tam_compactado, e->arquivo);
+        e->bytes_gravados += 5 + tam_compactado;
+    }
+
+    e->linhas = 0;
+    return ferror(e->arquivo) ? -1 : 0;
+}
+
+int escrever_linha(EscritorColunas* e, const int64_t valores[]) {
+    // Cada valor vai para a sua coluna; o grupo só é gravado quando enche.
+    for (int c = 0; c < e->quant_colunas; c++)
+        e->valores[(size_t)c * GRUPO_LINHAS + e->linhas] = valores[c];
+    e->linhas++;
+
+    if (e->linhas == GRUPO_LINHAS)
+        return gravar_grupo(e);
+    return 0;
+}
+
+int fechar_escritor_colunas(EscritorColunas* e) {
+    int erro = 0;
+
+    if (e->linhas > 0 && gravar_grupo(e) != 0)
+        erro = -1;
+    if (fclose(e->arquivo) != 0)
+        erro = -1;
+
+    free(e->valores);
+    free(e->varints);
+    free(e->compactado);
+    return erro;
+}
+
+// ==================== Leitor =======================
+
+int abrir_leitor_colunas(LeitorColunas* l, const char* caminho) {
+    unsigned char cabecalho[6];
+
+    memset(l, 0, sizeof(LeitorColunas));
+    l->arquivo = fopen(caminho, "rb");
+    if (l->arquivo == NULL)
+        return -1;
+
+    if (fread(cabecalho, 1, 6, l->arquivo) != 6 || memcmp(cabecalho, COLUNAS_MAGICO, 4) != 0 ||
+        cabecalho[4] != COLUNAS_VERSAO || cabecalho[5] < 1 || cabecalho[5] > COLUNAS_MAXIMO) {
+        fclose(l->arquivo);
+        return -1;
+    }
+
+    l->quant_colunas = cabecalho[5];
+
+    // Nomes terminados em '\0'.
+    for (int c = 0; c < l->quant_colunas; c++) {
+        int tamanho = 0, ch;
+        while ((ch = fgetc(l->arquivo)) != EOF && ch != '\0') {
+            if (tamanho < COLUNAS_NOME - 1)
+                l->nomes[c][tamanho++] = (char)ch;
+        }
+        l->nomes[c][tamanho] = '\0';
+        if (ch == EOF) {
+            fclose(l->arquivo);
+            return -1;
+        }
+    }
+
+    l->valores = (int64_t*)malloc((size_t)l->quant_colunas * GRUPO_LINHAS * sizeof(int64_t));
+    l->varints = (unsigned char*)malloc(MAXIMO_VARINTS);
+    if (l->valores == NULL || l->varints == NULL) {
+        fechar_leitor_colunas(l);
+        return -1;
+    }
+    return 0;
+}
+
+int ler_grupo(LeitorColunas* l) {
+    unsigned char numero[4];
+    HUFF_CONTEXTO ctx;
+
+    huff_inicializar_contexto(&ctx);
+
+    size_t lidos = fread(numero, 1, 4, l->arquivo);
+    if (lidos == 0 && feof(l->arquivo))
+        return 0; // fim do arquivo
+    if (lidos != 4)
+        return -1;
+
+    l->linhas = (int)ler_u32(numero);
+    if (l->linhas < 1 || l->linhas > GRUPO_LINHAS)
+        return -1;
+
+    for (int c = 0; c < l->quant_colunas; c++) {
+        unsigned char cabecalho[5];
+        if (fread(cabecalho, 1, 5, l->arquivo) != 5 || cabecalho[0] > COLUNA_DELTA)
+            return -1;
+
+        size_t tam_compactado = ler_u32(cabecalho + 1);
+        if (tam_compactado > l->capacidade_compactado) {
+            unsigned char* maior = (unsigned char*)realloc(l->compactado, tam_compactado);
+            if (maior == NULL)
+                return -1;
+            l->compactado = maior;
+            l->capacidade_compactado = tam_compactado;
+        }
+        if (fread(l->compactado, 1, tam_compactado, l->arquivo) != tam_compactado)
+            return -1;
+
+        size_t tam_varints;
+        if (huff_descompactar_buffer(&ctx, l->compactado, tam_compactado, l->varints, MAXIMO_VARINTS, &tam_varints) != HUFF_OK)
+            return -1;
+
+        // Varints de volta para inteiros; a coluna precisa ter exatamente l->linhas valores.
+        int64_t* coluna = l->valores + (size_t)c * GRUPO_LINHAS;
+        int64_t anterior = 0;
+        size_t pos = 0;
+        for (int i = 0; i < l->linhas; i++) {
+            uint64_t valor = 0;
+            int deslocamento = 0;
+            do {
+                if (pos >= tam_varints || deslocamento > 63)
+                    return -1;
+                valor |= (uint64_t)(l->varints[pos] & 0x7F) << deslocamento;
+                deslocamento += 7;
+            } while (l->varints[pos++] & 0x80);
+
+            coluna[i] = desfazer_zigzag(valor);
+            if (cabecalho[0] == COLUNA_DELTA)
+                coluna[i] = (int64_t)((uint64_t)coluna[i] + (uint64_t)anterior);
+            anterior = coluna[i];
+        }
+        if (pos != tam_varints)
+            return -1;
+    }
+
+    return l->linhas;
+}
+
+void fechar_leitor_colunas(LeitorColunas* l) {
+    if (l->arquivo != NULL)
+        fclose(l->arquivo);
+    free(l->valores);
+    free(l->varints);
+    free(l->compactado);
+    l->arquivo = NULL;
+    l->valores = NULL;
+    l->varints = NULL;
+    l->compactado = NULL;
+}
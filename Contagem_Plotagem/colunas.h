@@ -0,0 +1,58 @@
+#ifndef COLUNAS_H_INCLUDED
+#define COLUNAS_H_INCLUDED
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Formato binário em colunas para os resultados das buscas.
+//
+// Arquivo: "CBUS" + versão (1 byte) + número de colunas (1 byte) + nomes das colunas terminados em '\0'.
+// Depois vêm grupos de até GRUPO_LINHAS linhas: número de linhas (4 bytes) e, para cada coluna,
+// a codificação (1 byte), o tamanho do conteúdo (4 bytes) e o conteúdo.
+//
+// Cada coluna de um grupo vira uma sequência de varints (zigzag, 7 bits por byte), dos próprios
+// valores ou das diferenças entre valores vizinhos (o que ficar menor), e essa sequência passa
+// pelo compactador de Huffman do projeto (huff_compactar_buffer).
+
+#define COLUNAS_MAGICO "CBUS"
+#define COLUNAS_VERSAO 1
+#define COLUNAS_MAXIMO 16 // colunas por arquivo
+#define COLUNAS_NOME 64 // tamanho máximo do nome de uma coluna, com o '\0'
+#define GRUPO_LINHAS 65536 // linhas guardadas na memória antes de gravar um grupo
+
+#define COLUNA_VALORES 0 // varints dos valores
+#define COLUNA_DELTA 1 // varints das diferenças (o primeiro valor é a diferença para 0)
+
+// Guarda as linhas em memória, coluna por coluna, e grava um grupo inteiro de uma vez.
+typedef struct {
+    FILE* arquivo;
+    int quant_colunas;
+    int linhas; // linhas no grupo atual
+    int64_t* valores; // quant_colunas * GRUPO_LINHAS, uma coluna depois da outra
+    unsigned char* varints; // rascunho de uma coluna em varints
+    unsigned char* compactado; // rascunho de uma coluna compactada
+    uint64_t bytes_gravados;
+} EscritorColunas;
+
+// Lê o arquivo um grupo por vez.
+typedef struct {
+    FILE* arquivo;
+    int quant_colunas;
+    char nomes[COLUNAS_MAXIMO][COLUNAS_NOME];
+    int linhas; // linhas do último grupo lido
+    int64_t* valores; // mesmo arranjo do escritor
+    unsigned char* varints;
+    unsigned char* compactado;
+    size_t capacidade_compactado;
+} LeitorColunas;
+
+// Retornam 0 em caso de sucesso e -1 em caso de erro.
+int abrir_escritor_colunas(EscritorColunas* e, const char* caminho, int quant_colunas, const char* nomes[]);
+int escrever_linha(EscritorColunas* e, const int64_t valores[]);
+int fechar_escritor_colunas(EscritorColunas* e); // grava o último grupo e fecha o arquivo
+
+int abrir_leitor_colunas(LeitorColunas* l, const char* caminho);
+int ler_grupo(LeitorColunas* l); // linhas lidas, 0 no fim do arquivo, -1 em caso de erro
+void fechar_leitor_colunas(LeitorColunas* l);
+
+#endif // COLUNAS_H_INCLUDED
@@ -0,0 +1,389 @@
+// Skip list sem travas e BST com travas por nó (ver estruturas.h), para a carga mista de mistura.c.
+// As operações atômicas usam a ordem sequencial padrão do C11: no x86 as leituras saem como
+// leituras comuns e cada compare-and-swap já é uma barreira completa.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include <pthread.h>
+
+#include "estruturas.h"
+
+// ==================== Skip list sem travas =======================
+
+// Com 24 níveis a busca continua logarítmica até cerca de 2^24 chaves; a altura média dos nós é 2.
+#define SKIP_NIVEIS 24
+// Bit baixo de uma ligação: o nó dono dela foi removido (os nós são alinhados, o bit é livre).
+#define MARCA ((uintptr_t)1)
+
+struct NoSkip {
+    int chave;
+    int altura;
+    struct NoSkip* proximo_retirado; // pilha dos removidos
+    _Atomic(uintptr_t) proximos[];   // um por nível: endereço do próximo | MARCA
+};
+
+static NoSkip* no_da_ligacao(uintptr_t ligacao) {
+    return (NoSkip*)(ligacao & ~MARCA);
+}
+
+static int marcada(uintptr_t ligacao) {
+    return (int)(ligacao & MARCA);
+}
+
+static NoSkip* novo_no_skip(int chave, int altura) {
+    NoSkip* no = (NoSkip*)malloc(sizeof(NoSkip) + (size_t)altura * sizeof(_Atomic(uintptr_t)));
+    if (no == NULL)
+        return NULL;
+    no->chave = chave;
+    no->altura = altura;
+    no->proximo_retirado = NULL;
+    for (int i = 0; i < altura; i++)
+        atomic_init(&no->proximos[i], (uintptr_t)0);
+    return no;
+}
+
+int iniciar_skiplist(SkipList* l) {
+    l->cabeca = novo_no_skip(INT_MIN, SKIP_NIVEIS);
+    atomic_init(&l->retirados, NULL);
+    return (l->cabeca != NULL) ? 0 : -1;
+}
+
+// Desce da cabeça até o nível 0 guardando, em cada nível, o último nó com chave menor (preds) e o
+// seguinte (succs). Nós marcados no caminho são desligados; se o desligamento falha (o predecessor
+// mudou ou também foi marcado), recomeça do topo. Retorna 1 se succs[0] tem a chave.
+static int localizar(SkipList* l, int chave, NoSkip** preds, NoSkip** succs, int* comparacoes) {
+    for (;;) {
+        NoSkip* pred = l->cabeca;
+        NoSkip* atual = NULL;
+        int recomecar = 0;
+
+        for (int nivel = SKIP_NIVEIS - 1; nivel >= 0 && !recomecar; nivel--) {
+            atual = no_da_ligacao(atomic_load(&pred->proximos[nivel]));
+            while (atual != NULL) {
+                uintptr_t seguinte = atomic_load(&atual->proximos[nivel]);
+                if (marcada(seguinte)) {
+                    uintptr_t esperado = (uintptr_t)atual;
+                    if (!atomic_compare_exchange_strong(&pred->proximos[nivel], &esperado, seguinte & ~MARCA)) {
+                        recomecar = 1;
+                        break;
+                    }
+                    atual = no_da_ligacao(seguinte);
+                    continue;
+                }
+                (*comparacoes)++;
+                if (atual->chave >= chave)
+                    break;
+                pred = atual;
+                atual = no_da_ligacao(seguinte);
+            }
+            preds[nivel] = pred;
+            succs[nivel] = atual;
+        }
+        if (!recomecar)
+            return atual != NULL && atual->chave == chave;
+    }
+}
+
+// O nó entra primeiro no nível 0, que é o que vale para dizer se a chave está no conjunto; os
+// níveis de cima são atalhos ligados depois, um a um.
+int inserir_skiplist(SkipList* l, int chave, uint64_t aleatorio, int* comparacoes) {
+    NoSkip* preds[SKIP_NIVEIS];
+    NoSkip* succs[SKIP_NIVEIS];
+    NoSkip* novo = NULL;
+    int altura = 1;
+
+    while (altura < SKIP_NIVEIS && (aleatorio & 1)) {
+        altura++;
+        aleatorio >>= 1;
+    }
+
+    for (;;) {
+        if (localizar(l, chave, preds, succs, comparacoes)) {
+            free(novo); // nunca foi visto por outra thread
+            return 0;
+        }
+        if (novo == NULL && (novo = novo_no_skip(chave, altura)) == NULL)
+            return -1;
+        for (int nivel = 0; nivel < altura; nivel++)
+            atomic_store(&novo->proximos[nivel], (uintptr_t)succs[nivel]);
+        uintptr_t esperado = (uintptr_t)succs[0];
+        if (atomic_compare_exchange_strong(&preds[0]->proximos[0], &esperado, (uintptr_t)novo))
+            break;
+    }
+
+    for (int nivel = 1; nivel < altura; nivel++) {
+        for (;;) {
+            // Se o nó já foi marcado por uma remoção, não adianta ligá-lo mais alto.
+            uintptr_t proximo = atomic_load(&novo->proximos[nivel]);
+            if (marcada(proximo))
+                return 1;
+            if (no_da_ligacao(proximo) != succs[nivel] &&
+                !atomic_compare_exchange_strong(&novo->proximos[nivel], &proximo, (uintptr_t)succs[nivel]))
+                continue;
+            uintptr_t esperado = (uintptr_t)succs[nivel];
+            if (atomic_compare_exchange_strong(&preds[nivel]->proximos[nivel], &esperado, (uintptr_t)novo))
+                break;
+            // O vizinho mudou: procura de novo. Se o nó saiu do nível 0, foi removido.
+            if (!localizar(l, chave, preds, succs, comparacoes) || succs[0] != novo)
+                return 1;
+        }
+    }
+    return 1;
+}
+
+// Marca os níveis de cima para baixo; quem marca o nível 0 é quem removeu a chave.
+int remover_skiplist(SkipList* l, int chave, int* comparacoes) {
+    NoSkip* preds[SKIP_NIVEIS];
+    NoSkip* succs[SKIP_NIVEIS];
+
+    if (!localizar(l, chave, preds, succs, comparacoes))
+        return 0;
+    NoSkip* vitima = succs[0];
+
+    for (int nivel = vitima->altura - 1; nivel >= 1; nivel--) {
+        uintptr_t proximo = atomic_load(&vitima->proximos[nivel]);
+        while (!marcada(proximo))
+            atomic_compare_exchange_weak(&vitima->proximos[nivel], &proximo, proximo | MARCA);
+    }
+
+    uintptr_t proximo = atomic_load(&vitima->proximos[0]);
+    for (;;) {
+        if (marcada(proximo))
+            return 0; // outra thread removeu primeiro
+        if (atomic_compare_exchange_strong(&vitima->proximos[0], &proximo, proximo | MARCA))
+            break;
+    }
+
+    // Desliga o nó de todos os níveis e o guarda para liberar no fim. Essa segunda passada é
+    // limpeza, não parte da busca, então suas comparações não entram na contagem da remoção.
+    int descartadas = 0;
+    localizar(l, chave, preds, succs, &descartadas);
+    NoSkip* topo = atomic_load(&l->retirados);
+    do {
+        vitima->proximo_retirado = topo;
+    } while (!atomic_compare_exchange_weak(&l->retirados, &topo, vitima));
+    return 1;
+}
+
+// Como localizar, mas sem desligar nada: os nós marcados são só pulados, e nenhuma escrita é feita.
+int buscar_skiplist(const SkipList* l, int chave) {
+    int comparacoes = 0;
+    NoSkip* pred = l->cabeca;
+
+    for (int nivel = SKIP_NIVEIS - 1; nivel >= 0; nivel--) {
+        NoSkip* atual = no_da_ligacao(atomic_load(&pred->proximos[nivel]));
+        while (atual != NULL) {
+            uintptr_t seguinte = atomic_load(&atual->proximos[nivel]);
+            if (marcada(seguinte)) {
+                atual = no_da_ligacao(seguinte);
+                continue;
+            }
+            comparacoes++;
+            if (atual->chave == chave)
+                return comparacoes;
+            if (atual->chave > chave)
+                break;
+            pred = atual;
+            atual = no_da_ligacao(seguinte);
+        }
+    }
+    return comparacoes;
+}
+
+long long contar_skiplist(const SkipList* l) {
+    long long quant = 0;
+    for (NoSkip* no = no_da_ligacao(atomic_load(&l->cabeca->proximos[0])); no != NULL;) {
+        uintptr_t seguinte = atomic_load(&no->proximos[0]);
+        quant += !marcada(seguinte);
+        no = no_da_ligacao(seguinte);
+    }
+    return quant;
+}
+
+// Os nós marcados ainda podem estar ligados no nível 0 (uma inserção pode ter ligado um nó novo a
+// um vizinho marcado logo depois de lê-lo), mas são liberados pela pilha dos removidos.
+void liberar_skiplist(SkipList* l) {
+    if (l->cabeca == NULL)
+        return;
+    NoSkip* no = no_da_ligacao(atomic_load(&l->cabeca->proximos[0]));
+    while (no != NULL) {
+        uintptr_t seguinte = atomic_load(&no->proximos[0]);
+        if (!marcada(seguinte))
+            free(no);
+        no = no_da_ligacao(seguinte);
+    }
+    for (NoSkip* r = atomic_load(&l->retirados); r != NULL;) {
+        NoSkip* proximo = r->proximo_retirado;
+        free(r);
+        r = proximo;
+    }
+    free(l->cabeca);
+    l->cabeca = NULL;
+    atomic_store(&l->retirados, NULL);
+}
+
+// ==================== BST com travas por nó =======================
+
+struct NoTravado {
+    int chave;
+    struct NoTravado* esquerda;
+    struct NoTravado* direita;
+    pthread_mutex_t trava;
+};
+
+static NoTravado* novo_no_travado(int chave) {
+    NoTravado* no = (NoTravado*)malloc(sizeof(NoTravado));
+    if (no == NULL)
+        return NULL;
+    no->chave = chave;
+    no->esquerda = no->direita = NULL;
+    pthread_mutex_init(&no->trava, NULL);
+    return no;
+}
+
+static void liberar_no_travado(NoTravado* no) {
+    pthread_mutex_destroy(&no->trava);
+    free(no);
+}
+
+int iniciar_arvore_travada(ArvoreTravada* a) {
+    a->sentinela = novo_no_travado(0); // a chave da sentinela nunca é comparada
+    return (a->sentinela != NULL) ? 0 : -1;
+}
+
+int inserir_arvore_travada(ArvoreTravada* a, int chave, int* comparacoes) {
+    NoTravado* pai = a->sentinela;
+    pthread_mutex_lock(&pai->trava);
+    NoTravado** ligacao = &pai->esquerda;
+
+    while (*ligacao != NULL) {
+        NoTravado* no = *ligacao;
+        pthread_mutex_lock(&no->trava);
+        pthread_mutex_unlock(&pai->trava);
+        pai = no;
+        (*comparacoes)++;
+        if (chave == no->chave) {
+            pthread_mutex_unlock(&pai->trava);
+            return 0;
+        }
+        ligacao = (chave < no->chave) ? &no->esquerda : &no->direita;
+    }
+
+    NoTravado* novo = novo_no_travado(chave);
+    if (novo != NULL)
+        *ligacao = novo;
+    pthread_mutex_unlock(&pai->trava);
+    return (novo != NULL) ? 1 : -1;
+}
+
+// O nó removido e o pai ficam travados enquanto a árvore muda. Com dois filhos, o nó recebe a
+// chave do sucessor (o menor da subárvore direita), que é desligado no lugar dele; a descida até o
+// sucessor também é de mão em mão, com o nó removido travado o tempo todo. Um nó desligado pode
+// ser liberado na hora: para chegar a ele era preciso a trava do pai, que estava com quem o
+// desligou.
+int remover_arvore_travada(ArvoreTravada* a, int chave, int* comparacoes) {
+    NoTravado* pai = a->sentinela;
+    pthread_mutex_lock(&pai->trava);
+    NoTravado** ligacao = &pai->esquerda;
+    NoTravado* no = *ligacao;
+
+    while (no != NULL) {
+        pthread_mutex_lock(&no->trava);
+        (*comparacoes)++;
+        if (chave == no->chave)
+            break;
+        pthread_mutex_unlock(&pai->trava);
+        pai = no;
+        ligacao = (chave < no->chave) ? &no->esquerda : &no->direita;
+        no = *ligacao;
+    }
+    if (no == NULL) {
+        pthread_mutex_unlock(&pai->trava);
+        return 0;
+    }
+
+    if (no->esquerda == NULL || no->direita == NULL) {
+        *ligacao = (no->esquerda != NULL) ? no->esquerda : no->direita;
+        pthread_mutex_unlock(&no->trava);
+        pthread_mutex_unlock(&pai->trava);
+        liberar_no_travado(no);
+        return 1;
+    }
+
+    // Dois filhos: o pai não muda mais.
+    pthread_mutex_unlock(&pai->trava);
+    NoTravado* pai_sucessor = no;
+    NoTravado** ligacao_sucessor = &no->direita;
+    NoTravado* sucessor = no->direita;
+    pthread_mutex_lock(&sucessor->trava);
+    while (sucessor->esquerda != NULL) {
+        NoTravado* proximo = sucessor->esquerda;
+        pthread_mutex_lock(&proximo->trava);
+        if (pai_sucessor != no)
+            pthread_mutex_unlock(&pai_sucessor->trava);
+        pai_sucessor = sucessor;
+        ligacao_sucessor = &sucessor->esquerda;
+        sucessor = proximo;
+    }
+    no->chave = sucessor->chave;
+    *ligacao_sucessor = sucessor->direita;
+    pthread_mutex_unlock(&sucessor->trava);
+    if (pai_sucessor != no)
+        pthread_mutex_unlock(&pai_sucessor->trava);
+    pthread_mutex_unlock(&no->trava);
+    liberar_no_travado(sucessor);
+    return 1;
+}
+
+// Também de mão em mão: sem a trava, uma remoção poderia liberar o nó que a busca está lendo.
+int buscar_arvore_travada(const ArvoreTravada* a, int chave) {
+    int comparacoes = 0;
+    NoTravado* pai = a->sentinela;
+    pthread_mutex_lock(&pai->trava);
+    NoTravado* no = pai->esquerda;
+
+    while (no != NULL) {
+        pthread_mutex_lock(&no->trava);
+        pthread_mutex_unlock(&pai->trava);
+        pai = no;
+        comparacoes++;
+        if (chave == no->chave)
+            break;
+        no = (chave < no->chave) ? no->esquerda : no->direita;
+    }
+    pthread_mutex_unlock(&pai->trava);
+    return comparacoes;
+}
+
+// As chaves da carga mista são aleatórias, então a altura esperada é O(log n) e a recursão é rasa.
+static long long contar_nos_travados(const NoTravado* no) {
+    if (no == NULL)
+        return 0;
+    return 1 + contar_nos_travados(no->esquerda) + contar_nos_travados(no->direita);
+}
+
+long long contar_arvore_travada(const ArvoreTravada* a) {
+    return (a->sentinela != NULL) ? contar_nos_travados(a->sentinela->esquerda) : 0;
+}
+
+// Sem recursão, com as mesmas rotações de liberar_arvore.
+void liberar_arvore_travada(ArvoreTravada* a) {
+    if (a->sentinela == NULL)
+        return;
+    NoTravado* no = a->sentinela->esquerda;
+    while (no != NULL) {
+        if (no->esquerda != NULL) {
+            NoTravado* filho = no->esquerda;
+            no->esquerda = filho->direita;
+            filho->direita = no;
+            no = filho;
+        } else {
+            NoTravado* direita = no->direita;
+            liberar_no_travado(no);
+            no = direita;
+        }
+    }
+    liberar_no_travado(a->sentinela);
+    a->sentinela = NULL;
+}
@@ -1,7 +1,21 @@
 // Inclui bibliotecas padrão para entrada/saída, alocação de memória e manipulação de tempo.
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
 #include <time.h>
+#include <inttypes.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h> // na busca em lote da lista
+#endif
+
+// Formato binário em colunas, usado com a opção --binario.
+#include "colunas.h"
+// Árvores balanceadas comparadas com a lista e a BST.
+#include "estruturas.h"
+// Gerador xoshiro256** e chaves únicas por permutação.
+#include "chaves.h"
 
 // Define a estrutura para um nó da lista encadeada.
 // Cada nó contém uma chave (valor inteiro) e um ponteiro para o próximo nó.
@@ -25,9 +39,10 @@ NoLista* inserir_lista(NoLista* cabeca, int chave) {
 
 // Busca uma chave na lista encadeada.
 // Retorna o número de comparações realizadas até encontrar a chave ou percorrer toda a lista.
-int buscar_lista(NoLista* cabeca, int chave) {
+// Só lê a lista (o contador é local), então várias threads podem buscar nela ao mesmo tempo.
+int buscar_lista(const NoLista* cabeca, int chave) {
     int comparacoes = 0; // Inicializa o contador de comparações.
-    NoLista* atual = cabeca; // Começa a busca a partir da cabeça.
+    const NoLista* atual = cabeca; // Começa a busca a partir da cabeça.
     // Percorre a lista enquanto o nó atual não for nulo.
     while (atual) {
         comparacoes++; // Incrementa o contador a cada nó visitado.
@@ -41,6 +56,51 @@ int buscar_lista(NoLista* cabeca, int chave) {
     return comparacoes;
 }
 
+// Máscara com um bit para cada chave do lote igual a 'chave'. Com SSE2 são quatro comparações
+// por instrução.
+static unsigned chaves_iguais(const int* lote, int chave) {
+#ifdef __SSE2__
+    __m128i x = _mm_set1_epi32(chave);
+    unsigned iguais = 0;
+    for (int g = 0; g < LOTE_BUSCAS / 4; g++) {
+        __m128i grupo = _mm_loadu_si128((const __m128i*)(lote + 4 * g));
+        iguais |= (unsigned)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(grupo, x))) << (4 * g);
+    }
+    return iguais;
+#else
+    unsigned iguais = 0;
+    for (int j = 0; j < LOTE_BUSCAS; j++)
+        iguais |= (unsigned)(lote[j] == chave) << j;
+    return iguais;
+#endif
+}
+
+// Busca em lote na lista: as chaves são procuradas LOTE_BUSCAS de cada vez numa só passada pela
+// lista, comparando cada nó com todas as chaves do lote ao mesmo tempo (chaves_iguais). Cada nó
+// sai da memória uma vez por lote, e não uma vez por busca. As comparações de cada busca são as
+// mesmas de buscar_lista (o número de nós até a chave), guardadas em comparacoes[i].
+void buscar_lista_lote(const NoLista* cabeca, const int* chaves, int n, int* comparacoes) {
+    for (int inicio = 0; inicio < n; inicio += LOTE_BUSCAS) {
+        int quant = (n - inicio < LOTE_BUSCAS) ? n - inicio : LOTE_BUSCAS;
+        int lote[LOTE_BUSCAS];
+        unsigned pendentes = (1u << quant) - 1; // bit j: a chave j do lote ainda não foi achada
+        int visitados = 0;
+
+        for (int j = 0; j < LOTE_BUSCAS; j++)
+            lote[j] = chaves[inicio + (j < quant ? j : 0)]; // posições sobrando repetem a primeira
+        for (const NoLista* no = cabeca; no != NULL && pendentes != 0; no = no->proximo) {
+            unsigned iguais = chaves_iguais(lote, no->chave) & pendentes;
+            visitados++;
+            pendentes &= ~iguais;
+            for (; iguais != 0; iguais &= iguais - 1)
+                comparacoes[inicio + __builtin_ctz(iguais)] = visitados;
+        }
+        // As que sobraram não estão na lista: percorreram todos os nós.
+        for (; pendentes != 0; pendentes &= pendentes - 1)
+            comparacoes[inicio + __builtin_ctz(pendentes)] = visitados;
+    }
+}
+
 // Libera a memória alocada para todos os nós da lista encadeada.
 void liberar_lista(NoLista* cabeca) {
     NoLista* tmp; // Ponteiro temporário para auxiliar na liberação.
@@ -85,7 +145,8 @@ NoArvore* inserir_arvore(NoArvore* no, int chave) {
 
 // Busca uma chave na árvore BST.
 // Retorna o número de comparações realizadas até encontrar a chave ou determinar que ela não existe.
-int buscar_arvore(NoArvore* no, int chave) {
+// Como buscar_lista, só lê a árvore e pode ser chamada por várias threads ao mesmo tempo.
+int buscar_arvore(const NoArvore* no, int chave) {
     int comparacoes = 0; // Inicializa o contador de comparações.
     // Percorre a árvore enquanto o nó atual não for nulo.
     while (no != NULL) {
@@ -104,103 +165,421 @@ int buscar_arvore(NoArvore* no, int chave) {
     return comparacoes;
 }
 
-// Libera a memória alocada para todos os nós da árvore BST (percurso em pós-ordem).
+// Busca em lote na BST (ver DEFINIR_BUSCA_LOTE em estruturas.h).
+DEFINIR_BUSCA_LOTE(buscar_arvore_lote, const NoArvore*, const NoArvore*, NULL, RAIZ_PONTEIRO, NO_PONTEIRO)
+
+// Libera a memória alocada para todos os nós da árvore BST, sem recursão (com chaves ordenadas a
+// árvore tem a altura do número de nós, e a recursão estourava a pilha).
 void liberar_arvore(NoArvore* no) {
-    if (no == NULL) return; // Condição de parada da recursão.
-    liberar_arvore(no->esquerda); // Libera a subárvore esquerda.
-    liberar_arvore(no->direita);  // Libera a subárvore direita.
-    free(no); // Libera o nó atual.
+    while (no != NULL) {
+        if (no->esquerda != NULL) {
+            // Rotação à direita: o filho esquerdo sobe, até o nó atual não ter filho esquerdo.
+            NoArvore* filho = no->esquerda;
+            no->esquerda = filho->direita;
+            filho->direita = no;
+            no = filho;
+        } else {
+            // Sem filho esquerdo: libera o nó e continua pela subárvore direita.
+            NoArvore* direita = no->direita;
+            free(no);
+            no = direita;
+        }
+    }
+}
+
+// Tempo atual em nanossegundos, de um relógio monotônico (não anda para trás nem pula com ajustes de hora).
+long long agora_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (long long)t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+// Estruturas comparadas, na ordem das colunas do CSV: as quatro dinâmicas (um malloc por nó), as
+// quatro estáticas de estaticas.c (vetores contíguos, montados de uma vez), a tabela hash e a
+// lista e a BST com os nós no pool de pool_nos.c.
+const char* nomes_estruturas[QUANT_ESTRUTURAS] = {"Lista", "BST", "AVL", "RubroNegra",
+                                                  "VetorOrdenado", "Eytzinger", "STree", "VEB", "Hash",
+                                                  "ListaPool", "BSTPool"};
+
+// Monta a estrutura e com as n chaves. Retorna 0, ou -1 se faltou memória.
+int construir_estrutura(Estruturas* s, int e, const int* valores, int n) {
+    switch (e) {
+    case 0:
+        for (int i = 0; i < n; i++) s->lista = inserir_lista(s->lista, valores[i]);
+        return 0;
+    case 1:
+        for (int i = 0; i < n; i++) s->arvore = inserir_arvore(s->arvore, valores[i]);
+        return 0;
+    case 2:
+        for (int i = 0; i < n; i++)
+            if (inserir_avl(&s->avl, valores[i]) != 0)
+                return -1;
+        return 0;
+    case 3:
+        for (int i = 0; i < n; i++)
+            if (inserir_rb(&s->rb, valores[i]) != 0)
+                return -1;
+        return 0;
+    case 4: return construir_vetor(&s->vetor, valores, n);
+    case 5: return construir_eytzinger(&s->eytzinger, valores, n);
+    case 6: return construir_stree(&s->stree, valores, n);
+    case 7: return construir_veb(&s->veb, valores, n);
+    case 8:
+        if (iniciar_hash(&s->hash, s->carga_hash) != 0)
+            return -1;
+        for (int i = 0; i < n; i++)
+            if (inserir_hash(&s->hash, valores[i]) != 0)
+                return -1;
+        return 0;
+    case 9:
+        iniciar_lista_pool(&s->lista_pool);
+        for (int i = 0; i < n; i++)
+            if (inserir_lista_pool(&s->lista_pool, valores[i]) != 0)
+                return -1;
+        encolher_pool(&s->lista_pool.pool);
+        return 0;
+    default:
+        iniciar_arvore_pool(&s->arvore_pool);
+        for (int i = 0; i < n; i++)
+            if (inserir_arvore_pool(&s->arvore_pool, valores[i]) != 0)
+                return -1;
+        encolher_pool(&s->arvore_pool.pool);
+        return 0;
+    }
+}
+
+// Procura cada chave na estrutura e e guarda as comparações. A escolha da estrutura fica fora do
+// laço, para que o tempo medido seja só o das buscas. Nenhuma busca altera a estrutura, então
+// threads diferentes podem chamar buscar_todas juntas, cada uma com o seu vetor comp.
+void buscar_todas(const Estruturas* s, int e, const int* procuradas, int n, int* comp) {
+    switch (e) {
+    case 0: for (int i = 0; i < n; i++) comp[i] = buscar_lista(s->lista, procuradas[i]); break;
+    case 1: for (int i = 0; i < n; i++) comp[i] = buscar_arvore(s->arvore, procuradas[i]); break;
+    case 2: for (int i = 0; i < n; i++) comp[i] = buscar_avl(s->avl, procuradas[i]); break;
+    case 3: for (int i = 0; i < n; i++) comp[i] = buscar_rb(s->rb, procuradas[i]); break;
+    case 4: for (int i = 0; i < n; i++) comp[i] = buscar_vetor(&s->vetor, procuradas[i]); break;
+    case 5: for (int i = 0; i < n; i++) comp[i] = buscar_eytzinger(&s->eytzinger, procuradas[i]); break;
+    case 6: for (int i = 0; i < n; i++) comp[i] = buscar_stree(&s->stree, procuradas[i]); break;
+    case 7: for (int i = 0; i < n; i++) comp[i] = buscar_veb(&s->veb, procuradas[i]); break;
+    case 8: for (int i = 0; i < n; i++) comp[i] = buscar_hash(&s->hash, procuradas[i]); break;
+    case 9: for (int i = 0; i < n; i++) comp[i] = buscar_lista_pool(&s->lista_pool, procuradas[i]); break;
+    default: for (int i = 0; i < n; i++) comp[i] = buscar_arvore_pool(&s->arvore_pool, procuradas[i]); break;
+    }
+}
+
+// Como buscar_todas, mas com a busca em lote das estruturas que têm uma. Retorna 0, ou -1 se a
+// estrutura e só busca uma chave de cada vez (e então não faz nada).
+int buscar_todas_lote(const Estruturas* s, int e, const int* procuradas, int n, int* comp) {
+    switch (e) {
+    case 0: buscar_lista_lote(s->lista, procuradas, n, comp); return 0;
+    case 1: buscar_arvore_lote(s->arvore, procuradas, n, comp); return 0;
+    case 2: buscar_avl_lote(s->avl, procuradas, n, comp); return 0;
+    case 3: buscar_rb_lote(s->rb, procuradas, n, comp); return 0;
+    case 10: buscar_arvore_pool_lote(&s->arvore_pool, procuradas, n, comp); return 0;
+    default: return -1;
+    }
+}
+
+// Libera todas as estruturas (as que não foram montadas estão zeradas) e as deixa zeradas de novo.
+void liberar_estruturas(Estruturas* s) {
+    liberar_lista(s->lista);
+    liberar_arvore(s->arvore);
+    liberar_avl(s->avl);
+    liberar_rb(s->rb);
+    liberar_vetor(&s->vetor);
+    liberar_eytzinger(&s->eytzinger);
+    liberar_stree(&s->stree);
+    liberar_veb(&s->veb);
+    liberar_hash(&s->hash);
+    liberar_lista_pool(&s->lista_pool);
+    liberar_arvore_pool(&s->arvore_pool);
+    s->lista = NULL;
+    s->arvore = NULL;
+    s->avl = NULL;
+    s->rb = NULL;
 }
 
 // Função principal do programa.
-int main() {
-    // Abre (ou cria) o arquivo CSV para escrita dos resultados.
-    FILE *fp = fopen("dados_busca.csv", "w"); 
-    // Verifica se o arquivo foi aberto com sucesso.
-    if (fp == NULL) {
-        perror("Erro ao abrir arquivo dados_busca.csv"); // Mensagem de erro corrigida para o arquivo correto
-        return 1; // Retorna 1 indicando erro.
+// Uso: ./contagem [-n elementos] [-b buscas] [-s semente] [-o aleatoria|crescente|decrescente|zipf]
+//                  [-c carga] [--binario]
+//   -n         número de chaves inseridas (padrão: 10000, até 2^31 - 1)
+//   -b         número de buscas (padrão: 10000)
+//   -s         semente do gerador (padrão: a hora atual); a mesma semente repete as mesmas chaves,
+//              a mesma ordem e as mesmas buscas
+//   -o         ordem em que as chaves são inseridas (padrão: aleatoria)
+//   -c         fator de carga máximo da tabela hash, entre 0 e 1 (padrão: 0.875); acima dele a
+//              tabela dobra de tamanho
+//   --binario  grava dados_busca.bin (colunas compactadas; ./ler_colunas converte para CSV)
+// Com ./contagem --varredura [opções] roda a varredura de tamanhos e distribuições de varredura.c,
+// com ./contagem --paralelo [opções] as buscas em várias threads de paralelo.c e com
+// ./contagem --mistura [opções] a carga mista de buscas, inserções e remoções de mistura.c.
+// Sempre grava também resumo_busca.csv com, para cada estrutura, o tempo de inserção (ou de
+// montagem), a memória por chave, o tempo por busca, a vazão em milhões de buscas por segundo, as
+// falhas de cache por busca (quando o perf_event_open está disponível) e a média de comparações.
+// Acima de LIMITE_LINEAR chaves as estruturas com busca linear (as listas e, fora da ordem
+// aleatória, as BSTs) são puladas como na varredura: ficam com NA no CSV e no resumo e saem do
+// arquivo binário, que não tem valor ausente.
+int main(int argc, char* argv[]) {
+    int ordem = ORDEM_ALEATORIA;
+    int binario = 0;
+    double carga_hash = 0.875;
+    // Número de elementos gerados e inseridos e número de buscas realizadas.
+    int tamanho = 10000;
+    int numero_de_buscas = 10000;
+    uint64_t semente = (uint64_t)time(NULL);
+
+    if (argc > 1 && strcmp(argv[1], "--varredura") == 0)
+        return executar_varredura(argc - 1, argv + 1);
+    if (argc > 1 && strcmp(argv[1], "--paralelo") == 0)
+        return executar_paralelo(argc - 1, argv + 1);
+    if (argc > 1 && strcmp(argv[1], "--mistura") == 0)
+        return executar_mistura(argc - 1, argv + 1);
+
+    // Lê as opções da linha de comando.
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--binario") == 0) {
+            // Com --binario cada busca vai para o escritor em colunas em vez de um fprintf por linha.
+            binario = 1;
+        } else if ((strcmp(argv[i], "-n") == 0 || strcmp(argv[i], "-b") == 0) && i + 1 < argc) {
+            char* fim;
+            long long quant = strtoll(argv[i + 1], &fim, 10);
+            if (*fim != '\0' || quant < 1 || quant > (long long)(CHAVES_MAXIMO - 1)) {
+                fprintf(stderr, "quantidade invalida: %s\n", argv[i + 1]);
+                return 1;
+            }
+            if (argv[i][1] == 'n')
+                tamanho = (int)quant;
+            else
+                numero_de_buscas = (int)quant;
+            i++;
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            if (ler_semente(argv[++i], &semente) != 0)
+                return 1;
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            if (ler_carga(argv[++i], &carga_hash) != 0)
+                return 1;
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            if (ler_ordem(argv[++i], &ordem) != 0)
+                return 1;
+        } else {
+            fprintf(stderr, "uso: %s [-n elementos] [-b buscas] [-s semente] [-o aleatoria|crescente|decrescente|zipf] "
+                    "[-c carga] [--binario]\n", argv[0]);
+            return 1;
+        }
     }
-    // Escreve o cabeçalho no arquivo CSV.
-    fprintf(fp, "NumeroProcurado,ComparacoesLista,ComparacoesBST\n");
 
-    // Define o número máximo de elementos a serem gerados e inseridos.
-    const int TAMANHO_MAXIMO = 10000;
-    // Define o número de buscas a serem realizadas.
-    const int NUMERO_DE_BUSCAS = 10000; 
+    // Estruturas puladas: com busca linear, n buscas custariam n * tamanho / 2 comparações (e a
+    // BST recursiva com chaves ordenadas, O(tamanho^2) só para montar).
+    int pulada[QUANT_ESTRUTURAS];
+    for (int e = 0; e < QUANT_ESTRUTURAS; e++)
+        pulada[e] = busca_linear(e, ordem) && tamanho > LIMITE_LINEAR;
 
-    // Inicializa o gerador de números aleatórios com uma semente baseada no tempo atual.
-    // Isso garante que os números gerados sejam diferentes a cada execução.
-    srand((unsigned int)time(NULL)); 
+    // Colunas da saída: a chave procurada e as comparações em cada estrutura. O CSV tem sempre
+    // todas; o binário só as das estruturas montadas.
+    char colunas[1 + QUANT_ESTRUTURAS][32];
+    const char* nomes_colunas[1 + QUANT_ESTRUTURAS];
+    int quant_binario = 1;
+    snprintf(colunas[0], sizeof(colunas[0]), "NumeroProcurado");
+    for (int e = 0; e < QUANT_ESTRUTURAS; e++)
+        snprintf(colunas[1 + e], sizeof(colunas[1 + e]), "Comparacoes%s", nomes_estruturas[e]);
+    for (int c = 0; c < 1 + QUANT_ESTRUTURAS; c++)
+        nomes_colunas[c] = colunas[c];
+    for (int e = 0; e < QUANT_ESTRUTURAS; e++)
+        if (!pulada[e])
+            nomes_colunas[quant_binario++] = colunas[1 + e];
 
+    EscritorColunas escritor;
+    FILE *fp = NULL;
 
+    if (binario) {
+        // Abre o arquivo binário e grava o cabeçalho com os nomes das colunas.
+        if (abrir_escritor_colunas(&escritor, "dados_busca.bin", quant_binario, nomes_colunas) != 0) {
+            perror("Erro ao abrir arquivo dados_busca.bin");
+            return 1;
+        }
+    } else {
+        // Abre (ou cria) o arquivo CSV para escrita dos resultados.
+        fp = fopen("dados_busca.csv", "w");
+        // Verifica se o arquivo foi aberto com sucesso.
+        if (fp == NULL) {
+            perror("Erro ao abrir arquivo dados_busca.csv"); // Mensagem de erro corrigida para o arquivo correto
+            return 1; // Retorna 1 indicando erro.
+        }
+        // Escreve o cabeçalho no arquivo CSV.
+        for (int c = 0; c < 1 + QUANT_ESTRUTURAS; c++)
+            fprintf(fp, "%s%s", c > 0 ? "," : "", colunas[c]);
+        fprintf(fp, "\n");
+    }
+
+    // Inicializa o gerador com a semente: sem -s ela vem da hora atual, então cada execução é
+    // diferente, mas a semente aparece no resumo para repetir a execução.
+    GeradorAleatorio gerador;
+    semear_gerador(&gerador, semente);
 
-    // Aloca memória para um array que armazenará os valores únicos gerados.
-    int *valores = (int *)malloc(TAMANHO_MAXIMO * sizeof(int));
+    // Aloca memória para os valores únicos, as chaves procuradas e as comparações de cada busca
+    // em cada estrutura.
+    int *valores = (int *)malloc((size_t)tamanho * sizeof(int));
+    int *procuradas = (int *)malloc((size_t)numero_de_buscas * sizeof(int));
+    int *comparacoes = (int *)malloc((size_t)QUANT_ESTRUTURAS * numero_de_buscas * sizeof(int));
     // Verifica se a alocação de memória foi bem-sucedida.
-    if (valores == NULL) {
+    if (valores == NULL || procuradas == NULL || comparacoes == NULL) {
         perror("Falha ao alocar memoria para valores");
-        fclose(fp); // Fecha o arquivo antes de sair.
+        free(valores);
+        free(procuradas);
+        free(comparacoes);
+        // Fecha o arquivo antes de sair.
+        if (binario)
+            fechar_escritor_colunas(&escritor);
+        else
+            fclose(fp);
         return 1; // Retorna 1 indicando erro.
     }
 
-    // Loop para gerar TAMANHO_MAXIMO números aleatórios únicos.
-    for (int i = 0; i < TAMANHO_MAXIMO; i++) {
-        int novo_valor;
-        int duplicado;
-        // Garante que o novo valor gerado seja único.
-        do {
-            novo_valor = rand(); // Gera um número aleatório.
-            duplicado = 0; // Assume que não é duplicado inicialmente.
-            // Verifica se o novo valor já existe no array de valores.
-            for (int j = 0; j < i; j++) {
-                if (valores[j] == novo_valor) {
-                    duplicado = 1; // Marca como duplicado.
-                    break; // Sai do loop interno.
-                }
+    // Gera as chaves únicas: a i-ésima é a imagem de i por uma permutação dos inteiros de 31 bits
+    // sorteada pela semente, então não há repetidas para procurar (antes cada chave nova era
+    // comparada com todas as anteriores, O(n^2)).
+    long long inicio_geracao = agora_ns();
+    gerar_chaves_unicas(valores, (uint32_t)tamanho, semente);
+    long long tempo_geracao = agora_ns() - inicio_geracao;
+
+    // Coloca as chaves na ordem de inserção pedida.
+    ordenar_chaves(valores, tamanho, ordem, &gerador);
+
+    // Inicializa as raízes/cabeças de todas as estruturas como nulas.
+    Estruturas estruturas;
+    memset(&estruturas, 0, sizeof(estruturas));
+    estruturas.carga_hash = carga_hash;
+    long long tempo_insercao[QUANT_ESTRUTURAS], tempo_busca[QUANT_ESTRUTURAS], falhas_cache[QUANT_ESTRUTURAS];
+    size_t memoria[QUANT_ESTRUTURAS];
+    // Qualquer erro daqui em diante pula o resto e passa pela mesma liberação do final.
+    int erro = 0;
+
+    // Insere os valores em cada estrutura separadamente, medindo o tempo e a memória de cada uma.
+    for (int e = 0; e < QUANT_ESTRUTURAS && !erro; e++) {
+        if (pulada[e])
+            continue;
+        size_t memoria_antes = memoria_alocada();
+        long long inicio = agora_ns();
+        if (construir_estrutura(&estruturas, e, valores, tamanho) != 0) {
+            perror("Falha ao alocar memoria para as estruturas");
+            erro = 1;
+            continue;
+        }
+        tempo_insercao[e] = agora_ns() - inicio;
+        memoria[e] = memoria_alocada() - memoria_antes;
+    }
+
+    // Sorteia as chaves procuradas antes, para que todas as estruturas façam as mesmas buscas.
+    for (int i = 0; i < numero_de_buscas; i++) {
+        // Escolhe aleatoriamente um índice de um valor já inserido.
+        procuradas[i] = valores[sortear_ate(&gerador, (uint32_t)tamanho)];
+    }
+
+    // Realiza as buscas de uma estrutura por vez, medindo o tempo total e as falhas de cache de cada uma.
+    int contador = abrir_contador_cache();
+    for (int e = 0; e < QUANT_ESTRUTURAS && !erro; e++) {
+        if (pulada[e])
+            continue;
+        int* comp = comparacoes + (size_t)e * numero_de_buscas;
+        iniciar_contador_cache(contador);
+        long long inicio = agora_ns();
+        buscar_todas(&estruturas, e, procuradas, numero_de_buscas, comp);
+        tempo_busca[e] = agora_ns() - inicio;
+        falhas_cache[e] = parar_contador_cache(contador);
+    }
+    fechar_contador_cache(contador);
+
+    // Escreve os resultados de cada busca no arquivo binário ou no CSV. O escritor binário grava um
+    // grupo a cada GRUPO_LINHAS linhas, e um erro nessa gravação só aparece aqui.
+    for (int i = 0; i < numero_de_buscas && !erro; i++) {
+        if (binario) {
+            int64_t linha[1 + QUANT_ESTRUTURAS];
+            int c = 0;
+            linha[c++] = procuradas[i];
+            for (int e = 0; e < QUANT_ESTRUTURAS; e++)
+                if (!pulada[e])
+                    linha[c++] = comparacoes[(size_t)e * numero_de_buscas + i];
+            if (escrever_linha(&escritor, linha) != 0) {
+                perror("Erro ao gravar dados_busca.bin");
+                erro = 1;
+            }
+        } else {
+            fprintf(fp, "%d", procuradas[i]);
+            for (int e = 0; e < QUANT_ESTRUTURAS; e++) {
+                if (pulada[e])
+                    fprintf(fp, ",NA");
+                else
+                    fprintf(fp, ",%d", comparacoes[(size_t)e * numero_de_buscas + i]);
             }
-        } while (duplicado); // Repete se o valor for duplicado.
-        valores[i] = novo_valor; // Armazena o valor único gerado.
+            fprintf(fp, "\n");
+        }
     }
-   
 
-    // Inicializa as cabeças da lista encadeada e da árvore BST como nulas.
-    NoLista* lista = NULL;
-    NoArvore* arvore = NULL;
+    // Resumo por estrutura: na tela e em resumo_busca.csv.
+    if (!erro) {
+        FILE* resumo = fopen("resumo_busca.csv", "w");
+        if (resumo != NULL)
+            fprintf(resumo, "Estrutura,Ordem,Elementos,Buscas,InsercaoMs,BytesPorChave,NsPorBusca,"
+                            "MilhoesBuscasPorSegundo,FalhasCachePorBusca,ComparacoesMedias\n");
+        printf("ordem: %s, %d elementos, %d buscas, semente %" PRIu64 " (chaves geradas em %.1f ms)\n",
+               nomes_ordens[ordem], tamanho, numero_de_buscas, semente, tempo_geracao / 1e6);
+        printf("hash: fator de carga maximo %.3f, %zu posicoes, %d redimensionamentos\n", carga_hash,
+               estruturas.hash.capacidade, estruturas.hash.redimensionamentos);
+        printf("%-14s %12s %12s %12s %12s %14s %14s\n", "estrutura", "insercao ms", "bytes/chave", "ns/busca", "Mbuscas/s",
+               "falhas/busca", "comparacoes");
+
+        for (int e = 0; e < QUANT_ESTRUTURAS; e++) {
+            if (pulada[e]) {
+                printf("%-14s %12s %12s %12s %12s %14s %14s\n", nomes_estruturas[e], "pulada", "n/d", "n/d", "n/d",
+                       "n/d", "n/d");
+                if (resumo != NULL)
+                    fprintf(resumo, "%s,%s,%d,%d,NA,NA,NA,NA,NA,NA\n", nomes_estruturas[e], nomes_ordens[ordem],
+                            tamanho, numero_de_buscas);
+                continue;
+            }
+            long long soma = 0;
+            for (int i = 0; i < numero_de_buscas; i++)
+                soma += comparacoes[(size_t)e * numero_de_buscas + i];
+
+            double insercao_ms = tempo_insercao[e] / 1e6;
+            double ns_busca = (double)tempo_busca[e] / numero_de_buscas;
+            double media = (double)soma / numero_de_buscas;
+            double vazao = ns_busca > 0 ? 1e3 / ns_busca : 0; // milhões de buscas por segundo
+            double bytes_chave = (double)memoria[e] / tamanho; // com cabeçalhos do malloc e sobras dos blocos
+
+            // Sem contador de hardware, "n/d" na tela e NA no CSV (o R lê como ausente).
+            char falhas[32];
+            if (falhas_cache[e] >= 0)
+                snprintf(falhas, sizeof(falhas), "%.3f", (double)falhas_cache[e] / numero_de_buscas);
+            else
+                snprintf(falhas, sizeof(falhas), "NA");
 
-   
-    // Loop para inserir os valores gerados na lista encadeada e na árvore BST.
-    for (int i = 0; i < TAMANHO_MAXIMO; i++) {
-        lista = inserir_lista(lista, valores[i]);
-        arvore = inserir_arvore(arvore, valores[i]);
+            printf("%-14s %12.3f %12.1f %12.1f %12.2f %14s %14.2f\n", nomes_estruturas[e], insercao_ms, bytes_chave,
+                   ns_busca, vazao, falhas_cache[e] >= 0 ? falhas : "n/d", media);
+            if (resumo != NULL)
+                fprintf(resumo, "%s,%s,%d,%d,%.3f,%.1f,%.1f,%.3f,%s,%.2f\n", nomes_estruturas[e], nomes_ordens[ordem],
+                        tamanho, numero_de_buscas, insercao_ms, bytes_chave, ns_busca, vazao, falhas, media);
+        }
+        if (resumo != NULL)
+            fclose(resumo);
     }
-   
 
-   
-    // Loop para realizar as buscas.
-    for (int i = 0; i < NUMERO_DE_BUSCAS; i++) {
-        // Escolhe aleatoriamente um índice de um valor já inserido.
-        int idx_busca = rand() % TAMANHO_MAXIMO;
-        // Obtém o valor a ser procurado.
-        int chave_procurada = valores[idx_busca];
-
-        // Realiza a busca na lista e na árvore.
-        int compLista = buscar_lista(lista, chave_procurada);
-        int compArvore = buscar_arvore(arvore, chave_procurada);
-
-        // Escreve os resultados da busca no arquivo CSV.
-        fprintf(fp, "%d,%d,%d\n", chave_procurada, compLista, compArvore);
-    }
-    
- 
-    // Libera a memória alocada para a lista, a árvore e o array de valores.
-     liberar_lista(lista);
-    liberar_arvore(arvore);
+    // Libera a memória alocada para as estruturas e os vetores.
+    liberar_estruturas(&estruturas);
     free(valores);
+    free(procuradas);
+    free(comparacoes);
 
-    // Fecha o arquivo CSV.
-    fclose(fp);
-    // Mensagem de confirmação atualizada para o nome correto do arquivo.
+    // Fecha o arquivo de saída (o escritor binário grava antes o último grupo).
+    if (binario) {
+        if (fechar_escritor_colunas(&escritor) != 0 && !erro) {
+            perror("Erro ao gravar dados_busca.bin");
+            erro = 1;
+        }
+    } else if (fclose(fp) != 0 && !erro) {
+        perror("Erro ao gravar dados_busca.csv");
+        erro = 1;
+    }
 
-    return 0;
-}
\ No newline at end of file
+    return erro;
+}
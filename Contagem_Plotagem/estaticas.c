@@ -0,0 +1,297 @@
+// Estruturas de busca estáticas: montadas de uma vez a partir das chaves e guardadas em vetores.
+// Sem ponteiros entre nós (ou com índices de 32 bits, na vEB), a busca deixa de esperar um malloc
+// espalhado pela memória a cada nível; o que muda entre elas é quantas linhas de cache cada busca toca.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "estruturas.h"
+
+// Compara dois inteiros para o qsort (ordem crescente).
+static int comparar_chaves(const void* a, const void* b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// Cópia ordenada das chaves; todas as estruturas partem dela.
+static int* copiar_ordenado(const int* valores, int n) {
+    int* ordenado = (int*)malloc((size_t)(n > 0 ? n : 1) * sizeof(int));
+    if (ordenado == NULL)
+        return NULL;
+    memcpy(ordenado, valores, (size_t)n * sizeof(int));
+    qsort(ordenado, n, sizeof(int), comparar_chaves);
+    return ordenado;
+}
+
+// Vetor alinhado à linha de cache, com o tamanho arredondado como aligned_alloc exige.
+static void* alocar_alinhado(size_t bytes) {
+    bytes = (bytes + LINHA_CACHE - 1) / LINHA_CACHE * LINHA_CACHE;
+    return aligned_alloc(LINHA_CACHE, bytes > 0 ? bytes : LINHA_CACHE);
+}
+
+// ==================== Vetor ordenado =======================
+
+// O número de comparações da busca binária só depende de n. Sem esta barreira (vazia, mas que o
+// compilador precisa supor que lê a posição achada) as leituras do vetor seriam descartadas e o
+// tempo medido seria o de um laço vazio.
+#define USAR_RESULTADO(x) __asm__ volatile("" : : "r"(x))
+
+int construir_vetor(VetorOrdenado* v, const int* valores, int n) {
+    v->chaves = copiar_ordenado(valores, n);
+    v->n = n;
+    return v->chaves ? 0 : -1;
+}
+
+// Busca binária sem desvios: o intervalo sempre cai pela metade e a escolha da metade é aritmética,
+// então o processador não erra previsões de desvio. Uma comparação por passo e uma no final.
+int buscar_vetor(const VetorOrdenado* v, int chave) {
+    const int* base = v->chaves;
+    int tamanho = v->n;
+    int comparacoes = 0;
+
+    if (tamanho == 0)
+        return 0;
+
+    while (tamanho > 1) {
+        int metade = tamanho / 2;
+        base += (base[metade - 1] < chave) * metade; // multiplicação em vez de ?: para o gcc não gerar desvio
+        tamanho -= metade;
+        comparacoes++;
+    }
+    comparacoes++; // *base == chave?
+    USAR_RESULTADO(*base == chave);
+    return comparacoes;
+}
+
+void liberar_vetor(VetorOrdenado* v) {
+    free(v->chaves);
+    v->chaves = NULL;
+}
+
+// ==================== Eytzinger =======================
+
+// Percorre a árvore implícita em ordem, copiando as chaves ordenadas: chaves[k] recebe a k-ésima
+// menor chave do percurso. A profundidade é log2(n), então a recursão é rasa.
+static int preencher_eytzinger(int* chaves, int n, const int* ordenado, int i, int k) {
+    if (k <= n) {
+        i = preencher_eytzinger(chaves, n, ordenado, i, 2 * k);
+        chaves[k] = ordenado[i++];
+        i = preencher_eytzinger(chaves, n, ordenado, i, 2 * k + 1);
+    }
+    return i;
+}
+
+int construir_eytzinger(Eytzinger* e, const int* valores, int n) {
+    int* ordenado = copiar_ordenado(valores, n);
+    e->n = n;
+    e->chaves = (int*)alocar_alinhado((size_t)(n + 1) * sizeof(int));
+    if (ordenado == NULL || e->chaves == NULL) {
+        free(ordenado);
+        free(e->chaves);
+        e->chaves = NULL;
+        return -1;
+    }
+    e->chaves[0] = INT_MIN; // posição 0 não é usada
+    preencher_eytzinger(e->chaves, n, ordenado, 0, 1);
+    free(ordenado);
+    return 0;
+}
+
+// Desce sempre até uma folha, sem desvio: k = 2k + (chave > chaves[k]). Enquanto isso pede a linha
+// com os 16 bisnetos de k (posições 16k ... 16k + 15), que chega a tempo de ser usada quatro níveis
+// depois. No fim, os bits 1 acumulados à direita de k dizem quantas vezes a busca foi para a
+// direita depois do último passo à esquerda; tirá-los leva ao primeiro elemento >= chave.
+int buscar_eytzinger(const Eytzinger* e, int chave) {
+    const int* chaves = e->chaves;
+    unsigned k = 1;
+    int comparacoes = 0;
+
+    while (k <= (unsigned)e->n) {
+        __builtin_prefetch(chaves + 16 * k);
+        k = 2 * k + (chaves[k] < chave);
+        comparacoes++;
+    }
+    k >>= __builtin_ffs(~k);
+    if (k != 0)
+        comparacoes++; // chaves[k] == chave?
+    return comparacoes;
+}
+
+void liberar_eytzinger(Eytzinger* e) {
+    free(e->chaves);
+    e->chaves = NULL;
+}
+
+// ==================== S-tree =======================
+
+// Como no Eytzinger, mas com nós de STREE_B chaves e STREE_B + 1 filhos: o percurso em ordem visita
+// o filho i antes da chave i do nó e o último filho depois de todas. Posições além de n recebem
+// INT_MAX, que nunca é menor que a chave procurada.
+static int preencher_stree(STree* s, const int* ordenado, int n, int i, int k) {
+    if (k < s->quant_nos) {
+        for (int j = 0; j < STREE_B; j++) {
+            i = preencher_stree(s, ordenado, n, i, k * (STREE_B + 1) + j + 1);
+            s->chaves[k * STREE_B + j] = (i < n) ? ordenado[i++] : INT_MAX;
+        }
+        i = preencher_stree(s, ordenado, n, i, k * (STREE_B + 1) + STREE_B + 1);
+    }
+    return i;
+}
+
+int construir_stree(STree* s, const int* valores, int n) {
+    int* ordenado = copiar_ordenado(valores, n);
+    s->quant_nos = (n + STREE_B - 1) / STREE_B;
+    s->chaves = (int*)alocar_alinhado((size_t)s->quant_nos * STREE_B * sizeof(int));
+    if (ordenado == NULL || s->chaves == NULL) {
+        free(ordenado);
+        free(s->chaves);
+        s->chaves = NULL;
+        return -1;
+    }
+    preencher_stree(s, ordenado, n, 0, 0);
+    free(ordenado);
+    return 0;
+}
+
+// Quantas chaves do nó são menores que a procurada, ou seja, a posição da primeira >= chave.
+// Com SSE2 as 16 comparações são 4 instruções; os resultados são empacotados em 16 bytes e
+// contados pela máscara.
+static int posicao_no(const int* no, int chave) {
+#ifdef __SSE2__
+    __m128i x = _mm_set1_epi32(chave);
+    __m128i c0 = _mm_cmpgt_epi32(x, _mm_load_si128((const __m128i*)no));
+    __m128i c1 = _mm_cmpgt_epi32(x, _mm_load_si128((const __m128i*)(no + 4)));
+    __m128i c2 = _mm_cmpgt_epi32(x, _mm_load_si128((const __m128i*)(no + 8)));
+    __m128i c3 = _mm_cmpgt_epi32(x, _mm_load_si128((const __m128i*)(no + 12)));
+    __m128i bytes = _mm_packs_epi16(_mm_packs_epi32(c0, c1), _mm_packs_epi32(c2, c3));
+    return __builtin_popcount((unsigned)_mm_movemask_epi8(bytes));
+#else
+    int menores = 0;
+    for (int j = 0; j < STREE_B; j++)
+        menores += (no[j] < chave);
+    return menores;
+#endif
+}
+
+// Um nó (uma linha de cache) por nível: log_17(n) níveis contra log2(n) do Eytzinger.
+int buscar_stree(const STree* s, int chave) {
+    int k = 0;
+    int comparacoes = 0;
+
+    while (k < s->quant_nos) {
+        int j = posicao_no(s->chaves + (size_t)k * STREE_B, chave);
+        comparacoes += STREE_B;
+        k = k * (STREE_B + 1) + j + 1;
+    }
+    return comparacoes;
+}
+
+void liberar_stree(STree* s) {
+    free(s->chaves);
+    s->chaves = NULL;
+}
+
+// ==================== Layout de van Emde Boas =======================
+
+// A árvore é a BST perfeitamente balanceada sobre o vetor ordenado: a raiz de [ini, fim) é o meio.
+// A montagem só decide em que posição do vetor de nós cada chave fica.
+typedef struct {
+    const int* ordenado;
+    int* posicao;   // posicao[i] = onde a i-ésima menor chave foi colocada
+    int proxima;    // próxima posição livre
+} MontagemVEB;
+
+static void dispor_veb(MontagemVEB* m, int ini, int fim, int niveis);
+
+// Dispõe, da esquerda para a direita, as subárvores que começam 'faltam' níveis abaixo de [ini, fim),
+// cada uma com 'niveis' níveis.
+static void dispor_subarvores(MontagemVEB* m, int ini, int fim, int faltam, int niveis) {
+    if (ini >= fim)
+        return;
+    if (faltam == 0) {
+        dispor_veb(m, ini, fim, niveis);
+        return;
+    }
+    int meio = ini + (fim - ini) / 2;
+    dispor_subarvores(m, ini, meio, faltam - 1, niveis);
+    dispor_subarvores(m, meio + 1, fim, faltam - 1, niveis);
+}
+
+// Dispõe os primeiros 'niveis' níveis da subárvore [ini, fim): primeiro a metade de cima, depois
+// cada subárvore de baixo, e o mesmo dentro de cada parte.
+static void dispor_veb(MontagemVEB* m, int ini, int fim, int niveis) {
+    if (ini >= fim)
+        return;
+    if (niveis == 1) {
+        m->posicao[ini + (fim - ini) / 2] = m->proxima++;
+        return;
+    }
+    int cima = niveis / 2;
+    dispor_veb(m, ini, fim, cima);
+    dispor_subarvores(m, ini, fim, cima, niveis - cima);
+}
+
+// Liga cada nó aos filhos já posicionados e retorna a posição da raiz de [ini, fim).
+static int ligar_veb(ArvoreVEB* a, const MontagemVEB* m, int ini, int fim) {
+    if (ini >= fim)
+        return -1;
+    int meio = ini + (fim - ini) / 2;
+    NoVEB* no = &a->nos[m->posicao[meio]];
+    no->chave = m->ordenado[meio];
+    no->esquerda = ligar_veb(a, m, ini, meio);
+    no->direita = ligar_veb(a, m, meio + 1, fim);
+    return m->posicao[meio];
+}
+
+int construir_veb(ArvoreVEB* a, const int* valores, int n) {
+    MontagemVEB m;
+    int niveis = 0;
+
+    while (niveis < 31 && ((1u << niveis) - 1) < (unsigned)n)
+        niveis++;
+
+    m.ordenado = copiar_ordenado(valores, n);
+    m.posicao = (int*)malloc((size_t)(n > 0 ? n : 1) * sizeof(int));
+    m.proxima = 0;
+    a->n = n;
+    a->nos = (NoVEB*)alocar_alinhado((size_t)n * sizeof(NoVEB));
+    if (m.ordenado == NULL || m.posicao == NULL || a->nos == NULL) {
+        free((int*)m.ordenado);
+        free(m.posicao);
+        free(a->nos);
+        a->nos = NULL;
+        return -1;
+    }
+
+    dispor_veb(&m, 0, n, niveis);
+    ligar_veb(a, &m, 0, n); // a raiz fica na posição 0
+
+    free((int*)m.ordenado);
+    free(m.posicao);
+    return 0;
+}
+
+// Busca de BST comum: uma comparação por nó visitado.
+int buscar_veb(const ArvoreVEB* a, int chave) {
+    int k = a->n > 0 ? 0 : -1;
+    int comparacoes = 0;
+
+    while (k >= 0) {
+        const NoVEB* no = &a->nos[k];
+        comparacoes++;
+        if (chave == no->chave)
+            return comparacoes;
+        k = (chave < no->chave) ? no->esquerda : no->direita;
+    }
+    return comparacoes;
+}
+
+void liberar_veb(ArvoreVEB* a) {
+    free(a->nos);
+    a->nos = NULL;
+}
@@ -0,0 +1,392 @@
+#ifndef ESTRUTURAS_H_INCLUDED
+#define ESTRUTURAS_H_INCLUDED
+
+// Estruturas de busca comparadas com a lista encadeada e a árvore BST de contagem.c.
+// Todas as funções de busca retornam o número de comparações, contadas como em buscar_arvore:
+// uma por nó visitado.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+// Buscas em andamento ao mesmo tempo nas buscas em lote (buscar_*_lote). Cada uma espera um nó da
+// memória; com 16 as falhas de cache de várias buscas se sobrepõem sem esgotar os buffers de
+// falhas pendentes do núcleo (10 a 16 nos x86 atuais).
+#define LOTE_BUSCAS 16
+
+// Linha de cache (64 bytes nos x86 e na maioria dos ARM) e limite de threads dos modos paralelos.
+#define LINHA_CACHE 64
+#define MAXIMO_THREADS 256
+
+// Busca em lote numa árvore de busca, no estilo AMAC: até LOTE_BUSCAS buscas andam juntas, cada uma
+// um nível por vez, em rodízio. Ao descer, a busca pede o próximo nó com __builtin_prefetch e passa
+// a vez; até ela voltar, as outras buscas do lote deram um passo cada, e o nó já está chegando da
+// memória. Assim as falhas de cache de buscas diferentes se sobrepõem, em vez de uma esperar a
+// outra. Quando uma busca termina, a posição dela no lote recebe a próxima chave. As comparações de
+// cada busca são as mesmas da busca uma a uma, guardadas em comparacoes[i].
+//
+// A mesma função serve para as árvores com ponteiros e para as do pool, com índices: TipoRef é o
+// tipo que aponta um nó, nulo é a árvore vazia, raiz_de(arvore) dá a raiz e no_de(arvore, ref) o
+// nó (com os campos chave, esquerda e direita).
+#define DEFINIR_BUSCA_LOTE(nome, TipoArvore, TipoRef, nulo, raiz_de, no_de)                           \
+    void nome(TipoArvore arvore, const int* chaves, int n, int* comparacoes) {                        \
+        TipoRef raiz = raiz_de(arvore);                                                              \
+        TipoRef no[LOTE_BUSCAS]; /* onde cada busca do lote está */                                  \
+        int busca[LOTE_BUSCAS];  /* qual busca ocupa cada posição */                                 \
+        int ativas = 0, proxima = 0;                                                                 \
+                                                                                                     \
+        for (; ativas < LOTE_BUSCAS && proxima < n; ativas++, proxima++) {                           \
+            busca[ativas] = proxima;                                                                 \
+            no[ativas] = raiz;                                                                       \
+            comparacoes[proxima] = 0;                                                                \
+        }                                                                                            \
+                                                                                                     \
+        while (ativas > 0) {                                                                         \
+            for (int j = 0; j < ativas;) {                                                           \
+                TipoRef atual = no[j];                                                               \
+                int i = busca[j];                                                                    \
+                if (atual != nulo) {                                                                 \
+                    comparacoes[i]++;                                                                \
+                    if (chaves[i] != no_de(arvore, atual).chave) {                                   \
+                        atual = (chaves[i] < no_de(arvore, atual).chave) ? no_de(arvore, atual).esquerda \
+                                                                         : no_de(arvore, atual).direita; \
+                        if (atual != nulo) {                                                         \
+                            __builtin_prefetch(&no_de(arvore, atual));                               \
+                            no[j++] = atual;                                                         \
+                            continue;                                                                \
+                        }                                                                            \
+                    }                                                                                \
+                }                                                                                    \
+                /* A busca i terminou: a posição fica com a próxima chave, ou com a última do lote. */ \
+                if (proxima < n) {                                                                   \
+                    busca[j] = proxima;                                                              \
+                    no[j] = raiz;                                                                    \
+                    comparacoes[proxima++] = 0;                                                      \
+                    j++;                                                                             \
+                } else {                                                                             \
+                    ativas--;                                                                        \
+                    busca[j] = busca[ativas];                                                        \
+                    no[j] = no[ativas];                                                              \
+                }                                                                                    \
+            }                                                                                        \
+        }                                                                                            \
+    }
+
+// raiz_de e no_de das árvores com ponteiros: a árvore é o ponteiro para a raiz.
+#define RAIZ_PONTEIRO(raiz) (raiz)
+#define NO_PONTEIRO(raiz, no) (*(no))
+
+// ==================== Árvore AVL =======================
+
+// Nó da árvore AVL: além da chave e dos filhos, guarda a altura da subárvore.
+typedef struct NoAVL {
+    int chave;
+    int altura; // folha = 1
+    struct NoAVL* esquerda;
+    struct NoAVL* direita;
+} NoAVL;
+
+int inserir_avl(NoAVL** raiz, int chave); // iterativa; atualiza *raiz; 0, ou -1 se faltou memória
+int buscar_avl(const NoAVL* raiz, int chave);
+// Procura chaves[0..n) intercalando até LOTE_BUSCAS buscas; comparacoes[i] é o que buscar_avl daria.
+void buscar_avl_lote(const NoAVL* raiz, const int* chaves, int n, int* comparacoes);
+void liberar_avl(NoAVL* raiz);
+
+// ==================== Árvore rubro-negra =======================
+
+#define RB_VERMELHO 0
+#define RB_PRETO 1
+
+// Nó da árvore rubro-negra: a cor e o ponteiro para o pai permitem corrigir a árvore subindo,
+// sem recursão.
+typedef struct NoRB {
+    int chave;
+    int cor;
+    struct NoRB* esquerda;
+    struct NoRB* direita;
+    struct NoRB* pai;
+} NoRB;
+
+int inserir_rb(NoRB** raiz, int chave); // como inserir_avl
+int buscar_rb(const NoRB* raiz, int chave);
+void buscar_rb_lote(const NoRB* raiz, const int* chaves, int n, int* comparacoes); // como buscar_avl_lote
+void liberar_rb(NoRB* raiz);
+
+// ==================== Estruturas estáticas =======================
+
+// Montadas uma vez a partir do vetor de chaves (em qualquer ordem) e depois só consultadas.
+// Todas guardam as chaves em vetores contíguos, sem um malloc por nó.
+
+// Vetor ordenado com busca binária sem desvios.
+typedef struct {
+    int* chaves;
+    int n;
+} VetorOrdenado;
+
+// Layout de Eytzinger: a árvore binária completa guardada em largura (filhos de k em 2k e 2k+1).
+// Os 16 descendentes de k quatro níveis abaixo ficam numa mesma linha de cache, então a busca
+// pede essa linha antes de precisar dela.
+typedef struct {
+    int* chaves; // chaves[1..n]; alinhado em 64 bytes
+    int n;
+} Eytzinger;
+
+// S-tree: árvore B estática com um nó por linha de cache (16 chaves). O nó é comparado de uma vez
+// com SIMD e os filhos do nó k ficam em k * 17 + 1 ... k * 17 + 17, sem ponteiros.
+#define STREE_B 16
+typedef struct {
+    int* chaves; // quant_nos * STREE_B, completado com INT_MAX
+    int quant_nos;
+} STree;
+
+// Árvore binária balanceada no layout de van Emde Boas: a metade de cima da árvore vem primeiro,
+// seguida de cada subárvore de baixo, recursivamente. Qualquer caminho da raiz toca O(log_B n)
+// blocos de memória, seja qual for o tamanho B do bloco. Os filhos são índices de 32 bits.
+typedef struct {
+    int chave;
+    int esquerda; // -1 = sem filho
+    int direita;
+} NoVEB;
+
+typedef struct {
+    NoVEB* nos;
+    int n;
+} ArvoreVEB;
+
+// Retornam 0 em caso de sucesso e -1 sem memória.
+int construir_vetor(VetorOrdenado* v, const int* valores, int n);
+int construir_eytzinger(Eytzinger* e, const int* valores, int n);
+int construir_stree(STree* s, const int* valores, int n);
+int construir_veb(ArvoreVEB* a, const int* valores, int n);
+
+// Retornam o número de comparações, como as buscas das árvores. Na S-tree cada nó visitado conta
+// STREE_B comparações (todas as chaves do nó são comparadas juntas).
+int buscar_vetor(const VetorOrdenado* v, int chave);
+int buscar_eytzinger(const Eytzinger* e, int chave);
+int buscar_stree(const STree* s, int chave);
+int buscar_veb(const ArvoreVEB* a, int chave);
+
+void liberar_vetor(VetorOrdenado* v);
+void liberar_eytzinger(Eytzinger* e);
+void liberar_stree(STree* s);
+void liberar_veb(ArvoreVEB* a);
+
+// ==================== Tabela hash =======================
+
+// Endereçamento aberto no estilo das "Swiss tables": além do vetor de chaves há um byte de
+// controle por posição, com HASH_VAZIO ou os 7 bits baixos do hash da chave ali guardada. As
+// posições formam grupos de HASH_GRUPO; a busca compara os 16 bytes de controle de um grupo de uma
+// vez (SSE2) e só lê as chaves cujo byte bate. Sondagem linear de grupo em grupo.
+#define HASH_GRUPO 16
+#define HASH_VAZIO ((signed char)-128)
+
+typedef struct {
+    signed char* controle; // capacidade bytes, alinhado em 16
+    int* chaves;
+    size_t capacidade;     // potência de 2, no mínimo HASH_GRUPO
+    size_t quantidade;
+    double carga_maxima;   // quantidade / capacidade que dispara o redimensionamento
+    int redimensionamentos;
+} TabelaHash;
+
+// carga_maxima deve estar em (0, 1): sempre sobra uma posição vazia para encerrar as buscas.
+// Retornam 0, ou -1 sem memória.
+int iniciar_hash(TabelaHash* t, double carga_maxima);
+int inserir_hash(TabelaHash* t, int chave); // dobra a capacidade quando a carga passaria do máximo
+// Comparações = grupos de controle examinados + chaves comparadas (só as de byte igual).
+int buscar_hash(const TabelaHash* t, int chave);
+void liberar_hash(TabelaHash* t);
+
+// ==================== Pool de nós =======================
+
+// Nós de tamanho fixo guardados lado a lado num único bloco e identificados por um índice de 32
+// bits. Trocar os ponteiros de 64 bits por índices quase divide o nó por dois, e sem o cabeçalho
+// do malloc em cada nó sobra ainda mais. Não há free por nó: liberar_pool solta todos de uma vez.
+// Quando o bloco enche ele é realocado com o dobro do tamanho, então os índices continuam valendo
+// mas ponteiros para nós não.
+#define POOL_NULO 0u // o índice 0 nunca é entregue
+
+typedef struct {
+    char* nos;           // o nó i fica em nos + i * tamanho_no
+    uint32_t usados;     // próximo índice livre
+    uint32_t capacidade;
+    uint32_t tamanho_no;
+} PoolNos;
+
+void iniciar_pool(PoolNos* p, size_t tamanho_no);
+uint32_t alocar_no(PoolNos* p); // POOL_NULO sem memória
+void encolher_pool(PoolNos* p);  // devolve a sobra do bloco depois da montagem
+void liberar_pool(PoolNos* p);
+
+// Lista e BST de contagem.c no pool: mesmas operações e mesma contagem de comparações.
+typedef struct {
+    int chave;
+    uint32_t proximo;
+} NoListaPool; // 8 bytes, contra 16 (+ cabeçalho do malloc) do NoLista
+
+typedef struct {
+    PoolNos pool;
+    uint32_t cabeca;
+} ListaPool;
+
+typedef struct {
+    int chave;
+    uint32_t esquerda;
+    uint32_t direita;
+} NoArvorePool; // 12 bytes, contra 24 (+ cabeçalho do malloc) do NoArvore
+
+typedef struct {
+    PoolNos pool;
+    uint32_t raiz;
+} ArvorePool;
+
+void iniciar_lista_pool(ListaPool* l);
+int inserir_lista_pool(ListaPool* l, int chave); // 0, ou -1 sem memória
+int buscar_lista_pool(const ListaPool* l, int chave);
+void liberar_lista_pool(ListaPool* l);
+
+void iniciar_arvore_pool(ArvorePool* a);
+int inserir_arvore_pool(ArvorePool* a, int chave); // iterativa; 0, ou -1 sem memória
+int buscar_arvore_pool(const ArvorePool* a, int chave);
+void buscar_arvore_pool_lote(const ArvorePool* a, const int* chaves, int n, int* comparacoes);
+void liberar_arvore_pool(ArvorePool* a);
+
+// ==================== Estruturas concorrentes =======================
+
+// Conjuntos ordenados que aceitam buscas, inserções e remoções de várias threads ao mesmo tempo.
+// As funções que alteram a estrutura somam em *comparacoes as comparações feitas (contadas como
+// nas buscas: uma por nó visitado) e retornam 1 se a chave entrou (ou saiu), 0 se já estava (ou
+// não estava) e -1 sem memória. contar_* e liberar_* só podem rodar sem outras threads usando a
+// estrutura.
+
+// Skip list sem travas (Harris, Fraser): listas ordenadas em níveis, cada nó presente do nível 0
+// até uma altura sorteada, ligadas só com compare-and-swap. Para remover um nó, a thread marca o
+// bit baixo dos seus ponteiros "próximo"; a marca impede que alguém ligue algo depois dele, e
+// qualquer busca que passa por um nó marcado o desliga. Os nós removidos não são liberados na
+// hora (outra thread pode estar lendo): ficam numa pilha e saem em liberar_skiplist.
+typedef struct NoSkip NoSkip;
+
+typedef struct {
+    NoSkip* cabeca; // sentinela com a altura máxima, menor que todas as chaves
+    _Atomic(NoSkip*) retirados;
+} SkipList;
+
+int iniciar_skiplist(SkipList* l); // 0, ou -1 sem memória
+// aleatorio: bits sorteados pela thread; a altura do nó é 1 + o número de bits 1 seguidos no fim.
+int inserir_skiplist(SkipList* l, int chave, uint64_t aleatorio, int* comparacoes);
+int remover_skiplist(SkipList* l, int chave, int* comparacoes);
+int buscar_skiplist(const SkipList* l, int chave); // não trava nem espera: só lê
+long long contar_skiplist(const SkipList* l);
+void liberar_skiplist(SkipList* l);
+
+// BST com uma trava por nó, percorrida "de mão em mão": a thread só solta a trava do pai depois de
+// pegar a do filho, então ninguém passa à frente nem muda o trecho onde ela está. É a versão
+// concorrente mais direta da BST de contagem.c, e a referência para a skip list: todas as
+// operações, até as buscas, passam pela trava da raiz.
+typedef struct NoTravado NoTravado;
+
+typedef struct {
+    NoTravado* sentinela; // a raiz é o filho esquerdo da sentinela
+} ArvoreTravada;
+
+int iniciar_arvore_travada(ArvoreTravada* a); // 0, ou -1 sem memória
+int inserir_arvore_travada(ArvoreTravada* a, int chave, int* comparacoes);
+int remover_arvore_travada(ArvoreTravada* a, int chave, int* comparacoes);
+int buscar_arvore_travada(const ArvoreTravada* a, int chave);
+long long contar_arvore_travada(const ArvoreTravada* a);
+void liberar_arvore_travada(ArvoreTravada* a);
+
+// ==================== Contador de falhas de cache =======================
+
+// Falhas de cache do processo medidas pelo perf_event_open (Linux). Sem permissão ou fora do
+// Linux abrir_contador_cache retorna -1 e a medição fica de fora.
+int abrir_contador_cache(void);
+void iniciar_contador_cache(int contador);
+long long parar_contador_cache(int contador); // falhas desde o início, ou -1
+void fechar_contador_cache(int contador);
+
+// Bytes entregues pelo malloc e ainda não liberados (mallinfo2 da glibc, incluindo os cabeçalhos e
+// os blocos grandes feitos com mmap), ou 0 se o alocador não informa. A diferença antes e depois
+// de montar uma estrutura é a memória que ela ocupa.
+size_t memoria_alocada(void);
+
+// ==================== Tabela de estruturas (contagem.c) =======================
+
+// A lista e a BST são definidas em contagem.c.
+typedef struct NoLista NoLista;
+typedef struct NoArvore NoArvore;
+
+#define QUANT_ESTRUTURAS 11
+extern const char* nomes_estruturas[QUANT_ESTRUTURAS];
+
+// Todas as estruturas, para poder tratá-las pelo índice e (a ordem de nomes_estruturas).
+// Zeradas, nenhuma está montada.
+typedef struct {
+    NoLista* lista;
+    NoArvore* arvore;
+    NoAVL* avl;
+    NoRB* rb;
+    VetorOrdenado vetor;
+    Eytzinger eytzinger;
+    STree stree;
+    ArvoreVEB veb;
+    TabelaHash hash;
+    ListaPool lista_pool;
+    ArvorePool arvore_pool;
+    double carga_hash; // fator de carga máximo da tabela hash, escolhido antes da montagem
+} Estruturas;
+
+int construir_estrutura(Estruturas* s, int e, const int* valores, int n); // 0, ou -1 sem memória
+// Procura cada chave na estrutura e e guarda em comp[i] as comparações da busca i.
+void buscar_todas(const Estruturas* s, int e, const int* procuradas, int n, int* comp);
+// O mesmo com as buscas em lote (a lista, a BST, a AVL, a rubro-negra e a BST no pool); -1 se a
+// estrutura e não tem busca em lote.
+int buscar_todas_lote(const Estruturas* s, int e, const int* procuradas, int n, int* comp);
+void liberar_estruturas(Estruturas* s);
+
+// Tempo atual em nanossegundos, de um relógio monotônico.
+long long agora_ns(void);
+
+// ==================== Varredura (varredura.c) =======================
+
+// Modo ./contagem --varredura: argv[0] é o próprio "--varredura". Retorna o código de saída.
+int executar_varredura(int argc, char* argv[]);
+
+// A lista (e a BST com chaves ordenadas, que vira lista) gasta n/2 comparações por busca e a
+// inserção da BST é recursiva: acima deste tamanho essas combinações são puladas.
+#define LIMITE_LINEAR (1 << 16)
+int busca_linear(int e, int ordem); // 1 se a busca na estrutura e é linear com essa ordem
+
+// Leitura das opções, comum aos modos da linha de comando. Retornam 0, ou -1 (com a mensagem).
+// ler_lista marca em escolhidos[] os nomes da lista separada por vírgulas (sem diferenciar
+// maiúsculas); ler_quantidade aceita inteiros em [minimo, maximo]; ler_semente, qualquer inteiro
+// de 64 bits (também 0x...); ler_ordem, um dos nomes_ordens; ler_carga, um fator de carga da
+// tabela hash entre 0 e 1.
+int ler_lista(char* texto, const char* nomes[], int quant, int escolhidos[]);
+int ler_quantidade(const char* texto, long long minimo, long long maximo, long long* valor);
+int ler_semente(const char* texto, uint64_t* semente);
+int ler_ordem(const char* texto, int* ordem);
+int ler_carga(const char* texto, double* carga);
+
+// Roda trabalho(dados + i * tamanho) em 'threads' threads, com a atual fazendo a 0, e espera todas.
+// A barreira que elas usam para largar juntas é preparada antes e destruída no fim. Retorna -1 se
+// não conseguiu preparar a barreira.
+int rodar_threads(pthread_barrier_t* barreira, int threads, void* (*trabalho)(void*), void* dados, size_t tamanho);
+
+// Medição de tempos, também comum aos modos.
+int comparar_longos(const void* a, const void* b); // para o qsort de long long
+long long percentil(const long long* ordenado, int n, double p); // posto mais próximo
+long long custo_relogio(void); // ns de uma leitura de agora_ns, para descontar das latências
+
+// ==================== Buscas em paralelo (paralelo.c) =======================
+
+// Modo ./contagem --paralelo: argv[0] é o próprio "--paralelo". Retorna o código de saída.
+int executar_paralelo(int argc, char* argv[]);
+
+// ==================== Carga mista (mistura.c) =======================
+
+// Modo ./contagem --mistura: argv[0] é o próprio "--mistura". Retorna o código de saída.
+int executar_mistura(int argc, char* argv[]);
+
+#endif // ESTRUTURAS_H_INCLUDED
@@ -0,0 +1,44 @@
+// Converte um arquivo binário em colunas (gravado por contagem --binario) de volta para CSV.
+// Uso: ./ler_colunas dados_busca.bin > dados_busca.csv
+// O plot.R chama este programa quando encontra o arquivo binário.
+#include <stdio.h>
+#include <inttypes.h>
+
+#include "colunas.h"
+
+int main(int argc, char* argv[]) {
+    LeitorColunas leitor;
+
+    if (argc != 2) {
+        fprintf(stderr, "uso: %s arquivo.bin\n", argv[0]);
+        return 1;
+    }
+
+    if (abrir_leitor_colunas(&leitor, argv[1]) != 0) {
+        fprintf(stderr, "%s: arquivo em colunas inválido\n", argv[1]);
+        return 1;
+    }
+
+    // Cabeçalho do CSV com os nomes das colunas.
+    for (int c = 0; c < leitor.quant_colunas; c++)
+        printf("%s%s", c > 0 ? "," : "", leitor.nomes[c]);
+    printf("\n");
+
+    // Um grupo por vez: as colunas são lidas inteiras e as linhas remontadas na saída.
+    int linhas;
+    while ((linhas = ler_grupo(&leitor)) > 0) {
+        for (int i = 0; i < linhas; i++) {
+            for (int c = 0; c < leitor.quant_colunas; c++)
+                printf("%s%" PRId64, c > 0 ? "," : "", leitor.valores[(size_t)c * GRUPO_LINHAS + i]);
+            printf("\n");
+        }
+    }
+
+    fechar_leitor_colunas(&leitor);
+
+    if (linhas < 0) {
+        fprintf(stderr, "%s: arquivo corrompido ou truncado\n", argv[1]);
+        return 1;
+    }
+    return 0;
+}
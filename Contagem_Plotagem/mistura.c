@@ -0,0 +1,324 @@
+// Carga mista concorrente: ./contagem --mistura [opções].
+// Em vez de inserir tudo e depois só buscar, como contagem.c, várias threads fazem ao mesmo tempo
+// buscas, inserções e remoções sobre um conjunto que já começa com n chaves. As chaves das
+// operações saem de um universo de 2n chaves (metade presente no início) e inserções e remoções
+// vêm na mesma proporção, então o tamanho fica perto de n. Para cada estrutura concorrente de
+// concorrentes.c, proporção de buscas e número de threads a saída tem a vazão, a latência de cada
+// operação nos percentis 50, 99 e 99,9 e as comparações por operação, contadas como nas buscas de
+// contagem.c para poder comparar com o gráfico de lá.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "estruturas.h"
+#include "chaves.h"
+
+#define CONCORRENTE_SKIPLIST 0
+#define CONCORRENTE_ARVORE_TRAVADA 1
+#define QUANT_CONCORRENTES 2
+static const char* nomes_concorrentes[QUANT_CONCORRENTES] = {"SkipList", "BSTTravada"};
+
+#define OPERACAO_BUSCA 0
+#define OPERACAO_INSERCAO 1
+#define OPERACAO_REMOCAO 2
+
+// Proporções de buscas (em %) testadas sem a opção -l.
+static const char* proporcoes_padrao = "100,90,50";
+#define MAXIMO_PROPORCOES 16
+
+// Uma das estruturas concorrentes, escolhida pelo índice.
+typedef struct {
+    int estrutura;
+    SkipList skiplist;
+    ArvoreTravada arvore;
+} Conjunto;
+
+static int iniciar_conjunto(Conjunto* c, int estrutura) {
+    c->estrutura = estrutura;
+    if (estrutura == CONCORRENTE_SKIPLIST)
+        return iniciar_skiplist(&c->skiplist);
+    return iniciar_arvore_travada(&c->arvore);
+}
+
+// Executa uma operação e soma as comparações. Retorna o resultado da inserção ou da remoção
+// (1 se mudou o conjunto), ou 0 para as buscas.
+static int executar_operacao(Conjunto* c, int operacao, int chave, uint64_t aleatorio, int* comparacoes) {
+    if (c->estrutura == CONCORRENTE_SKIPLIST) {
+        switch (operacao) {
+        case OPERACAO_BUSCA: *comparacoes += buscar_skiplist(&c->skiplist, chave); return 0;
+        case OPERACAO_INSERCAO: return inserir_skiplist(&c->skiplist, chave, aleatorio, comparacoes);
+        default: return remover_skiplist(&c->skiplist, chave, comparacoes);
+        }
+    }
+    switch (operacao) {
+    case OPERACAO_BUSCA: *comparacoes += buscar_arvore_travada(&c->arvore, chave); return 0;
+    case OPERACAO_INSERCAO: return inserir_arvore_travada(&c->arvore, chave, comparacoes);
+    default: return remover_arvore_travada(&c->arvore, chave, comparacoes);
+    }
+}
+
+static long long contar_conjunto(const Conjunto* c) {
+    if (c->estrutura == CONCORRENTE_SKIPLIST)
+        return contar_skiplist(&c->skiplist);
+    return contar_arvore_travada(&c->arvore);
+}
+
+static void liberar_conjunto(Conjunto* c) {
+    if (c->estrutura == CONCORRENTE_SKIPLIST)
+        liberar_skiplist(&c->skiplist);
+    else
+        liberar_arvore_travada(&c->arvore);
+}
+
+// O que as threads de uma rodada compartilham. Cada thread usa só a sua fatia [inicio, fim) dos
+// vetores de operações e de latências.
+typedef struct {
+    Conjunto* conjunto;
+    const int* chaves;
+    const unsigned char* operacoes;
+    long long* latencias;
+    long long quant_operacoes;
+    int threads;
+    long long custo_relogio;
+    pthread_barrier_t largada;
+} Mistura;
+
+typedef struct {
+    Mistura* mistura;
+    int indice;
+    GeradorAleatorio gerador; // alturas dos nós da skip list
+    long long inicio, fim;    // relógio da thread
+    long long comparacoes;
+    long long mudancas;       // inserções menos remoções que mudaram o conjunto
+    int sem_memoria;
+} ThreadMistura;
+
+// Cada operação é cronometrada sozinha: a vazão inclui as duas leituras do relógio por operação,
+// o mesmo custo para as duas estruturas.
+static void* misturar(void* argumento) {
+    ThreadMistura* thread = (ThreadMistura*)argumento;
+    Mistura* m = thread->mistura;
+    long long inicio = m->quant_operacoes * thread->indice / m->threads;
+    long long fim = m->quant_operacoes * (thread->indice + 1) / m->threads;
+    int comparacoes = 0;
+    long long soma = 0;
+
+    thread->mudancas = 0;
+    thread->sem_memoria = 0;
+    pthread_barrier_wait(&m->largada);
+    thread->inicio = agora_ns();
+    for (long long i = inicio; i < fim; i++) {
+        int operacao = m->operacoes[i];
+        uint64_t aleatorio = (operacao == OPERACAO_INSERCAO) ? proximo_aleatorio(&thread->gerador) : 0;
+        comparacoes = 0;
+        long long t0 = agora_ns();
+        int resultado = executar_operacao(m->conjunto, operacao, m->chaves[i], aleatorio, &comparacoes);
+        long long t = agora_ns() - t0 - m->custo_relogio;
+        m->latencias[i] = t > 0 ? t : 0;
+        soma += comparacoes;
+        if (resultado < 0)
+            thread->sem_memoria = 1;
+        else if (resultado > 0)
+            thread->mudancas += (operacao == OPERACAO_INSERCAO) ? 1 : -1;
+    }
+    thread->fim = agora_ns();
+    thread->comparacoes = soma;
+    return NULL;
+}
+
+// Lê a lista de proporções de buscas, inteiros de 0 a 100 separados por vírgulas.
+static int ler_proporcoes(char* texto, int proporcoes[], int* quant) {
+    *quant = 0;
+    for (char* item = strtok(texto, ","); item != NULL; item = strtok(NULL, ",")) {
+        long long valor;
+        if (*quant == MAXIMO_PROPORCOES || ler_quantidade(item, 0, 100, &valor) != 0)
+            return -1;
+        proporcoes[(*quant)++] = (int)valor;
+    }
+    return (*quant > 0) ? 0 : -1;
+}
+
+// Uso: ./contagem --mistura [-n elementos] [-b operacoes] [-t threads] [-l buscas%,...]
+//                           [-e SkipList,BSTTravada] [-s semente] [--saida arquivo.csv]
+//   -n  chaves no conjunto antes das operações (padrão: 2^20)
+//   -b  operações em cada rodada, divididas entre as threads (padrão: 2^20)
+//   -t  maior número de threads (padrão: os núcleos disponíveis)
+//   -l  porcentagens de buscas testadas (padrão: 100,90,50); o resto é metade inserções, metade remoções
+int executar_mistura(int argc, char* argv[]) {
+    long long tamanho = 1 << 20, quant_operacoes = 1 << 20;
+    long long maximo_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    uint64_t semente = (uint64_t)time(NULL);
+    const char* caminho_saida = "mistura.csv";
+    int escolhidas[QUANT_CONCORRENTES] = {1, 1};
+    int proporcoes[MAXIMO_PROPORCOES], quant_proporcoes;
+    char texto_proporcoes[32];
+
+    snprintf(texto_proporcoes, sizeof(texto_proporcoes), "%s", proporcoes_padrao);
+    ler_proporcoes(texto_proporcoes, proporcoes, &quant_proporcoes);
+    if (maximo_threads < 1)
+        maximo_threads = 1;
+    if (maximo_threads > MAXIMO_THREADS)
+        maximo_threads = MAXIMO_THREADS;
+
+    for (int i = 1; i < argc; i++) {
+        int erro = 0;
+        if (i + 1 >= argc) {
+            erro = -1;
+        } else if (strcmp(argv[i], "-n") == 0) {
+            erro = ler_quantidade(argv[++i], 1, CHAVES_MAXIMO / 2, &tamanho);
+        } else if (strcmp(argv[i], "-b") == 0) {
+            erro = ler_quantidade(argv[++i], 1, 1LL << 30, &quant_operacoes);
+        } else if (strcmp(argv[i], "-t") == 0) {
+            erro = ler_quantidade(argv[++i], 1, MAXIMO_THREADS, &maximo_threads);
+        } else if (strcmp(argv[i], "-l") == 0) {
+            erro = ler_proporcoes(argv[++i], proporcoes, &quant_proporcoes);
+        } else if (strcmp(argv[i], "-e") == 0) {
+            erro = ler_lista(argv[++i], nomes_concorrentes, QUANT_CONCORRENTES, escolhidas);
+        } else if (strcmp(argv[i], "-s") == 0) {
+            erro = ler_semente(argv[++i], &semente);
+        } else if (strcmp(argv[i], "--saida") == 0) {
+            caminho_saida = argv[++i];
+        } else {
+            erro = -1;
+        }
+        if (erro != 0) {
+            fprintf(stderr, "uso: contagem --mistura [-n elementos] [-b operacoes] [-t threads] [-l buscas%%,...] "
+                            "[-e SkipList,BSTTravada] [-s semente] [--saida arquivo.csv]\n");
+            return 1;
+        }
+    }
+
+    FILE* saida = fopen(caminho_saida, "w");
+    int* valores = (int*)malloc((size_t)tamanho * sizeof(int));
+    int* chaves = (int*)malloc((size_t)quant_operacoes * sizeof(int));
+    unsigned char* operacoes = (unsigned char*)malloc((size_t)quant_operacoes);
+    long long* latencias = (long long*)malloc((size_t)quant_operacoes * sizeof(long long));
+    if (saida == NULL || valores == NULL || chaves == NULL || operacoes == NULL || latencias == NULL) {
+        perror("Falha ao preparar a carga mista");
+        if (saida != NULL)
+            fclose(saida);
+        free(valores);
+        free(chaves);
+        free(operacoes);
+        free(latencias);
+        return 1;
+    }
+
+    fprintf(saida, "Estrutura,Elementos,Operacoes,Threads,PorcentoBuscas,MilhoesOpsPorSegundo,"
+                   "LatenciaP50Ns,LatenciaP99Ns,LatenciaP999Ns,ComparacoesMedias\n");
+
+    GeradorAleatorio gerador;
+    semear_gerador(&gerador, semente);
+    gerar_chaves_unicas(valores, (uint32_t)tamanho, semente);
+    long long custo = custo_relogio();
+    int erros = 0;
+
+    printf("mistura: %lld elementos, %lld operacoes por rodada, ate %lld threads, semente %" PRIu64 "\n",
+           tamanho, quant_operacoes, maximo_threads, semente);
+    printf("%-12s %8s %9s %10s %10s %10s %12s %14s\n", "estrutura", "threads", "buscas %", "Mops/s", "p50 ns",
+           "p99 ns", "p99.9 ns", "comparacoes");
+
+    for (int p = 0; p < quant_proporcoes; p++) {
+        // A mesma sequência de operações para todas as estruturas e números de threads.
+        for (long long i = 0; i < quant_operacoes; i++) {
+            chaves[i] = chave_permutada(sortear_ate(&gerador, (uint32_t)(2 * tamanho)), semente);
+            if (sortear_ate(&gerador, 100) < (uint32_t)proporcoes[p])
+                operacoes[i] = OPERACAO_BUSCA;
+            else
+                operacoes[i] = (proximo_aleatorio(&gerador) >> 63) ? OPERACAO_INSERCAO : OPERACAO_REMOCAO;
+        }
+
+        for (int e = 0; e < QUANT_CONCORRENTES; e++) {
+            if (!escolhidas[e])
+                continue;
+            for (int threads = 1;; threads = (threads * 2 < maximo_threads) ? threads * 2 : (int)maximo_threads) {
+                // Um conjunto novo em cada rodada, com as mesmas n chaves iniciais.
+                Conjunto conjunto;
+                int comparacoes = 0;
+                if (iniciar_conjunto(&conjunto, e) != 0) {
+                    perror("Falha ao alocar memoria para as estruturas");
+                    return 1;
+                }
+                for (long long i = 0; i < tamanho; i++) {
+                    if (executar_operacao(&conjunto, OPERACAO_INSERCAO, valores[i], proximo_aleatorio(&gerador),
+                                          &comparacoes) < 0) {
+                        perror("Falha ao alocar memoria para as estruturas");
+                        return 1;
+                    }
+                }
+
+                Mistura mistura;
+                ThreadMistura dados[MAXIMO_THREADS];
+                mistura.conjunto = &conjunto;
+                mistura.chaves = chaves;
+                mistura.operacoes = operacoes;
+                mistura.latencias = latencias;
+                mistura.quant_operacoes = quant_operacoes;
+                mistura.threads = threads;
+                mistura.custo_relogio = custo;
+                for (int i = 0; i < threads; i++) {
+                    dados[i].mistura = &mistura;
+                    dados[i].indice = i;
+                    semear_gerador(&dados[i].gerador, semente + (uint64_t)i + 1);
+                }
+                if (rodar_threads(&mistura.largada, threads, misturar, dados, sizeof(ThreadMistura)) != 0)
+                    return 1;
+
+                long long inicio = dados[0].inicio, fim = dados[0].fim, soma = 0, mudancas = 0;
+                for (int i = 0; i < threads; i++) {
+                    inicio = dados[i].inicio < inicio ? dados[i].inicio : inicio;
+                    fim = dados[i].fim > fim ? dados[i].fim : fim;
+                    soma += dados[i].comparacoes;
+                    mudancas += dados[i].mudancas;
+                    if (dados[i].sem_memoria) {
+                        fprintf(stderr, "%s: faltou memoria durante as operacoes\n", nomes_concorrentes[e]);
+                        erros = 1;
+                    }
+                }
+
+                // Conferência: o conjunto tem de terminar com as chaves iniciais mais as inserções e
+                // menos as remoções que cada thread viu dar certo.
+                long long final = contar_conjunto(&conjunto);
+                if (final != tamanho + mudancas) {
+                    fprintf(stderr, "%s com %d threads: %lld chaves no fim, esperadas %lld\n", nomes_concorrentes[e],
+                            threads, final, tamanho + mudancas);
+                    erros = 1;
+                }
+                liberar_conjunto(&conjunto);
+
+                qsort(latencias, quant_operacoes, sizeof(long long), comparar_longos);
+                double vazao = (fim > inicio) ? quant_operacoes * 1e3 / (fim - inicio) : 0;
+                long long p50 = percentil(latencias, (int)quant_operacoes, 0.50);
+                long long p99 = percentil(latencias, (int)quant_operacoes, 0.99);
+                long long p999 = percentil(latencias, (int)quant_operacoes, 0.999);
+                double media = (double)soma / quant_operacoes;
+
+                printf("%-12s %8d %9d %10.2f %10lld %10lld %12lld %14.2f\n", nomes_concorrentes[e], threads,
+                       proporcoes[p], vazao, p50, p99, p999, media);
+                fprintf(saida, "%s,%lld,%lld,%d,%d,%.3f,%lld,%lld,%lld,%.2f\n", nomes_concorrentes[e], tamanho,
+                        quant_operacoes, threads, proporcoes[p], vazao, p50, p99, p999, media);
+                fflush(saida);
+
+                if (threads >= maximo_threads)
+                    break;
+            }
+        }
+    }
+
+    free(valores);
+    free(chaves);
+    free(operacoes);
+    free(latencias);
+
+    if (fclose(saida) != 0) {
+        perror("Erro ao gravar a carga mista");
+        return 1;
+    }
+    fprintf(stderr, "carga mista gravada em %s\n", caminho_saida);
+    return erros;
+}
@@ -0,0 +1,318 @@
+// Buscas em paralelo: ./contagem --paralelo [opções].
+// Cada estrutura é montada uma vez e depois consultada ao mesmo tempo por 1, 2, 4, ... threads, até
+// o número de núcleos. As buscas só leem a estrutura, então não há trava: cada thread pega uma fatia
+// das buscas e escreve apenas nos próprios contadores. A vazão com t threads dividida por t vezes a
+// vazão com uma é a eficiência; perto de 1 a busca escala, longe de 1 as threads disputam alguma
+// coisa. Duas delas aparecem na saída:
+// - falso compartilhamento: cada configuração roda com os contadores de cada thread numa linha de
+//   cache própria ("separados") e com os contadores lado a lado, quatro threads por linha
+//   ("vizinhos"); a diferença entre as duas é o custo das linhas de cache indo de núcleo em núcleo;
+// - banda da memória: com o contador de hardware, as falhas de cache de todas as threads vezes 64
+//   bytes, divididas pelo tempo, estimam os GB/s pedidos à memória; quando a vazão para de subir com
+//   esse número perto do limite da máquina, a estrutura está presa à banda, não à latência.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "estruturas.h"
+#include "chaves.h"
+
+// Buscas feitas de uma vez por buscar_todas antes de somar nos contadores.
+#define BLOCO_BUSCAS 256
+
+// Disposição dos contadores das threads.
+#define CONTADORES_SEPARADOS 0 // um por linha de cache
+#define CONTADORES_VIZINHOS 1  // lado a lado, dividindo linhas
+#define QUANT_DISPOSICOES 2
+static const char* nomes_disposicoes[QUANT_DISPOSICOES] = {"separados", "vizinhos"};
+
+// Contadores de uma thread, atualizados a cada busca como faria um serviço que conta as próprias
+// consultas. 16 bytes: quatro cabem numa linha de cache.
+typedef struct {
+    long long buscas;
+    long long comparacoes;
+} Contadores;
+
+// O que todas as threads de uma rodada compartilham (só lido por elas, menos os contadores).
+typedef struct {
+    const Estruturas* estruturas;
+    int estrutura;
+    const int* procuradas;
+    long long buscas;
+    int threads;
+    int repeticoes;
+    Contadores* contadores; // contadores da thread i em contadores[i * passo]
+    int passo;
+    long long* tempos;      // tempo de cada repetição, calculado pela thread 0
+    struct ThreadBusca* dados_threads;
+    pthread_barrier_t barreira;
+} Rodada;
+
+typedef struct ThreadBusca {
+    Rodada* rodada;
+    int indice;
+    long long inicio, fim;  // da fatia na repetição atual
+    long long falhas_cache; // de todas as repetições, ou -1 sem contador
+} ThreadBusca;
+
+// Trabalho de uma thread: em cada repetição espera as outras na barreira, faz a sua fatia das
+// buscas e espera de novo. O tempo da repetição vai do primeiro início ao último fim entre todas
+// as threads: com mais threads que núcleos uma delas pode passar da barreira bem depois das
+// outras, e o relógio de uma thread só mediria menos que o trabalho feito.
+static void* buscar_em_paralelo(void* argumento) {
+    ThreadBusca* thread = (ThreadBusca*)argumento;
+    Rodada* rodada = thread->rodada;
+    long long inicio = rodada->buscas * thread->indice / rodada->threads;
+    long long fim = rodada->buscas * (thread->indice + 1) / rodada->threads;
+    // volatile: cada busca grava nos contadores, em vez de o compilador somar num registrador e
+    // gravar só no fim (assim o falso compartilhamento aparece como apareceria no serviço).
+    volatile Contadores* contadores = rodada->contadores + (size_t)thread->indice * rodada->passo;
+    int comparacoes[BLOCO_BUSCAS];
+    // O perf_event_open com pid 0 conta só a thread que abriu o contador.
+    int contador = abrir_contador_cache();
+
+    thread->falhas_cache = 0;
+    for (int r = 0; r < rodada->repeticoes; r++) {
+        pthread_barrier_wait(&rodada->barreira);
+        thread->inicio = agora_ns();
+        iniciar_contador_cache(contador);
+        for (long long i = inicio; i < fim; i += BLOCO_BUSCAS) {
+            int quant = (int)(fim - i < BLOCO_BUSCAS ? fim - i : BLOCO_BUSCAS);
+            buscar_todas(rodada->estruturas, rodada->estrutura, rodada->procuradas + i, quant, comparacoes);
+            for (int j = 0; j < quant; j++) {
+                contadores->buscas++;
+                contadores->comparacoes += comparacoes[j];
+            }
+        }
+        long long falhas = parar_contador_cache(contador);
+        thread->fim = agora_ns();
+        thread->falhas_cache = (falhas < 0 || thread->falhas_cache < 0) ? -1 : thread->falhas_cache + falhas;
+        pthread_barrier_wait(&rodada->barreira);
+        // Depois da barreira todas já gravaram os seus tempos, e nenhuma grava de novo antes de a
+        // thread 0 chegar à barreira da próxima repetição.
+        if (thread->indice == 0) {
+            long long inicio = thread->inicio, fim = thread->fim;
+            for (int i = 1; i < rodada->threads; i++) {
+                const ThreadBusca* outra = &rodada->dados_threads[i];
+                inicio = outra->inicio < inicio ? outra->inicio : inicio;
+                fim = outra->fim > fim ? outra->fim : fim;
+            }
+            rodada->tempos[r] = fim - inicio;
+        }
+    }
+    fechar_contador_cache(contador);
+    return NULL;
+}
+
+// Resultado de uma rodada.
+typedef struct {
+    double milhoes_por_segundo; // pela mediana das repetições
+    long long falhas_cache;     // soma das threads, ou -1
+    long long tempo_total;      // soma das repetições, ns
+    long long buscas;           // somadas dos contadores
+    long long comparacoes;
+} Medicao;
+
+// Roda as buscas com 'threads' threads (a atual é a thread 0). Retorna -1 se não conseguiu preparar
+// a barreira.
+static int medir_rodada(Rodada* rodada, int threads, Contadores* contadores, int disposicao, Medicao* m) {
+    ThreadBusca dados[MAXIMO_THREADS];
+
+    rodada->threads = threads;
+    rodada->dados_threads = dados;
+    rodada->contadores = contadores;
+    rodada->passo = (disposicao == CONTADORES_SEPARADOS) ? LINHA_CACHE / (int)sizeof(Contadores) : 1;
+    memset(contadores, 0, (size_t)MAXIMO_THREADS * LINHA_CACHE);
+
+    for (int i = 0; i < threads; i++) {
+        dados[i].rodada = rodada;
+        dados[i].indice = i;
+    }
+    if (rodar_threads(&rodada->barreira, threads, buscar_em_paralelo, dados, sizeof(ThreadBusca)) != 0)
+        return -1;
+
+    m->falhas_cache = 0;
+    m->buscas = 0;
+    m->comparacoes = 0;
+    m->tempo_total = 0;
+    for (int i = 0; i < threads; i++) {
+        const Contadores* c = contadores + (size_t)i * rodada->passo;
+        m->buscas += c->buscas;
+        m->comparacoes += c->comparacoes;
+        m->falhas_cache = (dados[i].falhas_cache < 0 || m->falhas_cache < 0) ? -1 : m->falhas_cache + dados[i].falhas_cache;
+    }
+    for (int r = 0; r < rodada->repeticoes; r++)
+        m->tempo_total += rodada->tempos[r];
+    qsort(rodada->tempos, rodada->repeticoes, sizeof(long long), comparar_longos);
+    long long mediana = rodada->tempos[rodada->repeticoes / 2];
+    m->milhoes_por_segundo = mediana > 0 ? rodada->buscas * 1e3 / mediana : 0;
+    return 0;
+}
+
+// Uso: ./contagem --paralelo [-n elementos] [-b buscas] [-t threads] [-r repeticoes] [-e estruturas]
+//                            [-s semente] [-o ordem] [-c carga] [--saida arquivo.csv]
+//   -n  chaves em cada estrutura (padrão: 2^20, maior que a cache de último nível das máquinas comuns)
+//   -b  buscas em cada repetição, divididas entre as threads (padrão: 2^20)
+//   -t  maior número de threads (padrão: os núcleos disponíveis; mais que isso mede a disputa)
+int executar_paralelo(int argc, char* argv[]) {
+    long long tamanho = 1 << 20, buscas = 1 << 20, repeticoes = 5;
+    long long maximo_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    uint64_t semente = (uint64_t)time(NULL);
+    int ordem = ORDEM_ALEATORIA;
+    double carga_hash = 0.875;
+    const char* caminho_saida = "paralelo.csv";
+    int estruturas_escolhidas[QUANT_ESTRUTURAS];
+
+    if (maximo_threads < 1)
+        maximo_threads = 1;
+    if (maximo_threads > MAXIMO_THREADS)
+        maximo_threads = MAXIMO_THREADS;
+    for (int e = 0; e < QUANT_ESTRUTURAS; e++)
+        estruturas_escolhidas[e] = 1;
+
+    for (int i = 1; i < argc; i++) {
+        int erro = 0;
+        if (i + 1 >= argc) {
+            erro = -1;
+        } else if (strcmp(argv[i], "-n") == 0) {
+            erro = ler_quantidade(argv[++i], 1, CHAVES_MAXIMO - 1, &tamanho);
+        } else if (strcmp(argv[i], "-b") == 0) {
+            erro = ler_quantidade(argv[++i], 1, 1LL << 30, &buscas);
+        } else if (strcmp(argv[i], "-t") == 0) {
+            erro = ler_quantidade(argv[++i], 1, MAXIMO_THREADS, &maximo_threads);
+        } else if (strcmp(argv[i], "-r") == 0) {
+            erro = ler_quantidade(argv[++i], 1, 1000, &repeticoes);
+        } else if (strcmp(argv[i], "-e") == 0) {
+            erro = ler_lista(argv[++i], nomes_estruturas, QUANT_ESTRUTURAS, estruturas_escolhidas);
+        } else if (strcmp(argv[i], "-s") == 0) {
+            erro = ler_semente(argv[++i], &semente);
+        } else if (strcmp(argv[i], "-o") == 0) {
+            erro = ler_ordem(argv[++i], &ordem);
+        } else if (strcmp(argv[i], "-c") == 0) {
+            erro = ler_carga(argv[++i], &carga_hash);
+        } else if (strcmp(argv[i], "--saida") == 0) {
+            caminho_saida = argv[++i];
+        } else {
+            erro = -1;
+        }
+        if (erro != 0) {
+            fprintf(stderr, "uso: contagem --paralelo [-n elementos] [-b buscas] [-t threads] [-r repeticoes] "
+                            "[-e Lista,BST,...] [-s semente] [-o ordem] [-c carga] [--saida arquivo.csv]\n");
+            return 1;
+        }
+    }
+
+    FILE* saida = fopen(caminho_saida, "w");
+    int* valores = (int*)malloc((size_t)tamanho * sizeof(int));
+    int* procuradas = (int*)malloc((size_t)buscas * sizeof(int));
+    long long* tempos = (long long*)malloc((size_t)repeticoes * sizeof(long long));
+    Contadores* contadores = (Contadores*)aligned_alloc(LINHA_CACHE, (size_t)MAXIMO_THREADS * LINHA_CACHE);
+    if (saida == NULL || valores == NULL || procuradas == NULL || tempos == NULL || contadores == NULL) {
+        perror("Falha ao preparar as buscas em paralelo");
+        if (saida != NULL)
+            fclose(saida);
+        free(valores);
+        free(procuradas);
+        free(tempos);
+        free(contadores);
+        return 1;
+    }
+
+    fprintf(saida, "Estrutura,Ordem,Elementos,Buscas,Repeticoes,Threads,Contadores,MilhoesBuscasPorSegundo,"
+                   "Eficiencia,FalhasCachePorBusca,GBPorSegundoEstimado,ComparacoesMedias\n");
+
+    GeradorAleatorio gerador;
+    semear_gerador(&gerador, semente);
+    gerar_chaves_unicas(valores, (uint32_t)tamanho, semente);
+    // As buscas saem das chaves na ordem em que foram geradas (embaralhada), antes de reordenar.
+    for (long long i = 0; i < buscas; i++)
+        procuradas[i] = valores[sortear_ate(&gerador, (uint32_t)tamanho)];
+    ordenar_chaves(valores, (int)tamanho, ordem, &gerador);
+
+    Estruturas estruturas;
+    memset(&estruturas, 0, sizeof(estruturas));
+    estruturas.carga_hash = carga_hash;
+
+    printf("paralelo: %lld elementos, %lld buscas por repeticao, %lld repeticoes, ate %lld threads, "
+           "semente %" PRIu64 ", ordem %s\n", tamanho, buscas, repeticoes, maximo_threads, semente, nomes_ordens[ordem]);
+    printf("%-14s %8s %10s %12s %11s %14s %10s %14s\n", "estrutura", "threads", "contadores", "Mbuscas/s",
+           "eficiencia", "falhas/busca", "GB/s", "comparacoes");
+
+    for (int e = 0; e < QUANT_ESTRUTURAS; e++) {
+        if (!estruturas_escolhidas[e] || (busca_linear(e, ordem) && tamanho > LIMITE_LINEAR))
+            continue;
+        if (construir_estrutura(&estruturas, e, valores, (int)tamanho) != 0) {
+            fprintf(stderr, "%s: sem memoria para %lld elementos\n", nomes_estruturas[e], tamanho);
+            liberar_estruturas(&estruturas);
+            continue;
+        }
+
+        Rodada rodada;
+        rodada.estruturas = &estruturas;
+        rodada.estrutura = e;
+        rodada.procuradas = procuradas;
+        rodada.buscas = buscas;
+        rodada.repeticoes = (int)repeticoes;
+        rodada.tempos = tempos;
+
+        // Aquecimento com uma thread, para a estrutura estar na cache (o que couber) na primeira rodada.
+        Medicao m;
+        double vazao_uma[QUANT_DISPOSICOES] = {0, 0};
+        rodada.repeticoes = 1;
+        if (medir_rodada(&rodada, 1, contadores, CONTADORES_SEPARADOS, &m) != 0) {
+            liberar_estruturas(&estruturas);
+            continue;
+        }
+        rodada.repeticoes = (int)repeticoes;
+
+        // 1, 2, 4, ... threads e por fim o máximo, mesmo que não seja potência de 2.
+        for (int threads = 1;; threads = (threads * 2 < maximo_threads) ? threads * 2 : (int)maximo_threads) {
+            for (int d = 0; d < QUANT_DISPOSICOES; d++) {
+                if (medir_rodada(&rodada, threads, contadores, d, &m) != 0)
+                    continue;
+                if (threads == 1)
+                    vazao_uma[d] = m.milhoes_por_segundo;
+                double eficiencia = vazao_uma[d] > 0 ? m.milhoes_por_segundo / (threads * vazao_uma[d]) : 0;
+
+                // Sem contador de hardware, "n/d" na tela e NA no CSV, como no resumo de contagem.c.
+                char falhas[32], banda[32];
+                if (m.falhas_cache >= 0 && m.tempo_total > 0) {
+                    snprintf(falhas, sizeof(falhas), "%.3f", (double)m.falhas_cache / m.buscas);
+                    snprintf(banda, sizeof(banda), "%.2f", (double)m.falhas_cache * LINHA_CACHE / m.tempo_total);
+                } else {
+                    snprintf(falhas, sizeof(falhas), "NA");
+                    snprintf(banda, sizeof(banda), "NA");
+                }
+                double media = m.buscas > 0 ? (double)m.comparacoes / m.buscas : 0;
+
+                printf("%-14s %8d %10s %12.2f %11.3f %14s %10s %14.2f\n", nomes_estruturas[e], threads,
+                       nomes_disposicoes[d], m.milhoes_por_segundo, eficiencia, m.falhas_cache >= 0 ? falhas : "n/d",
+                       m.falhas_cache >= 0 ? banda : "n/d", media);
+                fprintf(saida, "%s,%s,%lld,%lld,%lld,%d,%s,%.3f,%.3f,%s,%s,%.2f\n", nomes_estruturas[e],
+                        nomes_ordens[ordem], tamanho, buscas, repeticoes, threads, nomes_disposicoes[d],
+                        m.milhoes_por_segundo, eficiencia, falhas, banda, media);
+            }
+            if (threads >= maximo_threads)
+                break;
+        }
+        fflush(saida);
+        liberar_estruturas(&estruturas);
+    }
+
+    free(valores);
+    free(procuradas);
+    free(tempos);
+    free(contadores);
+
+    if (fclose(saida) != 0) {
+        perror("Erro ao gravar as buscas em paralelo");
+        return 1;
+    }
+    fprintf(stderr, "buscas em paralelo gravadas em %s\n", caminho_saida);
+    return 0;
+}
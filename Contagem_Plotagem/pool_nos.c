@@ -0,0 +1,152 @@
+// Pool de nós num bloco contíguo, e a lista e a BST de contagem.c refeitas sobre ele com ligações
+// por índice de 32 bits (ver estruturas.h).
+// Com malloc cada nó da BST ocupa 24 bytes mais os 8 do cabeçalho, arredondados para 32, e fica
+// onde o alocador achar lugar; no pool ocupa 12 e os nós inseridos em seguida ficam lado a lado.
+// Um bloco só (e não uma tabela de blocos) mantém a busca com uma leitura de memória por nó,
+// como com ponteiros: o endereço base fica num registrador durante todo o percurso.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "estruturas.h"
+
+// Nós do pool vistos com o tipo certo (o tamanho vira constante na conta do endereço).
+#define NOS_LISTA(l) ((NoListaPool*)(l)->pool.nos)
+#define NOS_ARVORE(a) ((NoArvorePool*)(a)->pool.nos)
+
+// ==================== Pool =======================
+
+void iniciar_pool(PoolNos* p, size_t tamanho_no) {
+    p->nos = NULL;
+    p->usados = 1; // o índice 0 é o POOL_NULO
+    p->capacidade = 0;
+    p->tamanho_no = (uint32_t)tamanho_no;
+}
+
+// Devolve o índice de um nó novo. Só quando o bloco enche é que há um realloc, dobrando a
+// capacidade: o custo de copiar fica O(1) por nó, em média.
+uint32_t alocar_no(PoolNos* p) {
+    if (p->usados >= p->capacidade) {
+        if (p->capacidade == UINT32_MAX)
+            return POOL_NULO; // acabaram os índices
+        uint32_t capacidade = p->capacidade ? p->capacidade : 1024;
+        capacidade = (capacidade > UINT32_MAX / 2) ? UINT32_MAX : 2 * capacidade;
+        char* nos = (char*)realloc(p->nos, (size_t)capacidade * p->tamanho_no);
+        if (nos == NULL)
+            return POOL_NULO;
+        p->nos = nos;
+        p->capacidade = capacidade;
+    }
+    return p->usados++;
+}
+
+void encolher_pool(PoolNos* p) {
+    if (p->nos == NULL || p->usados == p->capacidade)
+        return;
+    char* nos = (char*)realloc(p->nos, (size_t)p->usados * p->tamanho_no);
+    if (nos != NULL) {
+        p->nos = nos;
+        p->capacidade = p->usados;
+    }
+}
+
+// Libera todos os nós de uma vez: um free só, sem percorrer a estrutura.
+void liberar_pool(PoolNos* p) {
+    free(p->nos);
+    p->nos = NULL;
+    p->usados = 1;
+    p->capacidade = 0;
+}
+
+// ==================== Lista no pool =======================
+
+void iniciar_lista_pool(ListaPool* l) {
+    iniciar_pool(&l->pool, sizeof(NoListaPool));
+    l->cabeca = POOL_NULO;
+}
+
+// Insere no início, como inserir_lista.
+int inserir_lista_pool(ListaPool* l, int chave) {
+    uint32_t i = alocar_no(&l->pool);
+    if (i == POOL_NULO)
+        return -1;
+    NOS_LISTA(l)[i].chave = chave;
+    NOS_LISTA(l)[i].proximo = l->cabeca;
+    l->cabeca = i;
+    return 0;
+}
+
+// Uma comparação por nó visitado, como buscar_lista.
+int buscar_lista_pool(const ListaPool* l, int chave) {
+    const NoListaPool* nos = NOS_LISTA(l);
+    int comparacoes = 0;
+    uint32_t atual = l->cabeca;
+    while (atual != POOL_NULO) {
+        comparacoes++;
+        if (nos[atual].chave == chave)
+            return comparacoes;
+        atual = nos[atual].proximo;
+    }
+    return comparacoes;
+}
+
+void liberar_lista_pool(ListaPool* l) {
+    liberar_pool(&l->pool);
+    l->cabeca = POOL_NULO;
+}
+
+// ==================== BST no pool =======================
+
+void iniciar_arvore_pool(ArvorePool* a) {
+    iniciar_pool(&a->pool, sizeof(NoArvorePool));
+    a->raiz = POOL_NULO;
+}
+
+// Inserção iterativa, sem recursão: chaves ordenadas (árvore degenerada) não estouram a pilha.
+// O nó é alocado antes da descida porque a alocação pode mover o bloco; se a chave já existir,
+// ele é devolvido (é o último do pool).
+int inserir_arvore_pool(ArvorePool* a, int chave) {
+    uint32_t novo = alocar_no(&a->pool);
+    if (novo == POOL_NULO)
+        return -1;
+
+    NoArvorePool* nos = NOS_ARVORE(a);
+    uint32_t* ligacao = &a->raiz;
+    while (*ligacao != POOL_NULO) {
+        NoArvorePool* no = &nos[*ligacao];
+        if (chave == no->chave) {
+            a->pool.usados--; // chave repetida: nada muda
+            return 0;
+        }
+        ligacao = (chave < no->chave) ? &no->esquerda : &no->direita;
+    }
+
+    nos[novo].chave = chave;
+    nos[novo].esquerda = nos[novo].direita = POOL_NULO;
+    *ligacao = novo;
+    return 0;
+}
+
+// Uma comparação por nó visitado, como buscar_arvore.
+int buscar_arvore_pool(const ArvorePool* a, int chave) {
+    const NoArvorePool* nos = NOS_ARVORE(a);
+    int comparacoes = 0;
+    uint32_t atual = a->raiz;
+    while (atual != POOL_NULO) {
+        comparacoes++;
+        if (chave == nos[atual].chave)
+            return comparacoes;
+        atual = (chave < nos[atual].chave) ? nos[atual].esquerda : nos[atual].direita;
+    }
+    return comparacoes;
+}
+
+// Busca em lote, como buscar_arvore_lote de contagem.c, com índices no lugar dos ponteiros.
+#define RAIZ_POOL(a) ((a)->raiz)
+#define NO_POOL(a, i) (NOS_ARVORE(a)[i])
+DEFINIR_BUSCA_LOTE(buscar_arvore_pool_lote, const ArvorePool*, uint32_t, POOL_NULO, RAIZ_POOL, NO_POOL)
+
+void liberar_arvore_pool(ArvorePool* a) {
+    liberar_pool(&a->pool);
+    a->raiz = POOL_NULO;
+}
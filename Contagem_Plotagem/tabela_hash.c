@@ -0,0 +1,166 @@
+// Tabela hash com endereçamento aberto e bytes de controle (ver estruturas.h).
+// Uma busca bem-sucedida costuma custar um grupo e uma chave, seja qual for n: é o caso de
+// comparação com as estruturas ordenadas, que pagam log n comparações por busca.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "estruturas.h"
+
+// Espalha os bits da chave (finalizador do MurmurHash3): chaves sequenciais ou só com os bits
+// altos diferentes também caem em grupos diferentes.
+static uint64_t espalhar(int chave) {
+    uint64_t h = (uint32_t)chave;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// Byte de controle da chave: os 7 bits baixos do hash (nunca negativo, então nunca HASH_VAZIO).
+static signed char byte_controle(uint64_t h) {
+    return (signed char)(h & 0x7F);
+}
+
+// Grupo onde a sondagem começa: os bits acima dos 7 do byte de controle.
+static size_t grupo_inicial(const TabelaHash* t, uint64_t h) {
+    return (size_t)(h >> 7) & (t->capacidade / HASH_GRUPO - 1);
+}
+
+// Máscara com um bit para cada posição do grupo cujo byte de controle é igual a 'byte'.
+static unsigned bytes_iguais(const signed char* grupo, signed char byte) {
+#ifdef __SSE2__
+    __m128i controle = _mm_load_si128((const __m128i*)grupo);
+    return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(controle, _mm_set1_epi8(byte)));
+#else
+    unsigned mascara = 0;
+    for (int j = 0; j < HASH_GRUPO; j++)
+        mascara |= (unsigned)(grupo[j] == byte) << j;
+    return mascara;
+#endif
+}
+
+// Aloca vetores vazios com a capacidade pedida.
+static int alocar_hash(TabelaHash* t, size_t capacidade) {
+    t->controle = (signed char*)aligned_alloc(HASH_GRUPO, capacidade);
+    t->chaves = (int*)malloc(capacidade * sizeof(int));
+    if (t->controle == NULL || t->chaves == NULL) {
+        free(t->controle);
+        free(t->chaves);
+        t->controle = NULL;
+        t->chaves = NULL;
+        return -1;
+    }
+    memset(t->controle, HASH_VAZIO, capacidade);
+    t->capacidade = capacidade;
+    t->quantidade = 0;
+    return 0;
+}
+
+// Coloca uma chave que com certeza não está na tabela na primeira posição vazia da sondagem.
+static void colocar(TabelaHash* t, int chave, uint64_t h) {
+    size_t mascara_grupos = t->capacidade / HASH_GRUPO - 1;
+    size_t g = grupo_inicial(t, h);
+
+    for (;;) {
+        signed char* grupo = t->controle + g * HASH_GRUPO;
+        unsigned vazios = bytes_iguais(grupo, HASH_VAZIO);
+        if (vazios != 0) {
+            int j = __builtin_ctz(vazios);
+            grupo[j] = byte_controle(h);
+            t->chaves[g * HASH_GRUPO + j] = chave;
+            t->quantidade++;
+            return;
+        }
+        g = (g + 1) & mascara_grupos;
+    }
+}
+
+// Dobra a capacidade e reinsere todas as chaves.
+static int crescer(TabelaHash* t) {
+    TabelaHash antiga = *t;
+
+    if (alocar_hash(t, antiga.capacidade * 2) != 0) {
+        *t = antiga;
+        return -1;
+    }
+    for (size_t i = 0; i < antiga.capacidade; i++)
+        if (antiga.controle[i] != HASH_VAZIO)
+            colocar(t, antiga.chaves[i], espalhar(antiga.chaves[i]));
+
+    free(antiga.controle);
+    free(antiga.chaves);
+    t->redimensionamentos++;
+    return 0;
+}
+
+int iniciar_hash(TabelaHash* t, double carga_maxima) {
+    memset(t, 0, sizeof(TabelaHash));
+    if (!(carga_maxima > 0.0 && carga_maxima < 1.0))
+        return -1;
+    t->carga_maxima = carga_maxima;
+    return alocar_hash(t, HASH_GRUPO);
+}
+
+// Percorre os grupos a partir do inicial: em cada um compara só as chaves de byte igual e para no
+// primeiro grupo com posição vazia (a chave teria sido colocada ali).
+int buscar_hash(const TabelaHash* t, int chave) {
+    uint64_t h = espalhar(chave);
+    signed char byte = byte_controle(h);
+    size_t mascara_grupos = t->capacidade / HASH_GRUPO - 1;
+    size_t g = grupo_inicial(t, h);
+    int comparacoes = 0;
+
+    for (size_t passo = 0; passo <= mascara_grupos; passo++) {
+        const signed char* grupo = t->controle + g * HASH_GRUPO;
+        unsigned iguais = bytes_iguais(grupo, byte);
+        comparacoes++; // os 16 bytes de controle
+        while (iguais != 0) {
+            comparacoes++;
+            if (t->chaves[g * HASH_GRUPO + __builtin_ctz(iguais)] == chave)
+                return comparacoes;
+            iguais &= iguais - 1;
+        }
+        if (bytes_iguais(grupo, HASH_VAZIO) != 0)
+            return comparacoes;
+        g = (g + 1) & mascara_grupos;
+    }
+    return comparacoes;
+}
+
+// Como nas árvores, chave repetida não muda nada.
+int inserir_hash(TabelaHash* t, int chave) {
+    uint64_t h = espalhar(chave);
+    size_t mascara_grupos = t->capacidade / HASH_GRUPO - 1;
+    size_t g = grupo_inicial(t, h);
+
+    for (size_t passo = 0; passo <= mascara_grupos; passo++) {
+        const signed char* grupo = t->controle + g * HASH_GRUPO;
+        unsigned iguais = bytes_iguais(grupo, byte_controle(h));
+        for (; iguais != 0; iguais &= iguais - 1)
+            if (t->chaves[g * HASH_GRUPO + __builtin_ctz(iguais)] == chave)
+                return 0;
+        if (bytes_iguais(grupo, HASH_VAZIO) != 0)
+            break;
+        g = (g + 1) & mascara_grupos;
+    }
+
+    if ((double)(t->quantidade + 1) > t->carga_maxima * (double)t->capacidade && crescer(t) != 0)
+        return -1;
+    colocar(t, chave, h);
+    return 0;
+}
+
+void liberar_hash(TabelaHash* t) {
+    free(t->controle);
+    free(t->chaves);
+    t->controle = NULL;
+    t->chaves = NULL;
+}
@@ -0,0 +1,397 @@
+// Varredura de tamanhos, estruturas e distribuições de consulta: ./contagem --varredura [opções].
+// Para cada tamanho (potências de 2) monta uma estrutura por vez, roda as buscas de cada
+// distribuição com aquecimento e repetições e grava uma linha por medição em varredura.csv, no
+// formato "arrumado" que o plot.R usa direto nas facetas. Nas estruturas com busca em lote, as
+// mesmas buscas rodam também em lote, e a linha traz o tempo e a aceleração sobre a busca uma a uma.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <time.h>
+#include <inttypes.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "estruturas.h"
+#include "chaves.h"
+
+// Distribuições das chaves procuradas.
+#define CONSULTA_UNIFORME 0  // qualquer chave inserida, com a mesma chance
+#define CONSULTA_ZIPF 1      // poucas chaves muito procuradas (Zipf com expoente 1)
+#define CONSULTA_AUSENTES 2  // 90% das buscas por chaves que não estão na estrutura
+#define QUANT_CONSULTAS 3
+static const char* nomes_consultas[QUANT_CONSULTAS] = {"uniforme", "zipf", "ausentes"};
+#define PROPORCAO_AUSENTES 0.9
+
+// Maior tamanho aceito: metade das chaves de 31 bits fica livre para as buscas ausentes.
+#define TAMANHO_LIMITE (1 << 30)
+
+// Memória aproximada por chave de cada estrutura durante a montagem (nós com o cabeçalho do
+// malloc, cópia ordenada das estáticas, as duas tabelas durante o redimensionamento da hash).
+// Serve para escolher o maior tamanho que cabe na RAM.
+static const int bytes_por_chave[QUANT_ESTRUTURAS] = {32, 32, 32, 48, 8, 8, 8, 20, 24, 8, 12};
+
+// Estrutura e cuja busca é linear com essas chaves: as listas, e as BSTs com chaves ordenadas.
+int busca_linear(int e, int ordem) {
+    return e == 0 || e == 9 || ((e == 1 || e == 10) && ordem != ORDEM_ALEATORIA);
+}
+
+// Memória física da máquina em bytes (0 se não der para saber).
+static unsigned long long memoria_fisica(void) {
+    long paginas = sysconf(_SC_PHYS_PAGES);
+    long tamanho_pagina = sysconf(_SC_PAGESIZE);
+    if (paginas <= 0 || tamanho_pagina <= 0)
+        return 0;
+    return (unsigned long long)paginas * (unsigned long long)tamanho_pagina;
+}
+
+// Lê uma lista separada por vírgulas de nomes e marca os escolhidos. Retorna -1 se algum nome
+// não existir.
+int ler_lista(char* texto, const char* nomes[], int quant, int escolhidos[]) {
+    memset(escolhidos, 0, (size_t)quant * sizeof(int));
+    for (char* nome = strtok(texto, ","); nome != NULL; nome = strtok(NULL, ",")) {
+        int achou = 0;
+        for (int i = 0; i < quant; i++) {
+            if (strcasecmp(nome, nomes[i]) == 0) {
+                escolhidos[i] = 1;
+                achou = 1;
+            }
+        }
+        if (!achou) {
+            fprintf(stderr, "nome invalido: %s\n", nome);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int ler_quantidade(const char* texto, long long minimo, long long maximo, long long* valor) {
+    char* fim;
+    *valor = strtoll(texto, &fim, 10);
+    if (*fim != '\0' || *valor < minimo || *valor > maximo) {
+        fprintf(stderr, "quantidade invalida: %s\n", texto);
+        return -1;
+    }
+    return 0;
+}
+
+int ler_semente(const char* texto, uint64_t* semente) {
+    char* fim;
+    *semente = strtoull(texto, &fim, 0);
+    if (*fim != '\0') {
+        fprintf(stderr, "semente invalida: %s\n", texto);
+        return -1;
+    }
+    return 0;
+}
+
+int ler_ordem(const char* texto, int* ordem) {
+    for (int o = 0; o < QUANT_ORDENS; o++) {
+        if (strcmp(texto, nomes_ordens[o]) == 0) {
+            *ordem = o;
+            return 0;
+        }
+    }
+    fprintf(stderr, "ordem invalida: %s (use aleatoria, crescente, decrescente ou zipf)\n", texto);
+    return -1;
+}
+
+int ler_carga(const char* texto, double* carga) {
+    char* fim;
+    *carga = strtod(texto, &fim);
+    if (*fim != '\0' || !(*carga > 0.0 && *carga < 1.0)) {
+        fprintf(stderr, "fator de carga invalido: %s (use um valor entre 0 e 1)\n", texto);
+        return -1;
+    }
+    return 0;
+}
+
+int rodar_threads(pthread_barrier_t* barreira, int threads, void* (*trabalho)(void*), void* dados, size_t tamanho) {
+    pthread_t ids[MAXIMO_THREADS];
+
+    if (pthread_barrier_init(barreira, NULL, (unsigned)threads) != 0) {
+        fprintf(stderr, "Falha ao preparar a barreira de %d threads\n", threads);
+        return -1;
+    }
+    for (int i = 1; i < threads; i++) {
+        if (pthread_create(&ids[i], NULL, trabalho, (char*)dados + (size_t)i * tamanho) != 0) {
+            // As já criadas esperam na barreira por todas: não há como seguir.
+            perror("Falha ao criar as threads");
+            exit(1);
+        }
+    }
+    trabalho(dados);
+    for (int i = 1; i < threads; i++)
+        pthread_join(ids[i], NULL);
+    pthread_barrier_destroy(barreira);
+    return 0;
+}
+
+int comparar_longos(const void* a, const void* b) {
+    long long x = *(const long long*)a, y = *(const long long*)b;
+    return (x > y) - (x < y);
+}
+
+// Percentil pelo posto mais próximo de um vetor já ordenado.
+long long percentil(const long long* ordenado, int n, double p) {
+    int posto = (int)(p * n + 0.999999);
+    if (posto < 1)
+        posto = 1;
+    return ordenado[posto - 1];
+}
+
+// Custo de uma leitura do relógio, para descontar das latências de uma busca só: a mediana de
+// várias leituras seguidas.
+long long custo_relogio(void) {
+    long long amostras[1001];
+    for (int i = 0; i < 1001; i++) {
+        long long t0 = agora_ns();
+        amostras[i] = agora_ns() - t0;
+    }
+    qsort(amostras, 1001, sizeof(long long), comparar_longos);
+    return amostras[500];
+}
+
+// Sorteia as chaves procuradas da distribuição c. 'valores' está na ordem em que as chaves foram
+// geradas (embaralhada), então as chaves populares do Zipf ficam espalhadas pelo intervalo.
+static void sortear_consultas(int* procuradas, int buscas, int c, const int* valores, int n,
+                              uint64_t semente, GeradorAleatorio* gerador) {
+    for (int i = 0; i < buscas; i++) {
+        if (c == CONSULTA_ZIPF) {
+            // Inversa da distribuição contínua 1/x em [1, n + 1): posto r tem chance ~ 1/(r + 1).
+            double u = sortear_real(gerador);
+            long long posto = (long long)exp(u * log((double)n + 1.0)) - 1;
+            procuradas[i] = valores[posto < n ? posto : n - 1];
+        } else if (c == CONSULTA_AUSENTES && sortear_real(gerador) <= PROPORCAO_AUSENTES) {
+            // Índices da permutação a partir de n: chaves que nunca foram inseridas.
+            procuradas[i] = chave_permutada((uint32_t)n + sortear_ate(gerador, (uint32_t)n), semente);
+        } else {
+            procuradas[i] = valores[sortear_ate(gerador, (uint32_t)n)];
+        }
+    }
+}
+
+// Uso: ./contagem --varredura [--min n] [--max n] [-e estruturas] [-q consultas] [-b buscas]
+//                             [-r repeticoes] [-a aquecimento] [-s semente] [-o ordem] [-c carga]
+//                             [--saida arquivo.csv]
+int executar_varredura(int argc, char* argv[]) {
+    long long minimo = 1024, maximo = 0; // 0: o maior que cabe na memória
+    long long buscas = 10000, repeticoes = 5, aquecimento = 1;
+    uint64_t semente = (uint64_t)time(NULL);
+    int ordem = ORDEM_ALEATORIA;
+    double carga_hash = 0.875;
+    const char* caminho_saida = "varredura.csv";
+    int estruturas_escolhidas[QUANT_ESTRUTURAS], consultas_escolhidas[QUANT_CONSULTAS];
+
+    for (int e = 0; e < QUANT_ESTRUTURAS; e++)
+        estruturas_escolhidas[e] = 1;
+    for (int c = 0; c < QUANT_CONSULTAS; c++)
+        consultas_escolhidas[c] = 1;
+
+    for (int i = 1; i < argc; i++) {
+        int erro = 0;
+        if (i + 1 >= argc) {
+            erro = -1;
+        } else if (strcmp(argv[i], "--min") == 0) {
+            erro = ler_quantidade(argv[++i], 1, TAMANHO_LIMITE, &minimo);
+        } else if (strcmp(argv[i], "--max") == 0) {
+            erro = ler_quantidade(argv[++i], 1, TAMANHO_LIMITE, &maximo);
+        } else if (strcmp(argv[i], "-e") == 0) {
+            erro = ler_lista(argv[++i], nomes_estruturas, QUANT_ESTRUTURAS, estruturas_escolhidas);
+        } else if (strcmp(argv[i], "-q") == 0) {
+            erro = ler_lista(argv[++i], nomes_consultas, QUANT_CONSULTAS, consultas_escolhidas);
+        } else if (strcmp(argv[i], "-b") == 0) {
+            erro = ler_quantidade(argv[++i], 1, 1LL << 30, &buscas);
+        } else if (strcmp(argv[i], "-r") == 0) {
+            erro = ler_quantidade(argv[++i], 1, 1000, &repeticoes);
+        } else if (strcmp(argv[i], "-a") == 0) {
+            erro = ler_quantidade(argv[++i], 0, 1000, &aquecimento);
+        } else if (strcmp(argv[i], "-s") == 0) {
+            erro = ler_semente(argv[++i], &semente);
+        } else if (strcmp(argv[i], "-o") == 0) {
+            erro = ler_ordem(argv[++i], &ordem);
+        } else if (strcmp(argv[i], "-c") == 0) {
+            erro = ler_carga(argv[++i], &carga_hash);
+        } else if (strcmp(argv[i], "--saida") == 0) {
+            caminho_saida = argv[++i];
+        } else {
+            erro = -1;
+        }
+        if (erro != 0) {
+            fprintf(stderr, "uso: contagem --varredura [--min n] [--max n] [-e Lista,BST,...] "
+                            "[-q uniforme,zipf,ausentes] [-b buscas] [-r repeticoes] [-a aquecimento] "
+                            "[-s semente] [-o ordem] [-c carga] [--saida arquivo.csv]\n");
+            return 1;
+        }
+    }
+
+    // Sem --max: o maior tamanho em que a estrutura mais gulosa (das que rodam em tamanhos grandes)
+    // ainda cabe na metade da memória, contando as chaves, as chaves na ordem de inserção e as buscas.
+    if (maximo == 0) {
+        unsigned long long memoria = memoria_fisica() / 2;
+        int maior = 0;
+        for (int e = 0; e < QUANT_ESTRUTURAS; e++)
+            if (estruturas_escolhidas[e] && !busca_linear(e, ordem) && bytes_por_chave[e] > maior)
+                maior = bytes_por_chave[e];
+        maximo = LIMITE_LINEAR;
+        if (maior > 0 && memoria > 0)
+            while (maximo * 2 <= TAMANHO_LIMITE && (unsigned long long)(maximo * 2) * (maior + 8) <= memoria)
+                maximo *= 2;
+    }
+    if (maximo < minimo)
+        maximo = minimo;
+
+    FILE* saida = fopen(caminho_saida, "w");
+    int* valores = (int*)malloc((size_t)maximo * sizeof(int));
+    int* insercao = (int*)malloc((size_t)maximo * sizeof(int));
+    int* procuradas = (int*)malloc((size_t)QUANT_CONSULTAS * buscas * sizeof(int)); // uma fileira por distribuição
+    int* comparacoes = (int*)malloc((size_t)buscas * sizeof(int));
+    int* comparacoes_lote = (int*)malloc((size_t)buscas * sizeof(int));
+    long long* latencias = (long long*)malloc((size_t)buscas * sizeof(long long));
+    long long* tempos = (long long*)malloc((size_t)repeticoes * sizeof(long long));
+    if (saida == NULL || valores == NULL || insercao == NULL || procuradas == NULL || comparacoes == NULL ||
+        comparacoes_lote == NULL || latencias == NULL || tempos == NULL) {
+        perror("Falha ao preparar a varredura");
+        if (saida != NULL)
+            fclose(saida);
+        free(valores);
+        free(insercao);
+        free(procuradas);
+        free(comparacoes);
+        free(comparacoes_lote);
+        free(latencias);
+        free(tempos);
+        return 1;
+    }
+
+    fprintf(saida, "Estrutura,Ordem,Consulta,Elementos,Buscas,Repeticoes,InsercaoMs,NsPorBuscaMediana,"
+                   "NsPorBuscaMinimo,BytesPorChave,LatenciaP50Ns,LatenciaP90Ns,LatenciaP99Ns,FalhasCachePorBusca,ComparacoesMedias,"
+                   "NsPorBuscaLote,AceleracaoLote\n");
+
+    GeradorAleatorio gerador;
+    semear_gerador(&gerador, semente);
+    long long custo = custo_relogio();
+    int contador = abrir_contador_cache();
+    Estruturas estruturas;
+    memset(&estruturas, 0, sizeof(estruturas));
+    estruturas.carga_hash = carga_hash;
+
+    fprintf(stderr, "varredura: %lld a %lld elementos, %lld buscas, %lld repeticoes, semente %" PRIu64 ", ordem %s\n",
+            minimo, maximo, buscas, repeticoes, semente, nomes_ordens[ordem]);
+
+    for (long long n = minimo; n <= maximo; n *= 2) {
+        gerar_chaves_unicas(valores, (uint32_t)n, semente);
+        memcpy(insercao, valores, (size_t)n * sizeof(int));
+        ordenar_chaves(insercao, (int)n, ordem, &gerador);
+
+        // As chaves procuradas são sorteadas uma vez por tamanho, antes das estruturas: todas buscam
+        // exatamente as mesmas chaves, e escolher outras estruturas em -e não muda o sorteio.
+        for (int c = 0; c < QUANT_CONSULTAS; c++)
+            if (consultas_escolhidas[c])
+                sortear_consultas(procuradas + (size_t)c * buscas, (int)buscas, c, valores, (int)n, semente, &gerador);
+
+        for (int e = 0; e < QUANT_ESTRUTURAS; e++) {
+            if (!estruturas_escolhidas[e] || (busca_linear(e, ordem) && n > LIMITE_LINEAR))
+                continue;
+
+            size_t memoria_antes = memoria_alocada();
+            long long inicio = agora_ns();
+            if (construir_estrutura(&estruturas, e, insercao, (int)n) != 0) {
+                fprintf(stderr, "%s: sem memoria para %lld elementos\n", nomes_estruturas[e], n);
+                liberar_estruturas(&estruturas);
+                continue;
+            }
+            double insercao_ms = (agora_ns() - inicio) / 1e6;
+            double bytes_chave = (double)(memoria_alocada() - memoria_antes) / n;
+
+            for (int c = 0; c < QUANT_CONSULTAS; c++) {
+                if (!consultas_escolhidas[c])
+                    continue;
+                const int* chaves = procuradas + (size_t)c * buscas;
+
+                // Aquecimento: traz a estrutura para a cache e estabiliza a frequência da CPU.
+                for (int a = 0; a < aquecimento; a++)
+                    buscar_todas(&estruturas, e, chaves, (int)buscas, comparacoes);
+
+                // Repetições cronometradas inteiras (sem ler o relógio entre as buscas).
+                long long falhas = 0;
+                for (int r = 0; r < repeticoes; r++) {
+                    iniciar_contador_cache(contador);
+                    long long t0 = agora_ns();
+                    buscar_todas(&estruturas, e, chaves, (int)buscas, comparacoes);
+                    tempos[r] = agora_ns() - t0;
+                    long long f = parar_contador_cache(contador);
+                    falhas = (f < 0 || falhas < 0) ? -1 : falhas + f;
+                }
+                qsort(tempos, repeticoes, sizeof(long long), comparar_longos);
+                long long mediana = tempos[repeticoes / 2], minimo_tempo = tempos[0];
+
+                // Mais uma passada, cronometrando cada busca, para a distribuição da latência.
+                for (int i = 0; i < buscas; i++) {
+                    long long t0 = agora_ns();
+                    buscar_todas(&estruturas, e, chaves + i, 1, comparacoes + i);
+                    long long t = agora_ns() - t0 - custo;
+                    latencias[i] = t > 0 ? t : 0;
+                }
+                qsort(latencias, buscas, sizeof(long long), comparar_longos);
+
+                long long soma = 0;
+                for (int i = 0; i < buscas; i++)
+                    soma += comparacoes[i];
+
+                // Busca em lote, se a estrutura tem: as mesmas chaves, aquecimento e repetições. A
+                // aceleração é a razão entre as medianas, e as comparações têm de ser as mesmas da
+                // busca uma a uma. A consulta com 0 chaves só pergunta se há busca em lote, sem
+                // aquecer nada além do pedido em -a.
+                char ns_lote[32] = "NA", aceleracao[32] = "NA";
+                if (buscar_todas_lote(&estruturas, e, chaves, 0, comparacoes_lote) == 0) {
+                    for (int a = 0; a < aquecimento; a++)
+                        buscar_todas_lote(&estruturas, e, chaves, (int)buscas, comparacoes_lote);
+                    for (int r = 0; r < repeticoes; r++) {
+                        long long t0 = agora_ns();
+                        buscar_todas_lote(&estruturas, e, chaves, (int)buscas, comparacoes_lote);
+                        tempos[r] = agora_ns() - t0;
+                    }
+                    qsort(tempos, repeticoes, sizeof(long long), comparar_longos);
+                    if (memcmp(comparacoes, comparacoes_lote, (size_t)buscas * sizeof(int)) != 0)
+                        fprintf(stderr, "%s: a busca em lote deu comparacoes diferentes\n", nomes_estruturas[e]);
+                    snprintf(ns_lote, sizeof(ns_lote), "%.2f", (double)tempos[repeticoes / 2] / buscas);
+                    snprintf(aceleracao, sizeof(aceleracao), "%.2f", (double)mediana / tempos[repeticoes / 2]);
+                }
+
+                char falhas_por_busca[32];
+                if (falhas >= 0)
+                    snprintf(falhas_por_busca, sizeof(falhas_por_busca), "%.3f", (double)falhas / (repeticoes * buscas));
+                else
+                    snprintf(falhas_por_busca, sizeof(falhas_por_busca), "NA");
+
+                fprintf(saida, "%s,%s,%s,%lld,%lld,%lld,%.3f,%.2f,%.2f,%.1f,%lld,%lld,%lld,%s,%.2f,%s,%s\n",
+                        nomes_estruturas[e], nomes_ordens[ordem], nomes_consultas[c], n, buscas, repeticoes,
+                        insercao_ms, (double)mediana / buscas, (double)minimo_tempo / buscas, bytes_chave,
+                        percentil(latencias, (int)buscas, 0.50), percentil(latencias, (int)buscas, 0.90),
+                        percentil(latencias, (int)buscas, 0.99), falhas_por_busca, (double)soma / buscas, ns_lote,
+                        aceleracao);
+            }
+            liberar_estruturas(&estruturas);
+        }
+        fflush(saida);
+        fprintf(stderr, "  %lld elementos\n", n);
+    }
+
+    fechar_contador_cache(contador);
+    free(valores);
+    free(insercao);
+    free(procuradas);
+    free(comparacoes);
+    free(comparacoes_lote);
+    free(latencias);
+    free(tempos);
+
+    if (fclose(saida) != 0) {
+        perror("Erro ao gravar a varredura");
+        return 1;
+    }
+    fprintf(stderr, "varredura gravada em %s\n", caminho_saida);
+    return 0;
+}
@@ -0,0 +1,114 @@
+// Microbenchmark da contagem de frequencia (passo de histograma do compactador).
+//
+// Compara a contagem direta frequencia[bytes[i]]++ com calcular_frequencia (4 tabelas intercaladas)
+// em entradas aleatorias, de texto e de um unico byte repetido (o pior caso da contagem direta).
+//
+// Compilar (a partir de Huffman/Huffman):
+//   make bench_histograma
+// ou
+//   gcc -O2 -o bench_histograma bench/bench_histograma.c source/histograma.c
+// Executar:
+//   ./bench_histograma [tamanho_em_MB] [repeticoes]
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../headers/huffman.h"
+
+static double agora(){
+
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void frequencia_simples(const unsigned char *bytes, size_t quantidade, unsigned int frequencia[]){
+
+    for(size_t i = 0; i < quantidade; i++){
+
+        frequencia[bytes[i]]++;
+    }
+}
+
+static void medir(const char *nome, const unsigned char *dados, size_t tamanho, int repeticoes){
+
+    unsigned int f1[256], f2[256];
+    double melhor_simples = 1e30, melhor_tabelas = 1e30;
+
+    for(int r = 0; r < repeticoes; r++){
+
+        memset(f1, 0, sizeof(f1));
+
+        double t0 = agora();
+        frequencia_simples(dados, tamanho, f1);
+        double t1 = agora();
+
+        memset(f2, 0, sizeof(f2));
+
+        double t2 = agora();
+        calcular_frequencia(dados, tamanho, f2);
+        double t3 = agora();
+
+        if(t1 - t0 < melhor_simples) melhor_simples = t1 - t0;
+        if(t3 - t2 < melhor_tabelas) melhor_tabelas = t3 - t2;
+    }
+
+    if(memcmp(f1, f2, sizeof(f1)) != 0){
+
+        fprintf(stderr, "%s: frequencias diferentes!\n", nome);
+        exit(1);
+    }
+
+    double gb = tamanho / 1e9;
+
+    printf("%-10s simples: %6.2f GB/s   4 tabelas: %6.2f GB/s\n", nome, gb / melhor_simples, gb / melhor_tabelas);
+}
+
+int main(int argc, char *argv[]){
+
+    size_t mb = (argc > 1) ? (size_t)atoi(argv[1]) : 64;
+    int repeticoes = (argc > 2) ? atoi(argv[2]) : 5;
+    size_t tamanho = mb << 20;
+
+    unsigned char *dados = malloc(tamanho);
+
+    if(dados == NULL){
+
+        perror("Falha ao alocar o buffer");
+        return 1;
+    }
+
+    uint64_t x = 88172645463325252ULL; // xorshift64
+
+    for(size_t i = 0; i < tamanho; i++){
+
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        dados[i] = (unsigned char)x;
+    }
+
+    medir("aleatorio", dados, tamanho, repeticoes);
+
+    for(size_t i = 0; i < tamanho; i++){ // texto: letras minusculas e espacos com distribuicao enviesada
+
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        dados[i] = (x % 6 == 0) ? ' ' : 'a' + (unsigned char)((x >> 8) % 26 * (x >> 16) % 26 / 26);
+    }
+
+    medir("texto", dados, tamanho, repeticoes);
+
+    memset(dados, 'a', tamanho);
+
+    medir("repetido", dados, tamanho, repeticoes);
+
+    free(dados);
+    return 0;
+}
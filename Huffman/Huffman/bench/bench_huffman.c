@@ -0,0 +1,509 @@
+// Benchmark do compactador inteiro sobre um corpus.
+//
+// Corpus: os arquivos de Arquivos/ mais entradas geradas (texto, aleatorio, zeros e enviesado) de
+// 1 KB ate o tamanho maximo pedido. Para cada entrada mede, bloco a bloco como o compactador faz,
+// a velocidade de cada fase (histograma, arvore + codigos, codificacao), a compactacao e a
+// descompactacao completas pela biblioteca, a razao de compactacao e o pico de memoria (RSS).
+// A compactacao completa roda tambem com o modelo de ordem 1 (ctx.ordem = 1, como "huffman -c"),
+// com razao e velocidades proprias ao lado das de ordem 0. Toda execucao confere a ida e volta
+// byte a byte, nas duas ordens.
+//
+// A saida e CSV. Com -c, cada linha e comparada com a mesma entrada de um CSV de referencia: razao
+// pior que a de referencia e sempre falha; com -t, velocidade abaixo de (100 - PCT)% tambem.
+//
+// Compilar e executar (a partir de Huffman/Huffman):
+//   make bench            (entradas geradas ate 16 MB)
+//   make bench-completo   (ate 1 GB)
+// ou
+//   ./bench_huffman [-a DIR] [-m MB] [-o saida.csv] [-c referencia.csv] [-t PCT]
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#endif
+
+#include "../headers/huffman.h"
+
+typedef struct{
+    char entrada[64];
+    uint64_t tamanho;
+    uint64_t compactado;
+    double razao;
+    double histograma; // MB/s de cada fase
+    double arvore;
+    double codificacao;
+    double decodificacao;
+    double compactacao;
+    double razao_ordem1; // o mesmo com ctx.ordem = 1
+    double compactacao_ordem1;
+    double decodificacao_ordem1;
+    long pico_rss; // KB
+    int ida_e_volta; // 1 = descompactou igual a entrada
+}RESULTADO;
+
+static double agora(){
+
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static int repeticoes(size_t tamanho){ // melhor de N: mais repeticoes nas entradas pequenas
+
+    if(tamanho <= (1 << 20)) return 20;
+    if(tamanho <= (64 << 20)) return 3;
+
+    return 1;
+}
+
+static double mbs(size_t tamanho, double segundos){
+
+    return (segundos > 0) ? tamanho / segundos / 1e6 : 0;
+}
+
+// ==================== Entradas geradas =======================
+
+static uint64_t estado = 88172645463325252ULL; // xorshift64: mesma semente, mesmas entradas, mesmas razoes
+
+static uint64_t proximo_aleatorio(){
+
+    estado ^= estado << 13;
+    estado ^= estado >> 7;
+    estado ^= estado << 17;
+
+    return estado;
+}
+
+static void gerar(const char *tipo, unsigned char *dados, size_t tamanho){
+
+    static const char *palavras[] = {"de", "a", "o", "que", "e", "do", "da", "em", "um", "para", "com", "nao", "uma", "os", "no",
+                                     "arvore", "lista", "busca", "bloco", "codigo", "arquivo", "byte", "tabela", "compactar",
+                                     "frequencia", "huffman", "estrutura", "dados", "memoria", "tempo"};
+    int quant_palavras = sizeof(palavras) / sizeof(palavras[0]);
+
+    estado = 88172645463325252ULL;
+
+    if(strcmp(tipo, "zeros") == 0){
+
+        memset(dados, 0, tamanho);
+
+    } else if(strcmp(tipo, "aleatorio") == 0){
+
+        for(size_t i = 0; i < tamanho; i++){
+
+            dados[i] = (unsigned char)proximo_aleatorio();
+        }
+
+    } else if(strcmp(tipo, "enviesado") == 0){ // byte k com probabilidade 2^-(k+1): forca o limite de 15 bits
+
+        for(size_t i = 0; i < tamanho; i++){
+
+            dados[i] = (unsigned char)(__builtin_ctzll(proximo_aleatorio() | (1ULL << 63)));
+        }
+
+    } else { // texto: palavras frequentes aparecem muito mais (indice ~ u^3)
+
+        size_t pos = 0;
+
+        while(pos < tamanho){
+
+            double u = (proximo_aleatorio() >> 11) * (1.0 / 9007199254740992.0);
+            const char *palavra = palavras[(int)(u * u * u * quant_palavras)];
+
+            for(const char *c = palavra; *c && pos < tamanho; c++){
+
+                dados[pos++] = (unsigned char)*c;
+            }
+
+            if(pos < tamanho) dados[pos++] = (proximo_aleatorio() % 12 == 0) ? '\n' : ' ';
+        }
+    }
+}
+
+// ==================== Medicao =======================
+
+static void medir_fases(const unsigned char *dados, size_t tamanho, RESULTADO *r){
+
+    // as mesmas fases de compactar_bloco, separadas e cronometradas bloco a bloco
+
+    unsigned char *rascunho = malloc(HUFF_TAMANHO_BLOCO + 64);
+    double melhor[3] = {1e30, 1e30, 1e30};
+
+    for(int rep = 0; rep < repeticoes(tamanho); rep++){
+
+        double tempo[3] = {0, 0, 0};
+
+        for(size_t inicio = 0; inicio < tamanho; inicio += HUFF_TAMANHO_BLOCO){
+
+            size_t n = (tamanho - inicio < HUFF_TAMANHO_BLOCO) ? tamanho - inicio : HUFF_TAMANHO_BLOCO;
+            unsigned int frequencia[256] = {0};
+            unsigned char tamanhos[256] = {0};
+            CODIGO codigos[256];
+            ARVORE_POOL arvore;
+
+            double t0 = agora();
+
+            calcular_frequencia(dados + inicio, n, frequencia);
+
+            double t1 = agora();
+
+            criar_arvore_huffman(frequencia, &arvore);
+            calcular_tamanhos(&arvore, tamanhos);
+            limitar_tamanhos(tamanhos, frequencia, HUFF_MAX_BITS);
+            gerar_codigos_canonicos(tamanhos, codigos);
+
+            double t2 = agora();
+
+            if(n >= HUFF_MINIMO_FLUXOS){
+
+                codificar_fluxos(rascunho, dados + inicio, n, codigos);
+            } else {
+
+                ESCRITOR_BITS escritor = {0};
+
+                escritor.dados = rascunho;
+                codificar_bytes(&escritor, dados + inicio, n, codigos);
+                finalizar_escritor(&escritor);
+            }
+
+            double t3 = agora();
+
+            tempo[0] += t1 - t0;
+            tempo[1] += t2 - t1;
+            tempo[2] += t3 - t2;
+        }
+
+        for(int f = 0; f < 3; f++){
+
+            if(tempo[f] < melhor[f]) melhor[f] = tempo[f];
+        }
+    }
+
+    r->histograma = mbs(tamanho, melhor[0]);
+    r->arvore = mbs(tamanho, melhor[1]);
+    r->codificacao = mbs(tamanho, melhor[2]);
+
+    free(rascunho);
+}
+
+static int medir_ordem(int ordem, const unsigned char *dados, size_t tamanho, uint64_t *compactado, double *compactacao, double *decodificacao){
+
+    // compactacao e descompactacao completas pela biblioteca, melhor de N; 1 = ida e volta igual
+
+    HUFF_CONTEXTO ctx;
+
+    huff_inicializar_contexto(&ctx);
+    ctx.ordem = ordem;
+
+    size_t limite = huff_limite_compactado(&ctx, tamanho);
+    unsigned char *saida = malloc(limite);
+    unsigned char *volta = malloc(tamanho > 0 ? tamanho : 1);
+    size_t tam_compactado = 0, tam_volta = 0;
+
+    if(saida == NULL || volta == NULL){
+
+        free(saida);
+        free(volta);
+        return 0;
+    }
+
+    double melhor_compactar = 1e30, melhor_descompactar = 1e30;
+    int ok = 1;
+
+    for(int rep = 0; rep < repeticoes(tamanho); rep++){
+
+        double t0 = agora();
+
+        ok = ok && huff_compactar_buffer(&ctx, dados, tamanho, saida, limite, &tam_compactado) == HUFF_OK;
+
+        double t1 = agora();
+
+        ok = ok && huff_descompactar_buffer(&ctx, saida, tam_compactado, volta, tamanho, &tam_volta) == HUFF_OK;
+
+        double t2 = agora();
+
+        if(t1 - t0 < melhor_compactar) melhor_compactar = t1 - t0;
+        if(t2 - t1 < melhor_descompactar) melhor_descompactar = t2 - t1;
+    }
+
+    ok = ok && tam_volta == tamanho && memcmp(volta, dados, tamanho) == 0;
+    *compactado = tam_compactado;
+    *compactacao = mbs(tamanho, melhor_compactar);
+    *decodificacao = mbs(tamanho, melhor_descompactar);
+
+    free(saida);
+    free(volta);
+
+    return ok;
+}
+
+static void medir(const char *nome, const unsigned char *dados, size_t tamanho, RESULTADO *r){
+
+    uint64_t compactado_ordem1 = 0;
+
+    memset(r, 0, sizeof(RESULTADO));
+    snprintf(r->entrada, sizeof(r->entrada), "%s", nome);
+    r->tamanho = tamanho;
+
+    int ok = medir_ordem(0, dados, tamanho, &r->compactado, &r->compactacao, &r->decodificacao);
+    int ok_ordem1 = medir_ordem(1, dados, tamanho, &compactado_ordem1, &r->compactacao_ordem1, &r->decodificacao_ordem1);
+
+    r->ida_e_volta = ok && ok_ordem1;
+    r->razao = (tamanho > 0) ? (double)r->compactado / tamanho : 0;
+    r->razao_ordem1 = (tamanho > 0) ? (double)compactado_ordem1 / tamanho : 0;
+
+    medir_fases(dados, tamanho, r);
+
+#ifndef _WIN32
+    struct rusage uso;
+
+    getrusage(RUSAGE_SELF, &uso);
+    r->pico_rss = uso.ru_maxrss; // KB no Linux
+#endif
+}
+
+static int executar_caso(const char *nome, const char *tipo, const char *caminho, size_t tamanho, RESULTADO *r){
+
+    // no POSIX cada caso roda em um processo filho, para que o pico de RSS seja so dele
+
+#ifndef _WIN32
+    int canal[2];
+
+    if(pipe(canal) != 0) return -1;
+
+    pid_t filho = fork();
+
+    if(filho == 0){
+
+        close(canal[0]);
+#endif
+
+        ARQUIVO_MAPEADO arquivo;
+        unsigned char *dados = NULL;
+
+        memset(r, 0, sizeof(RESULTADO));
+
+        if(caminho != NULL){
+
+            if(mapear_entrada(caminho, &arquivo) == 0){
+
+                medir(nome, arquivo.dados, arquivo.tamanho, r);
+                desmapear(&arquivo);
+            }
+        } else if((dados = malloc(tamanho > 0 ? tamanho : 1)) != NULL){
+
+            gerar(tipo, dados, tamanho);
+            medir(nome, dados, tamanho, r);
+            free(dados);
+        }
+
+#ifndef _WIN32
+        ssize_t escritos = write(canal[1], r, sizeof(RESULTADO));
+
+        _exit(escritos == sizeof(RESULTADO) ? 0 : 1);
+    }
+
+    close(canal[1]);
+
+    ssize_t lidos = (filho > 0) ? read(canal[0], r, sizeof(RESULTADO)) : -1;
+
+    close(canal[0]);
+
+    if(filho > 0) waitpid(filho, NULL, 0);
+
+    if(lidos != sizeof(RESULTADO)) return -1;
+#endif
+
+    return (r->tamanho > 0 || tamanho == 0) ? 0 : -1;
+}
+
+// ==================== CSV e referencia =======================
+
+static void escrever_cabecalho_csv(FILE *saida){
+
+    fprintf(saida, "entrada,tamanho,compactado,razao,histograma_mbs,arvore_mbs,codificacao_mbs,decodificacao_mbs,compactacao_mbs,"
+                    "razao_ordem1,compactacao_ordem1_mbs,decodificacao_ordem1_mbs,pico_rss_kb,ida_e_volta\n");
+}
+
+static void escrever_linha_csv(FILE *saida, const RESULTADO *r){
+
+    fprintf(saida, "%s,%llu,%llu,%.6f,%.1f,%.1f,%.1f,%.1f,%.1f,%.6f,%.1f,%.1f,%ld,%s\n", r->entrada, (unsigned long long)r->tamanho,
+            (unsigned long long)r->compactado, r->razao, r->histograma, r->arvore, r->codificacao, r->decodificacao,
+            r->compactacao, r->razao_ordem1, r->compactacao_ordem1, r->decodificacao_ordem1, r->pico_rss,
+            r->ida_e_volta ? "ok" : "FALHOU");
+}
+
+static int comparar_referencia(FILE *referencia, const RESULTADO *r, double tolerancia){ // quantidade de regressoes
+
+    char linha[512];
+    RESULTADO b;
+    char ida[16];
+    unsigned long long tamanho, compactado;
+
+    rewind(referencia);
+
+    while(fgets(linha, sizeof(linha), referencia) != NULL){
+
+        if(sscanf(linha, "%63[^,],%llu,%llu,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%ld,%15s", b.entrada, &tamanho, &compactado, &b.razao,
+                  &b.histograma, &b.arvore, &b.codificacao, &b.decodificacao, &b.compactacao, &b.razao_ordem1, &b.compactacao_ordem1,
+                  &b.decodificacao_ordem1, &b.pico_rss, ida) != 14) continue;
+
+        if(strcmp(b.entrada, r->entrada) != 0 || tamanho != r->tamanho) continue;
+
+        int regressoes = 0;
+
+        if(r->razao > b.razao + 1e-6){
+
+            fprintf(stderr, "%s (%llu): razao %.6f pior que a referencia %.6f\n", r->entrada, tamanho, r->razao, b.razao);
+            regressoes++;
+        }
+
+        if(r->razao_ordem1 > b.razao_ordem1 + 1e-6){
+
+            fprintf(stderr, "%s (%llu): razao de ordem 1 %.6f pior que a referencia %.6f\n", r->entrada, tamanho, r->razao_ordem1, b.razao_ordem1);
+            regressoes++;
+        }
+
+        if(tolerancia > 0){
+
+            const char *nomes[] = {"histograma", "arvore", "codificacao", "decodificacao", "compactacao", "compactacao de ordem 1",
+                                   "decodificacao de ordem 1"};
+            double atual[] = {r->histograma, r->arvore, r->codificacao, r->decodificacao, r->compactacao, r->compactacao_ordem1,
+                              r->decodificacao_ordem1};
+            double base[] = {b.histograma, b.arvore, b.codificacao, b.decodificacao, b.compactacao, b.compactacao_ordem1,
+                             b.decodificacao_ordem1};
+
+            for(int f = 0; f < 7; f++){
+
+                if(atual[f] < base[f] * (1 - tolerancia / 100)){
+
+                    fprintf(stderr, "%s (%llu): %s %.1f MB/s, referencia %.1f MB/s\n", r->entrada, tamanho, nomes[f], atual[f], base[f]);
+                    regressoes++;
+                }
+            }
+        }
+
+        return regressoes;
+    }
+
+    return 0; // entrada nova: nada a comparar
+}
+
+int main(int argc, char *argv[]){
+
+    const char *diretorio = "Arquivos";
+    const char *caminho_saida = NULL;
+    const char *caminho_referencia = NULL;
+    double tolerancia = 0; // % de queda de velocidade aceita; 0 = so confere a razao
+    size_t maximo = 16 << 20;
+
+    for(int i = 1; i < argc; i++){
+
+        if(strcmp(argv[i], "-a") == 0 && i + 1 < argc){
+
+            diretorio = argv[++i];
+        } else if(strcmp(argv[i], "-m") == 0 && i + 1 < argc){
+
+            maximo = (size_t)atol(argv[++i]) << 20;
+        } else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc){
+
+            caminho_saida = argv[++i];
+        } else if(strcmp(argv[i], "-c") == 0 && i + 1 < argc){
+
+            caminho_referencia = argv[++i];
+        } else if(strcmp(argv[i], "-t") == 0 && i + 1 < argc){
+
+            tolerancia = atof(argv[++i]);
+        } else {
+
+            fprintf(stderr, "uso: bench_huffman [-a DIR] [-m MB] [-o saida.csv] [-c referencia.csv] [-t PCT]\n");
+            return 1;
+        }
+    }
+
+    FILE *saida = (caminho_saida != NULL) ? fopen(caminho_saida, "w") : stdout;
+    FILE *referencia = (caminho_referencia != NULL) ? fopen(caminho_referencia, "r") : NULL;
+
+    if(saida == NULL || (caminho_referencia != NULL && referencia == NULL)){
+
+        perror("Erro ao abrir o CSV");
+        return 1;
+    }
+
+    escrever_cabecalho_csv(saida);
+
+    int falhas = 0, regressoes = 0;
+    RESULTADO r;
+
+    // arquivos de exemplo
+
+#ifndef _WIN32
+    DIR *pasta = opendir(diretorio);
+    struct dirent *item;
+
+    while(pasta != NULL && (item = readdir(pasta)) != NULL){
+
+        char caminho[4096];
+
+        if(item->d_name[0] == '.') continue;
+
+        snprintf(caminho, sizeof(caminho), "%s/%s", diretorio, item->d_name);
+
+        if(executar_caso(item->d_name, NULL, caminho, 0, &r) != 0){
+
+            fprintf(stderr, "%s: falha ao medir\n", caminho);
+            falhas++;
+            continue;
+        }
+
+        escrever_linha_csv(saida, &r);
+        fflush(saida);
+
+        falhas += !r.ida_e_volta;
+        if(referencia != NULL) regressoes += comparar_referencia(referencia, &r, tolerancia);
+    }
+
+    if(pasta != NULL) closedir(pasta);
+#endif
+
+    // entradas geradas de 1 KB ate o maximo, multiplicando por 16 (1 KB, 16 KB, ..., 64 MB, 1 GB)
+
+    const char *tipos[] = {"texto", "aleatorio", "zeros", "enviesado"};
+
+    for(size_t tamanho = 1024; tamanho <= maximo && tamanho <= (1u << 30); tamanho *= 16){
+
+        for(int t = 0; t < 4; t++){
+
+            if(executar_caso(tipos[t], tipos[t], NULL, tamanho, &r) != 0){
+
+                fprintf(stderr, "%s (%zu bytes): falha ao medir\n", tipos[t], tamanho);
+                falhas++;
+                continue;
+            }
+
+            escrever_linha_csv(saida, &r);
+            fflush(saida);
+
+            falhas += !r.ida_e_volta;
+            if(referencia != NULL) regressoes += comparar_referencia(referencia, &r, tolerancia);
+        }
+    }
+
+    if(caminho_saida != NULL) fclose(saida);
+    if(referencia != NULL) fclose(referencia);
+
+    if(falhas > 0) fprintf(stderr, "%d entradas falharam na ida e volta\n", falhas);
+    if(regressoes > 0) fprintf(stderr, "%d regressoes em relacao a referencia\n", regressoes);
+
+    return (falhas > 0 || regressoes > 0);
+}
@@ -0,0 +1,22 @@
+// Alvo de fuzzing do formato antigo (arvore em pre-ordem no cabecalho): descompactar_formato_antigo,
+// que passa por reconstruir_arvore e escrever_arquivo_descompactado. A saida vai para /dev/null.
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "../headers/huffman.h"
+
+int LLVMFuzzerTestOneInput(const uint8_t *dados, size_t tamanho){
+
+    static FILE *nulo = NULL;
+
+    if(nulo == NULL) nulo = fopen("/dev/null", "wb");
+
+    if(nulo == NULL) return 0;
+
+    descompactar_formato_antigo(dados, tamanho, nulo);
+
+    return 0;
+}
@@ -0,0 +1,57 @@
+// Alvo de fuzzing do descompactador em blocos (libFuzzer; AFL++ usa o mesmo alvo com afl-clang-fast).
+//
+// Cada entrada vai para os dois pontos que leem dados nao confiaveis: huff_descompactar_buffer,
+// que le o cabecalho do arquivo e percorre os blocos, e descompactar_bloco direto, para o fuzzer
+// chegar nos codecs sem precisar montar um cabecalho de arquivo valido. Os destinos sao alocados
+// com o tamanho exato, entao qualquer escrita fora do limite aparece no AddressSanitizer.
+// Os outros alvos (formato antigo, indice e dicionario) e o modo de usar estao no Makefile.
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "../headers/huffman.h"
+
+#define FUZZ_MAX_SAIDA (1 << 20) // tamanhos originais maiores ficam com este destino e testam HUFF_ERRO_CAPACIDADE
+
+int LLVMFuzzerTestOneInput(const uint8_t *dados, size_t tamanho){
+
+    HUFF_CONTEXTO ctx;
+    uint64_t tamanho_original = 0;
+
+    huff_inicializar_contexto(&ctx);
+
+    size_t capacidade = FUZZ_MAX_SAIDA;
+
+    if(huff_tamanho_original(dados, tamanho, &tamanho_original) == HUFF_OK && tamanho_original < capacidade){
+
+        capacidade = (size_t)tamanho_original;
+    }
+
+    unsigned char *destino = malloc(capacidade + 1); // + 1: malloc(0) pode devolver NULL
+
+    if(destino == NULL) return 0;
+
+    size_t tam_destino = 0;
+
+    huff_descompactar_buffer(&ctx, dados, tamanho, destino, capacidade, &tam_destino);
+
+    // o bloco sozinho: a quantidade declarada no cabecalho do bloco escolhe a capacidade
+
+    size_t lidos, escritos;
+
+    capacidade = HUFF_TAMANHO_BLOCO;
+
+    if(tamanho >= HUFF_CABECALHO_BLOCO && ler_u32(dados + 1) < capacidade) capacidade = ler_u32(dados + 1);
+
+    free(destino);
+    destino = malloc(capacidade + 1);
+
+    if(destino == NULL) return 0;
+
+    descompactar_bloco(dados, tamanho, destino, capacidade, &lidos, &escritos);
+
+    free(destino);
+    return 0;
+}
@@ -0,0 +1,45 @@
+// Alvo de fuzzing dos arquivos compactados com dicionario. A entrada e o arquivo do dicionario
+// (HUFF_TAMANHO_DICIONARIO bytes, lido por huff_ler_dicionario) seguido do arquivo compactado, que
+// e descompactado com esse dicionario carregado, pelo mesmo caminho de "huffman -D".
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "../headers/huffman.h"
+
+#define FUZZ_MAX_SAIDA (1 << 20)
+
+int LLVMFuzzerTestOneInput(const uint8_t *dados, size_t tamanho){
+
+    static HUFF_DICIONARIO dicionario; // grande demais para a pilha
+    HUFF_CONTEXTO ctx;
+    uint64_t tamanho_original = 0;
+
+    if(tamanho < HUFF_TAMANHO_DICIONARIO || huff_ler_dicionario(&dicionario, dados, HUFF_TAMANHO_DICIONARIO) != HUFF_OK) return 0;
+
+    const unsigned char *compactado = dados + HUFF_TAMANHO_DICIONARIO;
+    size_t tam_compactado = tamanho - HUFF_TAMANHO_DICIONARIO;
+
+    huff_inicializar_contexto(&ctx);
+    ctx.dicionario = &dicionario;
+
+    size_t capacidade = FUZZ_MAX_SAIDA;
+
+    if(huff_tamanho_original(compactado, tam_compactado, &tamanho_original) == HUFF_OK && tamanho_original < capacidade){
+
+        capacidade = (size_t)tamanho_original;
+    }
+
+    unsigned char *destino = malloc(capacidade + 1);
+
+    if(destino == NULL) return 0;
+
+    size_t tam_destino = 0;
+
+    huff_descompactar_buffer(&ctx, compactado, tam_compactado, destino, capacidade, &tam_destino);
+
+    free(destino);
+    return 0;
+}
@@ -0,0 +1,55 @@
+// Alvo de fuzzing do acesso aleatorio: huff_abrir_buffer (indice de blocos ou varredura dos
+// cabecalhos) e huff_pread em pedacos que atravessam as fronteiras dos blocos, em leituras inteiras
+// (direto no destino) e parciais (pelo cache do bloco).
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "../headers/huffman.h"
+
+#define FUZZ_MAX_LIDO (1 << 20) // so o inicio de arquivos grandes e lido em sequencia
+
+int LLVMFuzzerTestOneInput(const uint8_t *dados, size_t tamanho){
+
+    static unsigned char destino[1 << 16];
+    HUFF_ARQUIVO arquivo;
+
+    if(huff_abrir_buffer(&arquivo, dados, tamanho) != HUFF_OK){
+
+        huff_fechar(&arquivo);
+        return 0;
+    }
+
+    // leitura em sequencia, em pedacos de tamanhos diferentes
+
+    static const size_t pedacos[] = {sizeof(destino), 4097, 1};
+
+    for(int p = 0; p < 3; p++){
+
+        uint64_t limite = (p == 2) ? 4096 : FUZZ_MAX_LIDO;
+
+        for(uint64_t offset = 0; offset < arquivo.tamanho_original && offset < limite; offset += pedacos[p]){
+
+            if(huff_pread(&arquivo, destino, pedacos[p], offset) <= 0) break;
+        }
+    }
+
+    // leituras curtas em volta do inicio de cada bloco (as primeiras 64) e espalhadas pelo arquivo
+
+    for(uint32_t i = 0; i < arquivo.quant_blocos && i < 64; i++){
+
+        uint64_t inicio = arquivo.blocos[i].offset_original;
+
+        huff_pread(&arquivo, destino, 100, inicio > 50 ? inicio - 50 : 0);
+    }
+
+    for(int k = 0; k <= 8; k++){
+
+        huff_pread(&arquivo, destino, 100, arquivo.tamanho_original / 8 * k);
+    }
+
+    huff_fechar(&arquivo);
+    return 0;
+}
@@ -0,0 +1,45 @@
+// main dos alvos de fuzzing sem libFuzzer (make fuzz-reproduzir): roda LLVMFuzzerTestOneInput uma
+// vez para cada arquivo da linha de comando, para repetir com o gcc uma entrada que falhou.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+int LLVMFuzzerTestOneInput(const uint8_t *dados, size_t tamanho);
+
+int main(int argc, char *argv[]){
+
+    for(int i = 1; i < argc; i++){
+
+        FILE *arquivo = fopen(argv[i], "rb");
+
+        if(arquivo == NULL){
+
+            perror(argv[i]);
+            return 1;
+        }
+
+        fseek(arquivo, 0, SEEK_END);
+        long tamanho = ftell(arquivo);
+        fseek(arquivo, 0, SEEK_SET);
+
+        unsigned char *dados = malloc(tamanho > 0 ? (size_t)tamanho : 1);
+
+        if(dados == NULL || fread(dados, 1, (size_t)tamanho, arquivo) != (size_t)tamanho){
+
+            fprintf(stderr, "%s: erro de leitura\n", argv[i]);
+            fclose(arquivo);
+            free(dados);
+            return 1;
+        }
+
+        fclose(arquivo);
+
+        LLVMFuzzerTestOneInput(dados, (size_t)tamanho);
+        printf("%s: ok\n", argv[i]);
+
+        free(dados);
+    }
+
+    return 0;
+}
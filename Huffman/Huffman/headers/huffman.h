@@ -1,72 +1,346 @@
 #ifndef HUFFMAN_H_INCLUDED
 #define HUFFMAN_H_INCLUDED
 
-typedef struct no_huffman{
-    unsigned char byte;
+#include <stdio.h>
+#include <stdint.h>
+
+// Cabealho do formato em blocos: "HUF" + verso + tamanho original (8 bytes) + tamanho do bloco (4 bytes).
+// O primeiro byte do formato antigo (3 bits de lixo + 5 bits altos do tamanho da arvore) nunca vale 'H',
+// pois a arvore tem no maximo 511 nos
+
+#define HUFF_MAGICO "HUF"
+#define HUFF_VERSAO 2
+#define HUFF_CABECALHO_ARQUIVO 16
+
+#define HUFF_MAX_BITS 15 // tamanho maximo de um codigo canonico
+
+// Cada bloco comeca com tipo (1 byte) + tamanho original (4 bytes) + tamanho do conteudo (4 bytes)
+
+#define HUFF_TAMANHO_BLOCO (128 * 1024)
+#define HUFF_MAXIMO_BLOCO (1u << 30) // maior bloco que o compactador grava (-b 1048576); acima, o arquivo e invalido
+#define HUFF_CABECALHO_BLOCO 9
+
+#define BLOCO_CRU 0 // bytes copiados sem compactar
+#define BLOCO_RLE 1 // pares (byte, repeticoes - 1)
+#define BLOCO_HUFFMAN 2 // tabela de tamanhos canonicos + texto compactado
+#define BLOCO_DICIONARIO 3 // texto compactado com os codigos de um dicionario pre-treinado
+#define BLOCO_CONTEXTO 4 // ordem 1: uma tabela por byte anterior, contextos raros compartilham tabela
+#define BLOCO_HUFFMAN_4 5 // como BLOCO_HUFFMAN, mas o texto e dividido em 4 fluxos intercalados
+
+#define BLOCO_VERIFICADO 0x80 // bit no tipo: o conteudo termina com o CRC32C dos bytes originais (4 bytes)
+#define HUFF_TAMANHO_CRC 4
+
+// Com 4 fluxos o byte i vai para o fluxo i % 4 e o decodificador segue 4 cadeias independentes ao
+// mesmo tempo. Conteudo: tabela de tamanhos + tamanho dos fluxos 0, 1 e 2 (4 bytes cada) + fluxos
+#define HUFF_FLUXOS 4
+#define HUFF_MINIMO_FLUXOS 8192 // blocos menores ficam com um fluxo so
+
+// ==================== Arvore de Huffman em pool =======================
+
+#define HUFF_MAX_NOS 511 // 256 folhas + 255 nos internos
+
+typedef struct{
     unsigned int frequencia;
-    struct no_huffman *esquerda;
-    struct no_huffman *direita;
-}NO_HUFFMAN;
+    short esquerda; // indice do filho no pool, -1 = folha
+    short direita;
+    unsigned char byte;
+}NO_POOL;
+
+typedef struct{
+    NO_POOL nos[HUFF_MAX_NOS]; // folhas primeiro, nos internos na ordem em que sao criados
+    int tam_arvore;
+    int raiz; // -1 = arvore vazia
+}ARVORE_POOL;
+
+void criar_arvore_huffman(unsigned int frequencia[], ARVORE_POOL *a);
+
+// ==================== Frequencia dos bytes =======================
+
+void calcular_frequencia(const unsigned char *bytes, size_t quantidade, unsigned int frequencia[]);
+
+// ==================== Codigos canonicos =======================
+
+typedef struct{
+    unsigned short codigo;
+    unsigned char tamanho;
+}CODIGO;
+
+typedef struct{
+    unsigned char *dados;
+    size_t pos; // proximo byte livre
+    uint64_t acumulador;
+    int bits_acumulados;
+}ESCRITOR_BITS;
+
+void calcular_tamanhos(ARVORE_POOL *a, unsigned char tamanhos[]);
+
+void limitar_tamanhos(unsigned char tamanhos[], unsigned int frequencia[], int max_bits);
+
+void gerar_codigos_canonicos(unsigned char tamanhos[], CODIGO codigos[]);
+
+uint64_t tamanho_compactado_em_bits(unsigned int frequencia[], unsigned char tamanhos[]);
+
+void codificar_bytes(ESCRITOR_BITS *e, const unsigned char *bytes, size_t quantidade, const CODIGO codigos[]);
+
+void finalizar_escritor(ESCRITOR_BITS *e);
+
+size_t escrever_tabela_tamanhos(unsigned char *destino, unsigned char tamanhos[]);
+
+size_t tamanho_fluxos(const unsigned char *bytes, size_t quantidade, unsigned char tamanhos[]);
+
+size_t codificar_fluxos(unsigned char *destino, const unsigned char *bytes, size_t quantidade, const CODIGO codigos[]);
+
+// ==================== Decodificador canonico =======================
+
+#define HUFF_BITS_RAPIDOS 10 // codigos de ate 10 bits saem da tabela rapida em uma consulta
+
+typedef struct{
+    unsigned short quantidade[HUFF_MAX_BITS + 1]; // quantos codigos existem de cada tamanho
+    unsigned char simbolos[256]; // bytes ordenados por (tamanho, valor)
+    unsigned short rapida[1 << HUFF_BITS_RAPIDOS]; // (byte << 4) | tamanho, tamanho 0 = codigo longo
+}DECODIFICADOR;
+
+int montar_decodificador(DECODIFICADOR *d, unsigned char tamanhos[]);
+
+int ler_tabela_tamanhos(const unsigned char *origem, size_t tam_origem, unsigned char tamanhos[], size_t *lidos);
+
+int decodificar_canonico(const unsigned char *dados, size_t tam_dados, const DECODIFICADOR *d, unsigned char *saida, size_t quant_simbolos);
+
+int decodificar_fluxos(const unsigned char *dados, size_t tam_dados, const DECODIFICADOR *d, unsigned char *saida, size_t quant_simbolos);
+
+int decodificar_contexto(const unsigned char *conteudo, size_t tam_conteudo, unsigned char *destino, size_t quantidade);
+
+// ==================== Estatisticas =======================
+
+// Instrumentacao opcional (--stats). Com HUFF_CONTEXTO.estatisticas = NULL o pipeline so compara
+// um ponteiro por bloco e nunca le o relogio, entao pode ficar ligada em producao.
+
+#define HUFF_FASE_LEITURA 0 // abrir e mapear a entrada (com mmap, os page faults caem na primeira fase que toca os dados)
+#define HUFF_FASE_HISTOGRAMA 1
+#define HUFF_FASE_ARVORE 2 // arvore, tamanhos, codigos e a escolha do codec do bloco
+#define HUFF_FASE_CODIFICACAO 3 // texto codificado + CRC; ao descompactar, o bloco inteiro (tabela, texto e CRC)
+#define HUFF_FASE_SAIDA 4 // criar, indexar e fechar a saida
+#define HUFF_QUANT_FASES 5
+
+typedef struct{
+    uint64_t tempo[HUFF_QUANT_FASES]; // ns, somados de todas as threads
+    uint64_t blocos[BLOCO_HUFFMAN_4 + 1]; // quantos blocos de cada tipo
+    uint64_t simbolos; // bytes que passaram por um codigo de Huffman
+    uint64_t alocacoes; // malloc/realloc feitos pelo pipeline
+    uint32_t arquivos;
+    int altura_arvore; // maior altura de arvore de Huffman, antes do limite de HUFF_MAX_BITS
+    int maior_codigo; // maior codigo usado por um bloco Huffman, depois do limite
+}HUFF_ESTATISTICAS;
+
+uint64_t huff_relogio_ns();
+
+uint64_t huff_marcar_fase(HUFF_ESTATISTICAS *e, int fase, uint64_t inicio); // soma (agora - inicio) na fase e devolve agora
+
+void huff_somar_estatisticas(HUFF_ESTATISTICAS *destino, const HUFF_ESTATISTICAS *origem);
+
+void huff_imprimir_estatisticas(FILE *saida, const HUFF_ESTATISTICAS *e, uint64_t bytes_entrada, uint64_t bytes_saida, double segundos, int json);
+
+// ==================== Blocos =======================
+
+void escrever_u32(unsigned char *p, uint32_t valor);
+
+uint32_t ler_u32(const unsigned char *p);
+
+void escrever_u64(unsigned char *p, uint64_t valor);
+
+uint64_t ler_u64(const unsigned char *p);
+
+size_t escrever_cabecalho_arquivo(unsigned char *destino, uint64_t tamanho_original, uint32_t tamanho_bloco);
+
+int ler_cabecalho_arquivo(const unsigned char *origem, size_t tam_origem, uint64_t *tamanho_original, uint32_t *tamanho_bloco);
+
+double estimar_entropia(unsigned int frequencia[], size_t quantidade);
+
+size_t limite_compactado(uint64_t tamanho_original, uint32_t tamanho_bloco);
+
+size_t compactar_bloco(const unsigned char *bloco, size_t quantidade, unsigned char *destino, int ordem, HUFF_ESTATISTICAS *est); // est pode ser NULL
+
+int descompactar_bloco(const unsigned char *origem, size_t tam_origem, unsigned char *destino, size_t capacidade, size_t *lidos, size_t *escritos);
+
+// Percorre so os cabecalhos dos blocos, sem descompactar: cada bloco cabe no arquivo e declara no
+// maximo tamanho_bloco bytes e no maximo o que o proprio conteudo pode gerar, e as quantidades
+// somam tamanho_original. Assim um cabecalho forjado nao reserva uma saida maior que o possivel.
+int conferir_blocos(const unsigned char *arquivo, size_t tamanho, uint64_t tamanho_original, uint32_t tamanho_bloco, size_t *fim_blocos); // fim_blocos pode ser NULL
+
+// ==================== Modelo de ordem 1 =======================
+
+typedef struct{
+    int quant_tabelas; // 2 a 256
+    unsigned char mapa[256]; // byte anterior -> tabela
+    unsigned char tamanhos[256][256]; // tamanhos dos codigos de cada tabela
+    CODIGO codigos[256][256];
+}MODELO_CONTEXTO;
+
+size_t planejar_contexto(const unsigned char *bloco, size_t quantidade, unsigned int frequencia[], size_t melhor, MODELO_CONTEXTO *m); // SIZE_MAX = nao compensa
+
+size_t codificar_contexto(const unsigned char *bloco, size_t quantidade, MODELO_CONTEXTO *m, unsigned char *destino);
+
+// ==================== Arquivos mapeados em memoria =======================
+
+typedef struct{
+    unsigned char *dados;
+    size_t tamanho;
+    int descritor;
+#ifdef _WIN32
+    FILE *arquivo; // sem mmap: buffer unico escrito ao fechar
+#endif
+}ARQUIVO_MAPEADO;
+
+int mapear_entrada(const char *caminho, ARQUIVO_MAPEADO *m);
+
+int criar_saida_mapeada(const char *caminho, size_t tamanho, ARQUIVO_MAPEADO *m);
+
+void desmapear(ARQUIVO_MAPEADO *m);
+
+int fechar_saida_mapeada(ARQUIVO_MAPEADO *m, size_t tamanho_final);
+
+// ==================== Indice de blocos =======================
+
+#define HUFF_MAGICO_INDICE "HUFI"
+#define HUFF_ENTRADA_INDICE 17 // offset original (8) + offset compactado (8) + tipo do bloco (1)
+#define HUFF_RODAPE_INDICE 16 // quantidade de blocos (4) + offset do indice (8) + "HUFI"
+
+typedef struct{
+    uint64_t offset_original;
+    uint64_t offset_compactado;
+    unsigned char tipo;
+}ENTRADA_INDICE;
 
 typedef struct{
-    NO_HUFFMAN *raiz;
-    unsigned int tam_arvore;
-}ARVORE;
+    const unsigned char *dados; // arquivo compactado inteiro
+    size_t tamanho;
+    uint64_t tamanho_original;
+    uint32_t tamanho_bloco;
+    ENTRADA_INDICE *blocos;
+    uint32_t quant_blocos;
+    uint64_t fim_blocos; // offset compactado logo apos o ultimo bloco
+    int indice_invalido; // havia indice, mas inconsistente: os blocos vieram dos cabecalhos
+    unsigned char *cache; // ultimo bloco descompactado pela metade
+    long long bloco_em_cache; // -1 = cache vazio
+    ARQUIVO_MAPEADO mapa; // usado quando aberto por huff_abrir
+}HUFF_ARQUIVO;
+
+void escrever_entrada_indice(unsigned char *destino, uint64_t offset_original, uint64_t offset_compactado, unsigned char tipo);
+
+void escrever_rodape_indice(unsigned char *destino, uint32_t quantidade, uint64_t inicio_indice);
+
+size_t escrever_indice(unsigned char *arquivo, size_t fim_blocos);
 
-typedef struct no{
-    NO_HUFFMAN *sub_arvore;
-    struct no *proximo;
-}NO_LISTA;
+int huff_abrir(HUFF_ARQUIVO *a, const char *caminho);
+
+int huff_abrir_buffer(HUFF_ARQUIVO *a, const unsigned char *dados, size_t tamanho);
+
+long long huff_pread(HUFF_ARQUIVO *a, void *destino, size_t quantidade, uint64_t offset); // bytes lidos ou erro (< 0)
+
+void huff_fechar(HUFF_ARQUIVO *a);
+
+// ==================== Dicionarios pre-treinados =======================
+
+#define HUFF_VERSAO_DICIONARIO 3 // arquivo pequeno que referencia um dicionario pelo id
+#define HUFF_CABECALHO_DICIONARIO 9 // "HUF" + versao + id (4 bytes) + tipo, seguido do tamanho original em varint
+#define HUFF_MAGICO_DICIONARIO "HUFD"
+#define HUFF_TAMANHO_DICIONARIO 136 // "HUFD" + id (4 bytes) + 256 tamanhos de 4 bits
 
 typedef struct{
-    NO_LISTA *inicio;
-    int tam; 
-}LISTA;
+    uint32_t id; // hash dos tamanhos, gravado em cada arquivo compactado
+    unsigned char tamanhos[256]; // todo byte tem codigo
+    CODIGO codigos[256];
+    DECODIFICADOR decodificador; // montado uma unica vez
+}HUFF_DICIONARIO;
+
+void huff_treinar_dicionario(HUFF_DICIONARIO *d, const uint64_t frequencia[]);
 
-void inicializar_lista(LISTA *l);
+int huff_montar_dicionario(HUFF_DICIONARIO *d, unsigned char tamanhos[]);
 
-void inicializar_arvore(ARVORE *a);
+int huff_salvar_dicionario(const HUFF_DICIONARIO *d, const char *caminho);
 
-void inserir_na_lista_ordenado(LISTA *l, unsigned char valor_byte, unsigned int valor_frequencia, NO_HUFFMAN *no_novo);
+int huff_carregar_dicionario(HUFF_DICIONARIO *d, const char *caminho);
 
-NO_HUFFMAN* remover_do_inicio(LISTA *l);
+int huff_ler_dicionario(HUFF_DICIONARIO *d, const unsigned char *buffer, size_t tamanho); // o arquivo do dicionario ja na memoria
 
-void criar_arvore_huffman(LISTA *l, ARVORE *a);
+size_t huff_limite_dicionario(size_t tamanho);
 
-void escrever_arvore_no_arquivo(NO_HUFFMAN *no_arvore, FILE *saida);
+int ler_cabecalho_dicionario(const unsigned char *compactado, size_t tam_compactado, uint32_t *id, int *tipo, uint64_t *tamanho_original, size_t *lidos);
 
-int altura_arvore(NO_HUFFMAN *raiz);
+int huff_compactar_com_dicionario(const HUFF_DICIONARIO *d, const unsigned char *entrada, size_t tamanho, unsigned char *destino, size_t capacidade, size_t *tam_destino);
 
-// Funes de convero (unsigned int para binario) e (binario para usigned int)
+int huff_descompactar_com_dicionario(const HUFF_DICIONARIO *d, const unsigned char *compactado, size_t tam_compactado, unsigned char *destino, size_t capacidade, size_t *tam_destino);
 
-char* converte_para_binario(unsigned int num, int tam);
+// ==================== Verificacao =======================
+
+typedef struct{
+    uint32_t blocos;
+    uint32_t invalidos; // blocos corrompidos, truncados ou com CRC diferente
+    uint32_t sem_crc; // blocos de arquivos antigos, verificados so pela decodificacao
+    long long primeiro_invalido; // -1 = nenhum
+    uint64_t offset_invalido; // offset compactado do primeiro bloco invalido
+    int indice_invalido; // o indice nao cobre o arquivo ou nao bate com os cabecalhos dos blocos
+}HUFF_RESULTADO_VERIFICACAO;
+
+uint32_t huff_crc32c(const unsigned char *dados, size_t quantidade);
+
+int huff_verificar_arquivo(const char *caminho, int threads, HUFF_RESULTADO_VERIFICACAO *resultado);
+
+// ==================== Formato antigo =======================
+
+// a arvore fica no pool em pre-ordem (raiz = 0, pais antes dos filhos, -1 = folha)
+int reconstruir_arvore(const unsigned char *cabecalho, size_t tam_cabecalho, int tam_arvore, ARVORE_POOL *a, size_t *lidos);
+
+int escrever_arquivo_descompactado(const unsigned char *texto, size_t tam_texto, int lixo, ARVORE_POOL *a, FILE *saida);
+
+int descompactar_formato_antigo(const unsigned char *dados, size_t tamanho, FILE *saida);
+
+// ==================== Biblioteca =======================
+
+#define HUFF_OK 0
+#define HUFF_ERRO_ES -1 // erro de leitura ou escrita
+#define HUFF_ERRO_FORMATO -2 // arquivo compactado invalido ou corrompido
+#define HUFF_ERRO_MEMORIA -3
+#define HUFF_ERRO_CAPACIDADE -4 // buffer de destino pequeno demais
+#define HUFF_ERRO_DICIONARIO -5 // arquivo exige um dicionario que nao foi carregado
+
+typedef struct{
+    uint32_t tamanho_bloco; // bytes originais por bloco ao compactar (1 a HUFF_MAXIMO_BLOCO)
+    int ordem; // 0 = uma tabela por bloco, 1 = tambem tenta o modelo de ordem 1 (mais lento)
+    uint64_t bytes_entrada; // total lido por este contexto
+    uint64_t bytes_saida; // total escrito por este contexto
+    const HUFF_DICIONARIO *dicionario; // NULL = formato em blocos; so leitura, pode ser dividido entre threads
+    HUFF_ESTATISTICAS *estatisticas; // NULL = sem instrumentacao; no lote cada thread soma na sua copia
+    int trabalhadores; // 0 = arquivo mapeado, um bloco depois do outro; N = pipeline com N threads compactando
+}HUFF_CONTEXTO;
 
-unsigned int binario_para_unsigned_int(char *texto, int quantidade_bits);
+void huff_inicializar_contexto(HUFF_CONTEXTO *ctx);
 
-// ========== Funo para inserir byte a byte no arquivo ===================
+const char* huff_mensagem_erro(int erro);
 
-void inserir_bytes_no_arquivo(char *texto, int quantidade_bits, FILE *saida);
+size_t huff_limite_compactado(HUFF_CONTEXTO *ctx, size_t tamanho);
 
-// =====  Tabela dos caminhos ate um byte da arvore de huffman =============
+int huff_compactar_buffer(HUFF_CONTEXTO *ctx, const unsigned char *entrada, size_t tamanho, unsigned char *destino, size_t capacidade, size_t *tam_destino);
 
-char** aloca_tabela(int colunas);
+int huff_tamanho_original(const unsigned char *compactado, size_t tam_compactado, uint64_t *tamanho_original);
 
-void gerar_tabela(NO_HUFFMAN *no_arvore, char **tabela, char *caminho, int colunas);
+int huff_descompactar_buffer(HUFF_CONTEXTO *ctx, const unsigned char *compactado, size_t tam_compactado, unsigned char *destino, size_t capacidade, size_t *tam_destino);
 
-void imprimir_tabela(char **tabela);
+int huff_descompactar_stream(HUFF_CONTEXTO *ctx, FILE *entrada, FILE *saida);
 
-void liberar_tabela(char **tabela);
+int huff_compactar_arquivo(HUFF_CONTEXTO *ctx, const char *caminho_entrada, const char *caminho_saida);
 
-// ==================== Escrever o Arquivo Compactado =======================
+int huff_descompactar_arquivo(HUFF_CONTEXTO *ctx, const char *caminho_entrada, const char *caminho_saida);
 
-void escrever_arquivo_compactado(FILE *saida, int trash, unsigned int tam_arvore, NO_HUFFMAN *raiz, char *texto, unsigned int quant_bits_texto);
+// ==================== Pipeline assincrono =======================
 
-// ==================== Reconstruir Arvore =======================
+// leitura (io_uring no Linux, pread nos outros), N compactadores e gravacao em ordem, ao mesmo tempo
+int huff_compactar_pipeline(HUFF_CONTEXTO *ctx, const char *caminho_entrada, const char *caminho_saida, int trabalhadores);
 
-NO_HUFFMAN* reconstruir_arvore(FILE *arquivo, int tam_arvore);
+// ==================== Modo lote =======================
 
-// ==================== Escrever o Arquivo Descompactado =======================
+char* huff_caminho_saida(const char *entrada, const char *diretorio_saida, int descompactar);
 
-void escrever_arquivo_descompactado(char *texto_comprimido, NO_HUFFMAN *raiz, int trash, FILE *saida);
+int huff_processar_lote(HUFF_CONTEXTO *modelo, char **entradas, int quantidade, const char *diretorio_saida, int threads); // retorna o numero de falhas
 
 #endif // HUFFMAN_H_INCLUDED
\ No newline at end of file
@@ -0,0 +1,491 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "../headers/huffman.h"
+
+// ==================== Biblioteca =======================
+
+// Todas as funcoes recebem o estado por parametro (HUFF_CONTEXTO), sem variaveis globais, entao
+// varias threads podem compactar/descompactar ao mesmo tempo, cada uma com o seu contexto.
+
+void huff_inicializar_contexto(HUFF_CONTEXTO *ctx){
+
+    ctx->tamanho_bloco = HUFF_TAMANHO_BLOCO;
+    ctx->ordem = 0;
+    ctx->bytes_entrada = 0;
+    ctx->bytes_saida = 0;
+    ctx->dicionario = NULL;
+    ctx->estatisticas = NULL;
+    ctx->trabalhadores = 0;
+}
+
+const char* huff_mensagem_erro(int erro){
+
+    switch(erro){
+
+        case HUFF_OK: return "sucesso";
+        case HUFF_ERRO_ES: return "erro de leitura ou escrita";
+        case HUFF_ERRO_FORMATO: return "arquivo compactado invalido ou corrompido";
+        case HUFF_ERRO_MEMORIA: return "memoria insuficiente";
+        case HUFF_ERRO_CAPACIDADE: return "buffer de destino pequeno demais";
+        case HUFF_ERRO_DICIONARIO: return "arquivo compactado com outro dicionario";
+        default: return "erro desconhecido";
+    }
+}
+
+size_t huff_limite_compactado(HUFF_CONTEXTO *ctx, size_t tamanho){
+
+    if(ctx->dicionario != NULL) return huff_limite_dicionario(tamanho);
+
+    return limite_compactado(tamanho, ctx->tamanho_bloco);
+}
+
+int huff_compactar_buffer(HUFF_CONTEXTO *ctx, const unsigned char *entrada, size_t tamanho, unsigned char *destino, size_t capacidade, size_t *tam_destino){
+
+    if(capacidade < huff_limite_compactado(ctx, tamanho)) return HUFF_ERRO_CAPACIDADE;
+
+    HUFF_ESTATISTICAS *est = ctx->estatisticas;
+
+    if(ctx->dicionario != NULL){ // sem tabela e sem blocos: so o id do dicionario
+
+        uint64_t relogio = (est != NULL) ? huff_relogio_ns() : 0;
+        int erro = huff_compactar_com_dicionario(ctx->dicionario, entrada, tamanho, destino, capacidade, tam_destino);
+
+        if(est != NULL){
+
+            huff_marcar_fase(est, HUFF_FASE_CODIFICACAO, relogio);
+            est->simbolos += tamanho;
+        }
+
+        if(erro == HUFF_OK){
+
+            ctx->bytes_entrada += tamanho;
+            ctx->bytes_saida += *tam_destino;
+        }
+
+        return erro;
+    }
+
+    size_t pos = escrever_cabecalho_arquivo(destino, tamanho, ctx->tamanho_bloco);
+
+    // cada bloco tem seu proprio histograma e escolhe entre copia direta, RLE e Huffman
+
+    for(size_t inicio = 0; inicio < tamanho; inicio += ctx->tamanho_bloco){
+
+        size_t quantidade = tamanho - inicio;
+
+        if(quantidade > ctx->tamanho_bloco) quantidade = ctx->tamanho_bloco;
+
+        pos += compactar_bloco(entrada + inicio, quantidade, destino + pos, ctx->ordem, est);
+    }
+
+    uint64_t relogio = (est != NULL) ? huff_relogio_ns() : 0;
+
+    pos = escrever_indice(destino, pos); // indice para acesso aleatorio (huff_pread)
+
+    if(est != NULL) huff_marcar_fase(est, HUFF_FASE_SAIDA, relogio);
+
+    ctx->bytes_entrada += tamanho;
+    ctx->bytes_saida += pos;
+
+    *tam_destino = pos;
+    return HUFF_OK;
+}
+
+int huff_tamanho_original(const unsigned char *compactado, size_t tam_compactado, uint64_t *tamanho_original){
+
+    uint32_t tamanho_bloco, id;
+    int tipo;
+    size_t lidos;
+
+    if(ler_cabecalho_dicionario(compactado, tam_compactado, &id, &tipo, tamanho_original, &lidos) == 0) return HUFF_OK;
+
+    if(ler_cabecalho_arquivo(compactado, tam_compactado, tamanho_original, &tamanho_bloco) != 0) return HUFF_ERRO_FORMATO;
+
+    return HUFF_OK;
+}
+
+static void contar_bloco(HUFF_ESTATISTICAS *est, int tipo, size_t quantidade){
+
+    tipo &= ~BLOCO_VERIFICADO;
+
+    if(tipo <= BLOCO_HUFFMAN_4) est->blocos[tipo]++;
+
+    if(tipo == BLOCO_HUFFMAN || tipo == BLOCO_HUFFMAN_4 || tipo == BLOCO_CONTEXTO) est->simbolos += quantidade;
+}
+
+int huff_descompactar_buffer(HUFF_CONTEXTO *ctx, const unsigned char *compactado, size_t tam_compactado, unsigned char *destino, size_t capacidade, size_t *tam_destino){
+
+    uint64_t tamanho_original;
+    uint32_t tamanho_bloco;
+    HUFF_ESTATISTICAS *est = ctx->estatisticas;
+    uint64_t relogio = (est != NULL) ? huff_relogio_ns() : 0;
+
+    if(tam_compactado >= 4 && compactado[3] == HUFF_VERSAO_DICIONARIO){
+
+        int erro = huff_descompactar_com_dicionario(ctx->dicionario, compactado, tam_compactado, destino, capacidade, tam_destino);
+
+        if(est != NULL){
+
+            huff_marcar_fase(est, HUFF_FASE_CODIFICACAO, relogio);
+
+            if(erro == HUFF_OK) est->simbolos += *tam_destino;
+        }
+
+        if(erro == HUFF_OK){
+
+            ctx->bytes_entrada += tam_compactado;
+            ctx->bytes_saida += *tam_destino;
+        }
+
+        return erro;
+    }
+
+    if(ler_cabecalho_arquivo(compactado, tam_compactado, &tamanho_original, &tamanho_bloco) != 0) return HUFF_ERRO_FORMATO;
+
+    if(tamanho_original > capacidade) return HUFF_ERRO_CAPACIDADE;
+
+    size_t pos = HUFF_CABECALHO_ARQUIVO; // proximo bloco compactado
+    size_t tam_texto = 0; // bytes ja descompactados
+
+    while(tam_texto < tamanho_original){ // cada bloco diz qual codec usou
+
+        size_t lidos, escritos;
+
+        if(descompactar_bloco(compactado + pos, tam_compactado - pos, destino + tam_texto, tamanho_original - tam_texto, &lidos, &escritos) != 0){
+
+            return HUFF_ERRO_FORMATO;
+        }
+
+        if(est != NULL) contar_bloco(est, compactado[pos], escritos);
+
+        pos += lidos;
+        tam_texto += escritos;
+    }
+
+    if(est != NULL) huff_marcar_fase(est, HUFF_FASE_CODIFICACAO, relogio);
+
+    ctx->bytes_entrada += pos;
+    ctx->bytes_saida += tam_texto;
+
+    *tam_destino = tam_texto;
+    return HUFF_OK;
+}
+
+static int ler_resto(const unsigned char *inicio, size_t tam_inicio, FILE *entrada, unsigned char **dados, size_t *tamanho, HUFF_ESTATISTICAS *est){
+
+    // junta os bytes ja lidos do cabecalho com o resto da entrada, sem fseek (a entrada pode ser um pipe)
+
+    size_t capacidade = 4096;
+    unsigned char *buffer = malloc(capacidade);
+    uint64_t relogio = (est != NULL) ? huff_relogio_ns() : 0;
+
+    if(buffer == NULL) return HUFF_ERRO_MEMORIA;
+
+    if(est != NULL) est->alocacoes++;
+
+    memcpy(buffer, inicio, tam_inicio);
+    *tamanho = tam_inicio;
+
+    while(!feof(entrada)){
+
+        if(*tamanho == capacidade){
+
+            unsigned char *maior = realloc(buffer, capacidade * 2);
+
+            if(maior == NULL){
+
+                free(buffer);
+                return HUFF_ERRO_MEMORIA;
+            }
+
+            buffer = maior;
+            capacidade *= 2;
+
+            if(est != NULL) est->alocacoes++;
+        }
+
+        *tamanho += fread(buffer + *tamanho, 1, capacidade - *tamanho, entrada);
+
+        if(ferror(entrada)){
+
+            free(buffer);
+            return HUFF_ERRO_ES;
+        }
+    }
+
+    if(est != NULL) huff_marcar_fase(est, HUFF_FASE_LEITURA, relogio);
+
+    *dados = buffer;
+    return HUFF_OK;
+}
+
+static int descompactar_stream_dicionario(HUFF_CONTEXTO *ctx, unsigned char *inicio, size_t tam_inicio, FILE *entrada, FILE *saida){
+
+    // arquivos com dicionario sao pequenos e nao tem blocos: le o resto da entrada de uma vez
+
+    unsigned char *compactado;
+    size_t tamanho;
+    int erro = ler_resto(inicio, tam_inicio, entrada, &compactado, &tamanho, ctx->estatisticas);
+
+    if(erro != HUFF_OK) return erro;
+
+    uint64_t tamanho_original;
+
+    erro = huff_tamanho_original(compactado, tamanho, &tamanho_original);
+    unsigned char *texto = NULL;
+    size_t tam_texto = 0;
+
+    if(erro == HUFF_OK && (texto = malloc(tamanho_original > 0 ? (size_t)tamanho_original : 1)) == NULL) erro = HUFF_ERRO_MEMORIA;
+
+    if(texto != NULL && ctx->estatisticas != NULL) ctx->estatisticas->alocacoes++;
+
+    if(erro == HUFF_OK) erro = huff_descompactar_buffer(ctx, compactado, tamanho, texto, (size_t)tamanho_original, &tam_texto);
+
+    if(erro == HUFF_OK && fwrite(texto, 1, tam_texto, saida) != tam_texto) erro = HUFF_ERRO_ES;
+
+    free(compactado);
+    free(texto);
+    return erro;
+}
+
+int huff_descompactar_stream(HUFF_CONTEXTO *ctx, FILE *entrada, FILE *saida){ // memoria proporcional ao bloco, nao ao arquivo
+
+    unsigned char cabecalho[HUFF_CABECALHO_ARQUIVO];
+    uint64_t tamanho_original;
+    uint32_t tamanho_bloco;
+    HUFF_ESTATISTICAS *est = ctx->estatisticas;
+
+    if(est != NULL) est->arquivos++;
+
+    size_t lidos = fread(cabecalho, 1, HUFF_CABECALHO_ARQUIVO, entrada);
+
+    if(lidos < 3 || memcmp(cabecalho, HUFF_MAGICO, 3) != 0){ // formato antigo: arquivo inteiro em memoria
+
+        unsigned char *dados;
+        size_t tamanho;
+        int erro = ler_resto(cabecalho, lidos, entrada, &dados, &tamanho, est);
+
+        if(erro != HUFF_OK) return erro;
+
+        uint64_t relogio = (est != NULL) ? huff_relogio_ns() : 0;
+
+        erro = (descompactar_formato_antigo(dados, tamanho, saida) == 0) ? HUFF_OK : HUFF_ERRO_FORMATO;
+
+        if(est != NULL) huff_marcar_fase(est, HUFF_FASE_CODIFICACAO, relogio);
+
+        free(dados);
+        return erro;
+    }
+
+    if(lidos >= 4 && cabecalho[3] == HUFF_VERSAO_DICIONARIO) return descompactar_stream_dicionario(ctx, cabecalho, lidos, entrada, saida);
+
+    if(ler_cabecalho_arquivo(cabecalho, lidos, &tamanho_original, &tamanho_bloco) != 0) return HUFF_ERRO_FORMATO;
+
+    // nenhum bloco valido ocupa mais que a copia direta de tamanho_bloco bytes mais o CRC
+
+    unsigned char *bloco = malloc(HUFF_CABECALHO_BLOCO + (size_t)tamanho_bloco + HUFF_TAMANHO_CRC);
+    unsigned char *texto = malloc(tamanho_bloco);
+    uint64_t tam_texto = 0;
+    int erro = HUFF_OK;
+
+    if(bloco == NULL || texto == NULL) erro = HUFF_ERRO_MEMORIA;
+
+    if(est != NULL) est->alocacoes += 2;
+
+    while(erro == HUFF_OK && tam_texto < tamanho_original){
+
+        size_t consumidos, escritos;
+        uint64_t relogio = (est != NULL) ? huff_relogio_ns() : 0;
+
+        if(fread(bloco, 1, HUFF_CABECALHO_BLOCO, entrada) != HUFF_CABECALHO_BLOCO){
+
+            erro = HUFF_ERRO_FORMATO;
+            break;
+        }
+
+        size_t tam_conteudo = ler_u32(bloco + 5);
+
+        if(tam_conteudo > tamanho_bloco + HUFF_TAMANHO_CRC || fread(bloco + HUFF_CABECALHO_BLOCO, 1, tam_conteudo, entrada) != tam_conteudo){
+
+            erro = HUFF_ERRO_FORMATO;
+            break;
+        }
+
+        size_t capacidade = (tamanho_original - tam_texto < tamanho_bloco) ? (size_t)(tamanho_original - tam_texto) : tamanho_bloco;
+
+        if(est != NULL) relogio = huff_marcar_fase(est, HUFF_FASE_LEITURA, relogio);
+
+        if(descompactar_bloco(bloco, HUFF_CABECALHO_BLOCO + tam_conteudo, texto, capacidade, &consumidos, &escritos) != 0){
+
+            erro = HUFF_ERRO_FORMATO;
+            break;
+        }
+
+        if(est != NULL){
+
+            contar_bloco(est, bloco[0], escritos);
+            relogio = huff_marcar_fase(est, HUFF_FASE_CODIFICACAO, relogio);
+        }
+
+        if(fwrite(texto, 1, escritos, saida) != escritos){
+
+            erro = HUFF_ERRO_ES;
+            break;
+        }
+
+        if(est != NULL) huff_marcar_fase(est, HUFF_FASE_SAIDA, relogio);
+
+        ctx->bytes_entrada += consumidos;
+        ctx->bytes_saida += escritos;
+        tam_texto += escritos;
+    }
+
+    free(bloco);
+    free(texto);
+    return erro;
+}
+
+int huff_compactar_arquivo(HUFF_CONTEXTO *ctx, const char *caminho_entrada, const char *caminho_saida){
+
+    ARQUIVO_MAPEADO entrada, saida;
+    HUFF_ESTATISTICAS *est = ctx->estatisticas;
+    uint64_t relogio = (est != NULL) ? huff_relogio_ns() : 0;
+
+#ifndef _WIN32
+    if(ctx->trabalhadores > 0 && ctx->dicionario == NULL){ // arquivos grandes: le, compacta e grava ao mesmo tempo
+
+        return huff_compactar_pipeline(ctx, caminho_entrada, caminho_saida, ctx->trabalhadores);
+    }
+#endif
+
+    if(mapear_entrada(caminho_entrada, &entrada) != 0) return HUFF_ERRO_ES;
+
+    if(est != NULL){
+
+        est->arquivos++;
+        relogio = huff_marcar_fase(est, HUFF_FASE_LEITURA, relogio);
+    }
+
+    // nenhum bloco fica maior que a copia direta, entao a saida e criada com esse limite, os blocos
+    // sao compactados direto nela e o excesso e cortado no final
+
+    size_t limite = huff_limite_compactado(ctx, entrada.tamanho);
+
+    if(criar_saida_mapeada(caminho_saida, limite, &saida) != 0){
+
+        desmapear(&entrada);
+        return HUFF_ERRO_ES;
+    }
+
+    if(est != NULL) huff_marcar_fase(est, HUFF_FASE_SAIDA, relogio);
+
+    size_t tam_saida = 0;
+    int erro = huff_compactar_buffer(ctx, entrada.dados, entrada.tamanho, saida.dados, limite, &tam_saida);
+
+    if(est != NULL) relogio = huff_relogio_ns();
+
+    if(fechar_saida_mapeada(&saida, tam_saida) != 0 && erro == HUFF_OK) erro = HUFF_ERRO_ES;
+
+    if(erro != HUFF_OK) remove(caminho_saida);
+
+    desmapear(&entrada);
+
+    if(est != NULL) huff_marcar_fase(est, HUFF_FASE_SAIDA, relogio);
+
+    return erro;
+}
+
+static int tamanho_conferido(const unsigned char *compactado, size_t tam_compactado, uint64_t *tamanho_original){ // huff_tamanho_original, conferido contra o conteudo
+
+    uint32_t tamanho_bloco, id;
+    int tipo;
+    size_t pos;
+
+    if(ler_cabecalho_dicionario(compactado, tam_compactado, &id, &tipo, tamanho_original, &pos) == 0){
+
+        uint64_t conteudo = tam_compactado - pos;
+
+        if(tipo == BLOCO_CRU) return (*tamanho_original == conteudo) ? HUFF_OK : HUFF_ERRO_FORMATO;
+
+        return (tipo == BLOCO_DICIONARIO && *tamanho_original <= conteudo * 8) ? HUFF_OK : HUFF_ERRO_FORMATO;
+    }
+
+    if(ler_cabecalho_arquivo(compactado, tam_compactado, tamanho_original, &tamanho_bloco) != 0) return HUFF_ERRO_FORMATO;
+
+    return (conferir_blocos(compactado, tam_compactado, *tamanho_original, tamanho_bloco, NULL) == 0) ? HUFF_OK : HUFF_ERRO_FORMATO;
+}
+
+int huff_descompactar_arquivo(HUFF_CONTEXTO *ctx, const char *caminho_entrada, const char *caminho_saida){
+
+    ARQUIVO_MAPEADO entrada, saida;
+    uint64_t tamanho_original;
+    int erro;
+    HUFF_ESTATISTICAS *est = ctx->estatisticas;
+    uint64_t relogio = (est != NULL) ? huff_relogio_ns() : 0;
+
+    if(mapear_entrada(caminho_entrada, &entrada) != 0) return HUFF_ERRO_ES;
+
+    if(est != NULL){
+
+        est->arquivos++;
+        relogio = huff_marcar_fase(est, HUFF_FASE_LEITURA, relogio);
+    }
+
+    if(entrada.tamanho < 3 || memcmp(entrada.dados, HUFF_MAGICO, 3) != 0){ // formato antigo, direto da entrada mapeada
+
+        FILE *arquivo_saida = fopen(caminho_saida, "wb");
+
+        erro = HUFF_ERRO_ES;
+
+        if(arquivo_saida != NULL){
+
+            erro = (descompactar_formato_antigo(entrada.dados, entrada.tamanho, arquivo_saida) == 0) ? HUFF_OK : HUFF_ERRO_FORMATO;
+
+            if(est != NULL) huff_marcar_fase(est, HUFF_FASE_CODIFICACAO, relogio);
+
+            if(fclose(arquivo_saida) != 0 && erro == HUFF_OK) erro = HUFF_ERRO_ES;
+
+            if(erro != HUFF_OK) remove(caminho_saida);
+        }
+
+        desmapear(&entrada);
+        return erro;
+    }
+
+    // o tamanho original esta no cabecalho: a saida e criada com o tamanho final e os blocos
+    // sao descompactados direto nela. Antes, os cabecalhos dos blocos precisam somar esse tamanho,
+    // senao um cabecalho forjado de poucos bytes reservaria terabytes no disco
+
+    if(tamanho_conferido(entrada.dados, entrada.tamanho, &tamanho_original) != HUFF_OK){
+
+        desmapear(&entrada);
+        return HUFF_ERRO_FORMATO;
+    }
+
+    if(criar_saida_mapeada(caminho_saida, tamanho_original, &saida) != 0){
+
+        desmapear(&entrada);
+        return HUFF_ERRO_ES;
+    }
+
+    if(est != NULL) huff_marcar_fase(est, HUFF_FASE_SAIDA, relogio);
+
+    size_t tam_texto = 0;
+
+    erro = huff_descompactar_buffer(ctx, entrada.dados, entrada.tamanho, saida.dados, tamanho_original, &tam_texto);
+
+    if(est != NULL) relogio = huff_relogio_ns();
+
+    if(fechar_saida_mapeada(&saida, tam_texto) != 0 && erro == HUFF_OK) erro = HUFF_ERRO_ES;
+
+    if(erro != HUFF_OK) remove(caminho_saida); // nao deixa uma saida pela metade
+
+    desmapear(&entrada);
+
+    if(est != NULL) huff_marcar_fase(est, HUFF_FASE_SAIDA, relogio);
+
+    return erro;
+}
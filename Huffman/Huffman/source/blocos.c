@@ -0,0 +1,405 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "../headers/huffman.h"
+
+// ==================== Inteiros em little-endian =======================
+
+void escrever_u32(unsigned char *p, uint32_t valor){
+
+    for(int i = 0; i < 4; i++){
+
+        p[i] = (unsigned char)(valor >> (8 * i));
+    }
+}
+
+uint32_t ler_u32(const unsigned char *p){
+
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void escrever_u64(unsigned char *p, uint64_t valor){
+
+    escrever_u32(p, (uint32_t)valor);
+    escrever_u32(p + 4, (uint32_t)(valor >> 32));
+}
+
+uint64_t ler_u64(const unsigned char *p){
+
+    return (uint64_t)ler_u32(p) | ((uint64_t)ler_u32(p + 4) << 32);
+}
+
+// ==================== Cabecalho do arquivo =======================
+
+size_t escrever_cabecalho_arquivo(unsigned char *destino, uint64_t tamanho_original, uint32_t tamanho_bloco){
+
+    memcpy(destino, HUFF_MAGICO, 3);
+    destino[3] = HUFF_VERSAO;
+
+    escrever_u64(destino + 4, tamanho_original);
+    escrever_u32(destino + 12, tamanho_bloco);
+
+    return HUFF_CABECALHO_ARQUIVO;
+}
+
+int ler_cabecalho_arquivo(const unsigned char *origem, size_t tam_origem, uint64_t *tamanho_original, uint32_t *tamanho_bloco){
+
+    if(tam_origem < HUFF_CABECALHO_ARQUIVO || memcmp(origem, HUFF_MAGICO, 3) != 0 || origem[3] != HUFF_VERSAO) return -1;
+
+    *tamanho_original = ler_u64(origem + 4);
+    *tamanho_bloco = ler_u32(origem + 12);
+
+    // o tamanho do bloco vem do arquivo e decide quanto os descompactadores alocam
+    if(*tamanho_bloco == 0 || *tamanho_bloco > HUFF_MAXIMO_BLOCO) return -1;
+
+    return 0;
+}
+
+// ==================== Escolha do codec de cada bloco =======================
+
+double estimar_entropia(unsigned int frequencia[], size_t quantidade){ // bits por byte (limite inferior do Huffman)
+
+    double entropia = 0;
+
+    for(int i = 0; i < 256; i++){
+
+        if(frequencia[i] > 0){
+
+            double p = (double)frequencia[i] / quantidade;
+
+            entropia -= p * log2(p);
+        }
+    }
+
+    return entropia;
+}
+
+static size_t contar_transicoes(const unsigned char *bloco, size_t quantidade){ // sem desvios, o compilador vetoriza
+
+    size_t transicoes = 0;
+
+    for(size_t i = 1; i < quantidade; i++){
+
+        transicoes += (bloco[i] != bloco[i - 1]);
+    }
+
+    return transicoes;
+}
+
+static size_t tamanho_rle(const unsigned char *bloco, size_t quantidade){
+
+    size_t tam = 0;
+
+    for(size_t i = 0; i < quantidade; ){
+
+        size_t j = i + 1;
+
+        while(j < quantidade && j - i < 256 && bloco[j] == bloco[i]) j++;
+
+        tam += 2;
+        i = j;
+    }
+
+    return tam;
+}
+
+static size_t codificar_rle(const unsigned char *bloco, size_t quantidade, unsigned char *destino){
+
+    size_t pos = 0;
+
+    for(size_t i = 0; i < quantidade; ){
+
+        size_t j = i + 1;
+
+        while(j < quantidade && j - i < 256 && bloco[j] == bloco[i]) j++;
+
+        destino[pos++] = bloco[i];
+        destino[pos++] = (unsigned char)(j - i - 1);
+        i = j;
+    }
+
+    return pos;
+}
+
+size_t limite_compactado(uint64_t tamanho_original, uint32_t tamanho_bloco){ // nenhum bloco fica maior que a copia direta
+
+    uint64_t blocos = (tamanho_original + tamanho_bloco - 1) / tamanho_bloco;
+
+    return (size_t)(HUFF_CABECALHO_ARQUIVO + blocos * (HUFF_CABECALHO_BLOCO + HUFF_TAMANHO_CRC + HUFF_ENTRADA_INDICE) + HUFF_RODAPE_INDICE + tamanho_original);
+}
+
+size_t compactar_bloco(const unsigned char *bloco, size_t quantidade, unsigned char *destino, int ordem, HUFF_ESTATISTICAS *est){ // destino: HUFF_CABECALHO_BLOCO + quantidade + HUFF_TAMANHO_CRC bytes
+
+    unsigned int frequencia[256] = {0};
+    unsigned char *conteudo = destino + HUFF_CABECALHO_BLOCO;
+    uint64_t relogio = (est != NULL) ? huff_relogio_ns() : 0;
+
+    calcular_frequencia(bloco, quantidade, frequencia);
+
+    if(est != NULL) relogio = huff_marcar_fase(est, HUFF_FASE_HISTOGRAMA, relogio);
+
+    // Huffman: a entropia e um limite inferior do tamanho compactado. So vale montar a arvore
+    // se esse limite (mais a tabela de tamanhos) ficar abaixo do tamanho original
+
+    int distintos = 0;
+
+    for(int i = 0; i < 256; i++){
+
+        if(frequencia[i] > 0) distintos++;
+    }
+
+    size_t tam_tabela = 1 + (distintos <= 32 ? distintos : 32) + (distintos + 1) / 2;
+    size_t estimativa_huffman = (size_t)(estimar_entropia(frequencia, quantidade) * quantidade / 8) + tam_tabela;
+    size_t tam_huffman = SIZE_MAX;
+
+    unsigned char tamanhos[256] = {0};
+
+    if(estimativa_huffman < quantidade){
+
+        ARVORE_POOL arvore;
+
+        criar_arvore_huffman(frequencia, &arvore);
+
+        calcular_tamanhos(&arvore, tamanhos);
+
+        if(est != NULL){ // a altura da arvore e o maior tamanho antes do limite
+
+            for(int i = 0; i < 256; i++){
+
+                if(tamanhos[i] > est->altura_arvore) est->altura_arvore = tamanhos[i];
+            }
+        }
+
+        limitar_tamanhos(tamanhos, frequencia, HUFF_MAX_BITS);
+
+        if(quantidade >= HUFF_MINIMO_FLUXOS){ // 4 fluxos: cada um arredonda para byte e o tamanho de 3 deles vai no conteudo
+
+            tam_huffman = tam_tabela + tamanho_fluxos(bloco, quantidade, tamanhos);
+        } else {
+
+            tam_huffman = tam_tabela + (size_t)((tamanho_compactado_em_bits(frequencia, tamanhos) + 7) / 8);
+        }
+    }
+
+    // RLE: cada corrida ocupa 2 bytes, entao 2 * (transicoes + 1) e um limite inferior barato
+
+    size_t melhor = (tam_huffman < quantidade) ? tam_huffman : quantidade;
+    size_t tam_rle = SIZE_MAX;
+
+    if(quantidade > 0 && 2 * (contar_transicoes(bloco, quantidade) + 1) < melhor){
+
+        tam_rle = tamanho_rle(bloco, quantidade);
+    }
+
+    // ordem 1: so quando pedido, pois monta ate 256 arvores por bloco
+
+    MODELO_CONTEXTO *modelo = NULL;
+    size_t tam_contexto = SIZE_MAX;
+
+    if(ordem > 0 && (modelo = malloc(sizeof(MODELO_CONTEXTO))) != NULL){
+
+        if(est != NULL) est->alocacoes++;
+
+        size_t limite = (tam_rle < melhor) ? tam_rle : melhor;
+
+        tam_contexto = planejar_contexto(bloco, quantidade, frequencia, limite, modelo);
+    }
+
+    int tipo = BLOCO_CRU;
+    size_t tam_conteudo = quantidade;
+
+    if(est != NULL) relogio = huff_marcar_fase(est, HUFF_FASE_ARVORE, relogio);
+
+    if(tam_contexto < quantidade && tam_contexto < tam_huffman && tam_contexto < tam_rle){
+
+        tipo = BLOCO_CONTEXTO;
+        tam_conteudo = codificar_contexto(bloco, quantidade, modelo, conteudo);
+
+    } else if(tam_rle < quantidade && tam_rle <= tam_huffman){
+
+        tipo = BLOCO_RLE;
+        tam_conteudo = codificar_rle(bloco, quantidade, conteudo);
+
+    } else if(tam_huffman < quantidade){
+
+        CODIGO codigos[256];
+        ESCRITOR_BITS escritor = {0};
+
+        gerar_codigos_canonicos(tamanhos, codigos);
+
+        if(est != NULL){
+
+            for(int i = 0; i < 256; i++){
+
+                if(tamanhos[i] > est->maior_codigo) est->maior_codigo = tamanhos[i];
+            }
+        }
+
+        escritor.dados = conteudo + escrever_tabela_tamanhos(conteudo, tamanhos);
+
+        if(quantidade >= HUFF_MINIMO_FLUXOS){
+
+            tipo = BLOCO_HUFFMAN_4;
+            tam_conteudo = (escritor.dados - conteudo) + codificar_fluxos(escritor.dados, bloco, quantidade, codigos);
+        } else {
+
+            codificar_bytes(&escritor, bloco, quantidade, codigos);
+
+            finalizar_escritor(&escritor);
+
+            tipo = BLOCO_HUFFMAN;
+            tam_conteudo = (escritor.dados - conteudo) + escritor.pos;
+        }
+
+    } else { // dados incompressiveis: copia direta
+
+        memcpy(conteudo, bloco, quantidade);
+    }
+
+    free(modelo);
+
+    escrever_u32(conteudo + tam_conteudo, huff_crc32c(bloco, quantidade));
+    tam_conteudo += HUFF_TAMANHO_CRC;
+
+    if(est != NULL){
+
+        huff_marcar_fase(est, HUFF_FASE_CODIFICACAO, relogio);
+
+        est->blocos[tipo]++;
+
+        if(tipo == BLOCO_HUFFMAN || tipo == BLOCO_HUFFMAN_4 || tipo == BLOCO_CONTEXTO) est->simbolos += quantidade;
+    }
+
+    destino[0] = (unsigned char)(tipo | BLOCO_VERIFICADO);
+    escrever_u32(destino + 1, (uint32_t)quantidade);
+    escrever_u32(destino + 5, (uint32_t)tam_conteudo);
+
+    return HUFF_CABECALHO_BLOCO + tam_conteudo;
+}
+
+int descompactar_bloco(const unsigned char *origem, size_t tam_origem, unsigned char *destino, size_t capacidade, size_t *lidos, size_t *escritos){
+
+    if(tam_origem < HUFF_CABECALHO_BLOCO) return -1;
+
+    int tipo = origem[0] & ~BLOCO_VERIFICADO;
+    size_t quantidade = ler_u32(origem + 1);
+    size_t tam_bloco = ler_u32(origem + 5); // conteudo + CRC
+    size_t tam_conteudo = tam_bloco;
+    const unsigned char *conteudo = origem + HUFF_CABECALHO_BLOCO;
+
+    if(tam_bloco > tam_origem - HUFF_CABECALHO_BLOCO || quantidade > capacidade) return -1;
+
+    if(origem[0] & BLOCO_VERIFICADO){
+
+        if(tam_bloco < HUFF_TAMANHO_CRC) return -1;
+
+        tam_conteudo -= HUFF_TAMANHO_CRC;
+    }
+
+    if(tipo == BLOCO_CRU){
+
+        if(tam_conteudo != quantidade) return -1;
+
+        memcpy(destino, conteudo, quantidade);
+
+    } else if(tipo == BLOCO_RLE){
+
+        size_t pos = 0;
+
+        if(tam_conteudo % 2 != 0) return -1;
+
+        for(size_t i = 0; i < tam_conteudo; i += 2){
+
+            size_t repeticoes = (size_t)conteudo[i + 1] + 1;
+
+            if(repeticoes > quantidade - pos) return -1;
+
+            memset(destino + pos, conteudo[i], repeticoes);
+            pos += repeticoes;
+        }
+
+        if(pos != quantidade) return -1;
+
+    } else if(tipo == BLOCO_HUFFMAN || tipo == BLOCO_HUFFMAN_4){
+
+        unsigned char tamanhos[256];
+        DECODIFICADOR decodificador;
+        size_t tam_tabela;
+
+        if(ler_tabela_tamanhos(conteudo, tam_conteudo, tamanhos, &tam_tabela) != 0) return -1;
+
+        if(montar_decodificador(&decodificador, tamanhos) != 0) return -1;
+
+        if(tipo == BLOCO_HUFFMAN_4){
+
+            if(decodificar_fluxos(conteudo + tam_tabela, tam_conteudo - tam_tabela, &decodificador, destino, quantidade) != 0) return -1;
+
+        } else if(decodificar_canonico(conteudo + tam_tabela, tam_conteudo - tam_tabela, &decodificador, destino, quantidade) != 0){
+
+            return -1;
+        }
+
+    } else if(tipo == BLOCO_CONTEXTO){
+
+        if(decodificar_contexto(conteudo, tam_conteudo, destino, quantidade) != 0) return -1;
+
+    } else {
+
+        return -1; // tipo de bloco desconhecido
+    }
+
+    if((origem[0] & BLOCO_VERIFICADO) && huff_crc32c(destino, quantidade) != ler_u32(conteudo + tam_conteudo)) return -1;
+
+    *lidos = HUFF_CABECALHO_BLOCO + tam_bloco;
+    *escritos = quantidade;
+    return 0;
+}
+
+static uint64_t maximo_do_bloco(int tipo, size_t tam_conteudo){ // maior quantidade que o conteudo consegue gerar
+
+    switch(tipo){
+
+        case BLOCO_CRU: return tam_conteudo;
+        case BLOCO_RLE: return (uint64_t)tam_conteudo / 2 * 256; // cada par repete ate 256 vezes
+        case BLOCO_HUFFMAN: case BLOCO_HUFFMAN_4: case BLOCO_CONTEXTO: return (uint64_t)tam_conteudo * 8; // codigos de 1 bit ou mais
+        default: return 0;
+    }
+}
+
+int conferir_blocos(const unsigned char *arquivo, size_t tamanho, uint64_t tamanho_original, uint32_t tamanho_bloco, size_t *fim_blocos){
+
+    size_t pos = HUFF_CABECALHO_ARQUIVO;
+    uint64_t total = 0;
+
+    while(total < tamanho_original){
+
+        if(tamanho - pos < HUFF_CABECALHO_BLOCO) return -1;
+
+        size_t quantidade = ler_u32(arquivo + pos + 1);
+        size_t tam_bloco = ler_u32(arquivo + pos + 5);
+        size_t tam_conteudo = tam_bloco;
+
+        if(tam_bloco > tamanho - pos - HUFF_CABECALHO_BLOCO) return -1;
+
+        if(arquivo[pos] & BLOCO_VERIFICADO){
+
+            if(tam_bloco < HUFF_TAMANHO_CRC) return -1;
+
+            tam_conteudo -= HUFF_TAMANHO_CRC;
+        }
+
+        if(quantidade == 0 || quantidade > tamanho_bloco || quantidade > tamanho_original - total) return -1;
+
+        if(quantidade > maximo_do_bloco(arquivo[pos] & ~BLOCO_VERIFICADO, tam_conteudo)) return -1;
+
+        total += quantidade;
+        pos += HUFF_CABECALHO_BLOCO + tam_bloco;
+    }
+
+    if(fim_blocos != NULL) *fim_blocos = pos;
+
+    return 0;
+}
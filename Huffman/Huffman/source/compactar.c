@@ -2,248 +2,411 @@
 #include <string.h>
 #include <math.h>
 #include <stdlib.h>
+#include <stdint.h>
 
 #include "../headers/huffman.h"
 
-void inicializar_lista(LISTA *l){
+// ==================== Arvore de Huffman em pool =======================
 
-    l->inicio = NULL;
-    l->tam = 0;
-}
+static int no_menor(ARVORE_POOL *a, int x, int y){ // desempate pelo indice deixa a arvore deterministica
 
-void inicializar_arvore(ARVORE *a){
+    if(a->nos[x].frequencia != a->nos[y].frequencia) return a->nos[x].frequencia < a->nos[y].frequencia;
 
-    a->raiz = NULL;
-    a->tam_arvore = 0;
+    return x < y;
 }
 
-void inserir_na_lista_ordenado(LISTA *l, unsigned char valor_byte, unsigned int valor_frequencia, NO_HUFFMAN *no_novo){
+static void subir_heap(ARVORE_POOL *a, short heap[], int pos){
 
-    NO_LISTA *aux, *novo = malloc(sizeof(NO_LISTA));
+    short no = heap[pos];
 
-    if(novo){
-        novo->sub_arvore = malloc(sizeof(NO_HUFFMAN));
-        
-        if(novo->sub_arvore){
+    while(pos > 0){
 
-            novo->sub_arvore->byte = valor_byte;
-            novo->sub_arvore->frequencia = valor_frequencia;
-            novo->sub_arvore->direita = NULL;
-            novo->sub_arvore->esquerda = NULL;
+        int pai = (pos - 1) / 2;
 
-            if(no_novo != NULL){
+        if(!no_menor(a, no, heap[pai])) break;
 
-                novo->sub_arvore->direita = no_novo->direita;
-                novo->sub_arvore->esquerda = no_novo->esquerda;
-            }
+        heap[pos] = heap[pai];
+        pos = pai;
+    }
 
-        }
+    heap[pos] = no;
+}
 
-        if(l->inicio == NULL){ 
+static void descer_heap(ARVORE_POOL *a, short heap[], int tam, int pos){
 
-            novo->proximo = NULL;
-            l->inicio = novo;
-        } else if(novo->sub_arvore->frequencia <= l->inicio->sub_arvore->frequencia){ 
-            novo->proximo = l->inicio;
-            l->inicio = novo;
+    short no = heap[pos];
 
-        } else {
-            aux = l->inicio;
-            while(aux->proximo != NULL && novo->sub_arvore->frequencia > aux->proximo->sub_arvore->frequencia){
-                aux = aux->proximo;
-            }
-            novo->proximo = aux->proximo;
-            aux->proximo = novo;
-        }
+    while(2 * pos + 1 < tam){
+
+        int filho = 2 * pos + 1;
+
+        if(filho + 1 < tam && no_menor(a, heap[filho + 1], heap[filho])) filho++;
+
+        if(!no_menor(a, heap[filho], no)) break;
 
-        l->tam++;
+        heap[pos] = heap[filho];
+        pos = filho;
     }
-    
+
+    heap[pos] = no;
 }
 
-NO_HUFFMAN* remover_do_inicio(LISTA *l){
+static short remover_menor(ARVORE_POOL *a, short heap[], int *tam){
 
-    NO_HUFFMAN *removido = NULL;
+    short menor = heap[0];
 
-    if(l->inicio == NULL){
+    (*tam)--;
 
-        return NULL;
-    } else {
-        removido = l->inicio->sub_arvore;
-        l->inicio = l->inicio->proximo;
-        l->tam--;
-        return removido;
-    }
-}
+    if(*tam > 0){
 
-void criar_arvore_huffman(LISTA *l, ARVORE *a){
+        heap[0] = heap[*tam];
+        descer_heap(a, heap, *tam, 0);
+    }
 
-    if(l->inicio == NULL) return; // Lista vazia no retorna nada
+    return menor;
+}
 
-    NO_LISTA *aux_lista = NULL; 
+void criar_arvore_huffman(unsigned int frequencia[], ARVORE_POOL *a){
 
-    a->tam_arvore = l->tam;
+    short heap[256]; // min-heap de indices do pool, ordenado pela frequencia
+    int tam_heap = 0;
 
-    while(l->tam > 1){
+    a->tam_arvore = 0;
+    a->raiz = -1;
 
-        aux_lista = malloc(sizeof(NO_LISTA));
-        aux_lista->sub_arvore = malloc(sizeof(NO_HUFFMAN));
+    for(int i = 0; i < 256; i++){ // uma folha para cada byte presente
 
-        aux_lista->sub_arvore->esquerda = remover_do_inicio(l); 
+        if(frequencia[i] > 0){
 
-        aux_lista->sub_arvore->direita = remover_do_inicio(l);
+            NO_POOL *folha = &a->nos[a->tam_arvore];
 
-        if(aux_lista->sub_arvore->esquerda == NULL || aux_lista->sub_arvore->direita == NULL){
+            folha->byte = i;
+            folha->frequencia = frequencia[i];
+            folha->esquerda = -1;
+            folha->direita = -1;
 
-            perror("Erro ao remover ns da lista");
-            return;
+            heap[tam_heap++] = a->tam_arvore++;
         }
+    }
 
-        unsigned int soma = (aux_lista->sub_arvore->esquerda->frequencia) + (aux_lista->sub_arvore->direita->frequencia);
+    if(tam_heap == 0) return; // arquivo vazio
 
-        inserir_na_lista_ordenado(l, (unsigned char)'*', soma, aux_lista->sub_arvore);
-        a->tam_arvore++;
+    for(int i = tam_heap / 2 - 1; i >= 0; i--){
 
+        descer_heap(a, heap, tam_heap, i);
     }
 
-    a->raiz = l->inicio->sub_arvore; // tamanho da lista = 1 a raiz e igual ao NO que sobrou;
-    return;
+    while(tam_heap > 1){ // junta os dois nos de menor frequencia em um novo no interno
+
+        short esquerda = remover_menor(a, heap, &tam_heap);
+        short direita = remover_menor(a, heap, &tam_heap);
+
+        NO_POOL *no = &a->nos[a->tam_arvore];
+
+        no->byte = '*';
+        no->frequencia = a->nos[esquerda].frequencia + a->nos[direita].frequencia;
+        no->esquerda = esquerda;
+        no->direita = direita;
+
+        heap[tam_heap++] = a->tam_arvore++;
+        subir_heap(a, heap, tam_heap - 1);
+    }
 
+    a->raiz = heap[0];
 }
 
-void escrever_arvore_no_arquivo(NO_HUFFMAN *no_arvore, FILE *saida){
+// ==================== Codigos canonicos =======================
+
+void calcular_tamanhos(ARVORE_POOL *a, unsigned char tamanhos[]){
+
+    unsigned char profundidade[HUFF_MAX_NOS];
+
+    if(a->raiz < 0) return;
+
+    // todo no interno tem indice maior que os filhos, entao percorrer o pool da raiz para
+    // o inicio visita cada pai antes dos filhos, sem recursao
+
+    profundidade[a->raiz] = 0;
+
+    for(int i = a->raiz; i >= 0; i--){
+
+        NO_POOL *no = &a->nos[i];
 
-    if(no_arvore == NULL) return; // Caso arvore esteja vazia
+        if(no->esquerda < 0){ // folha
 
-    if(no_arvore->esquerda == NULL && no_arvore->direita == NULL){ // Verifica se o NO  folha, NO folha: NO esquerdo e NO direito esto vazios 
-        //  uma folha
-        if(no_arvore->byte == '*' || no_arvore->byte == '\\'){
-            fputc('\\', saida);
-            fputc(no_arvore->byte, saida);
-            
+            // arvore de um unico byte: a raiz e folha e o codigo precisa de pelo menos 1 bit
+            tamanhos[no->byte] = (profundidade[i] == 0) ? 1 : profundidade[i];
         } else {
 
-            fputc(no_arvore->byte, saida);
+            profundidade[no->esquerda] = profundidade[i] + 1;
+            profundidade[no->direita] = profundidade[i] + 1;
         }
-    } else {
-        // N interno
-        fputc('*', saida);
-        escrever_arvore_no_arquivo(no_arvore->esquerda, saida);
-        escrever_arvore_no_arquivo(no_arvore->direita, saida);
     }
 }
 
-void inserir_bytes_no_arquivo(char *texto, int quantidade_bits, FILE *saida){
+typedef struct{
+    unsigned int frequencia;
+    unsigned char byte;
+}PAR_FREQUENCIA;
 
-    unsigned char byte = 0;
+static int comparar_frequencia_decrescente(const void *a, const void *b){
 
-    int aux = 7;
+    const PAR_FREQUENCIA *x = a, *y = b;
 
-    for(int i = 0; i < quantidade_bits; i++){
+    if(x->frequencia != y->frequencia) return (x->frequencia > y->frequencia) ? -1 : 1;
 
-        byte += (texto[i] - '0') * (int)(pow(2, aux));
+    return (int)x->byte - (int)y->byte;
+}
+
+void limitar_tamanhos(unsigned char tamanhos[], unsigned int frequencia[], int max_bits){
+
+    unsigned int quantidade[256] = {0}; // quantidade[t] = quantos bytes tem codigo de tamanho t
+    int maior = 0;
+
+    for(int i = 0; i < 256; i++){
+
+        quantidade[tamanhos[i]]++;
+
+        if(tamanhos[i] > maior) maior = tamanhos[i];
+    }
 
-        aux--;
+    if(maior <= max_bits) return; // arvore ja respeita o limite
+
+    // Heuristica de Kraft: todo codigo maior que o limite passa a ter max_bits. Isso deixa a soma
+    // de Kraft acima de 1, entao a cada passo um codigo de max_bits some e um codigo mais curto
+    // e dividido em dois um bit mais longos, ate a soma voltar a ser exatamente 1
+
+    for(int t = max_bits + 1; t <= maior; t++){
+
+        quantidade[max_bits] += quantidade[t];
+        quantidade[t] = 0;
+    }
+
+    uint32_t total = 0;
+
+    for(int t = 1; t <= max_bits; t++){
+
+        total += quantidade[t] << (max_bits - t);
+    }
 
-        if(aux == -1){
-            //printf("%u ", byte);
-            fputc(byte, saida); // insere o byte na saida
-            aux = 7;
-            byte = 0;
+    while(total > (1u << max_bits)){
+
+        quantidade[max_bits]--;
+
+        for(int t = max_bits - 1; t > 0; t--){
+
+            if(quantidade[t] > 0){
+
+                quantidade[t]--;
+                quantidade[t + 1] += 2;
+                break;
+            }
         }
 
+        total--;
+    }
+
+    // redistribui os tamanhos: bytes mais frequentes recebem os codigos mais curtos
+
+    PAR_FREQUENCIA pares[256];
+    int n = 0;
+
+    for(int i = 0; i < 256; i++){
+
+        if(tamanhos[i] > 0){
+
+            pares[n].frequencia = frequencia[i];
+            pares[n].byte = i;
+            n++;
+        }
+    }
+
+    qsort(pares, n, sizeof(PAR_FREQUENCIA), comparar_frequencia_decrescente);
+
+    int k = 0;
+
+    for(int t = 1; t <= max_bits; t++){
+
+        for(unsigned int j = 0; j < quantidade[t]; j++){
+
+            tamanhos[pares[k++].byte] = t;
+        }
     }
-    
 }
 
-int altura_arvore(NO_HUFFMAN *raiz){
+void gerar_codigos_canonicos(unsigned char tamanhos[], CODIGO codigos[]){
 
-    if(raiz == NULL){
-        
-        return -1;
-    } else {
-        
-        int altura_esq = altura_arvore(raiz->esquerda) + 1;
-        int altura_dir = altura_arvore(raiz->direita) + 1;
+    unsigned int quantidade[HUFF_MAX_BITS + 1] = {0};
+    unsigned int proximo_codigo[HUFF_MAX_BITS + 1];
 
-        if(altura_esq > altura_dir){
+    for(int i = 0; i < 256; i++){
 
-            return altura_esq;
-        } else {
+        quantidade[tamanhos[i]]++;
+    }
+
+    quantidade[0] = 0;
+
+    // o primeiro codigo de cada tamanho vem logo apos o ultimo codigo do tamanho anterior, deslocado 1 bit
+
+    unsigned int codigo = 0;
+
+    for(int t = 1; t <= HUFF_MAX_BITS; t++){
+
+        codigo = (codigo + quantidade[t - 1]) << 1;
+        proximo_codigo[t] = codigo;
+    }
+
+    for(int i = 0; i < 256; i++){
 
-            return altura_dir;
+        codigos[i].tamanho = tamanhos[i];
+        codigos[i].codigo = 0;
+
+        if(tamanhos[i] > 0){
+
+            codigos[i].codigo = proximo_codigo[tamanhos[i]]++;
         }
-        
     }
 }
 
-char** aloca_tabela(int colunas){ // alloca memoria para tabela | colunas = altura da arvore 
-    
-    char **tabela;
+uint64_t tamanho_compactado_em_bits(unsigned int frequencia[], unsigned char tamanhos[]){
 
-    tabela = malloc(sizeof(char*) * 256);
+    uint64_t bits = 0;
 
     for(int i = 0; i < 256; i++){
 
-        tabela[i] = calloc(colunas, sizeof(char));
+        bits += (uint64_t)frequencia[i] * tamanhos[i];
     }
 
-    return tabela;
+    return bits;
 }
 
-void gerar_tabela(NO_HUFFMAN *no_arvore, char **tabela, char *caminho, int colunas){     
+void codificar_bytes(ESCRITOR_BITS *e, const unsigned char *bytes, size_t quantidade, const CODIGO codigos[]){
 
-    if(no_arvore->esquerda == NULL && no_arvore->direita == NULL){ // Verifica se o NO  folha, NO folha: NO esquerdo e NO direito esto vazios 
-        //  uma folha
-        strcpy(tabela[no_arvore->byte], caminho); // copia o caminho para id do byte 
-    } else {
-        // N interno
+    uint64_t acumulador = e->acumulador;
+    int bits_acumulados = e->bits_acumulados;
+    unsigned char *dados = e->dados;
+    size_t pos = e->pos;
 
-        char esquerda[colunas]; // colunas = altura_arvore
-        char direita[colunas];
+    for(size_t i = 0; i < quantidade; i++){
 
-        strcpy(esquerda, caminho);
-        strcpy(direita, caminho);
+        CODIGO c = codigos[bytes[i]];
 
-        strcat(esquerda, "0");
-        strcat(direita, "1");
+        acumulador = (acumulador << c.tamanho) | c.codigo;
+        bits_acumulados += c.tamanho;
 
-        gerar_tabela(no_arvore->esquerda, tabela, esquerda, colunas);
-        gerar_tabela(no_arvore->direita, tabela, direita, colunas);
-        
+        while(bits_acumulados >= 8){ // descarrega os bytes completos, bit mais significativo primeiro
+
+            bits_acumulados -= 8;
+            dados[pos++] = (unsigned char)(acumulador >> bits_acumulados);
+        }
     }
 
+    e->acumulador = acumulador;
+    e->bits_acumulados = bits_acumulados;
+    e->pos = pos;
 }
 
-void liberar_tabela(char **tabela) {
-    
-    for (int i = 0; i < 256; i++) {
-        
-        free(tabela[i]);
+void finalizar_escritor(ESCRITOR_BITS *e){
+
+    if(e->bits_acumulados > 0){ // completa o ultimo byte com bits lixo (zeros)
+
+        e->dados[e->pos++] = (unsigned char)(e->acumulador << (8 - e->bits_acumulados));
+        e->bits_acumulados = 0;
+    }
+
+    e->acumulador = 0;
+}
+
+// ==================== Fluxos intercalados =======================
+
+size_t tamanho_fluxos(const unsigned char *bytes, size_t quantidade, unsigned char tamanhos[]){ // bytes de codificar_fluxos
+
+    uint64_t bits[HUFF_FLUXOS] = {0};
+    size_t total = 4 * (HUFF_FLUXOS - 1);
+
+    for(size_t i = 0; i < quantidade; i++){
+
+        bits[i % HUFF_FLUXOS] += tamanhos[bytes[i]];
+    }
+
+    for(int f = 0; f < HUFF_FLUXOS; f++){ // cada fluxo termina no proprio byte
+
+        total += (size_t)((bits[f] + 7) / 8);
     }
 
-    free(tabela);
+    return total;
 }
 
-void escrever_arquivo_compactado(FILE *saida, int trash, unsigned int tam_arvore, NO_HUFFMAN *raiz, char *texto, unsigned int quant_bits_texto){
+size_t codificar_fluxos(unsigned char *destino, const unsigned char *bytes, size_t quantidade, const CODIGO codigos[]){
+
+    size_t pos = 4 * (HUFF_FLUXOS - 1);
+
+    for(int f = 0; f < HUFF_FLUXOS; f++){
+
+        ESCRITOR_BITS escritor = {0};
+
+        escritor.dados = destino + pos;
+
+        for(size_t i = f; i < quantidade; i += HUFF_FLUXOS){ // o laco de codificar_bytes com passo 4
+
+            CODIGO c = codigos[bytes[i]];
 
-    char *bits_trash_mais_tam_arv = malloc(17 * sizeof(char)); // 3 bits para o lixo + 13 bits para tamanho da arvore | 16 bits = 2 bytes || 1 espao para '\0'
-    bits_trash_mais_tam_arv[0] = '\0';
+            escritor.acumulador = (escritor.acumulador << c.tamanho) | c.codigo;
+            escritor.bits_acumulados += c.tamanho;
 
-    char *bits_lixo_03 = converte_para_binario(trash, 3);
-    char *bits_arvore_13 = converte_para_binario(tam_arvore, 13);
+            while(escritor.bits_acumulados >= 8){
 
-    strcat(bits_trash_mais_tam_arv, bits_lixo_03);
-    strcat(bits_trash_mais_tam_arv, bits_arvore_13);
+                escritor.bits_acumulados -= 8;
+                escritor.dados[escritor.pos++] = (unsigned char)(escritor.acumulador >> escritor.bits_acumulados);
+            }
+        }
 
-    inserir_bytes_no_arquivo(bits_trash_mais_tam_arv, 16, saida);
+        finalizar_escritor(&escritor);
 
-    escrever_arvore_no_arquivo(raiz, saida);
+        if(f < HUFF_FLUXOS - 1) escrever_u32(destino + 4 * f, (uint32_t)escritor.pos);
 
-    inserir_bytes_no_arquivo(texto, quant_bits_texto, saida);
+        pos += escritor.pos;
+    }
 
-    free(bits_trash_mais_tam_arv);
-    free(bits_lixo_03);
-    free(bits_arvore_13);
+    return pos;
 }
 
+size_t escrever_tabela_tamanhos(unsigned char *destino, unsigned char tamanhos[]){ // no maximo 1 + 32 + 128 bytes
+
+    unsigned char presentes[256];
+    size_t pos = 0;
+    int n = 0;
+
+    for(int i = 0; i < 256; i++){
+
+        if(tamanhos[i] > 0) presentes[n++] = i;
+    }
+
+    destino[pos++] = (unsigned char)(n - 1);
+
+    if(n <= 32){ // poucos bytes distintos: lista os bytes
+
+        memcpy(destino + pos, presentes, n);
+        pos += n;
+    } else { // muitos bytes distintos: mapa de 256 bits
+
+        memset(destino + pos, 0, 32);
+
+        for(int i = 0; i < n; i++){
+
+            destino[pos + (presentes[i] >> 3)] |= 1 << (presentes[i] & 7);
+        }
+
+        pos += 32;
+    }
+
+    for(int i = 0; i < n; i += 2){ // tamanhos dos codigos, 4 bits cada
+
+        unsigned char alto = tamanhos[presentes[i]];
+        unsigned char baixo = (i + 1 < n) ? tamanhos[presentes[i + 1]] : 0;
+
+        destino[pos++] = (unsigned char)((alto << 4) | baixo);
+    }
+
+    return pos;
+}
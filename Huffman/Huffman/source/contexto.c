@@ -0,0 +1,209 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "../headers/huffman.h"
+
+// ==================== Modelo de ordem 1 =======================
+
+// Cada byte e codificado com a tabela escolhida pelo byte anterior (o primeiro byte do bloco usa o
+// contexto 0). Contextos raros nao pagam a propria tabela de tamanhos: ficam juntos em uma tabela
+// compartilhada. Conteudo do bloco BLOCO_CONTEXTO:
+//   quantidade de tabelas - 1 (1 byte) + mapa contexto -> tabela (256 bytes)
+//   + tabelas de tamanhos (escrever_tabela_tamanhos) + texto compactado
+
+static size_t tamanho_tabela(unsigned char tamanhos[]){ // bytes que escrever_tabela_tamanhos ocuparia
+
+    int distintos = 0;
+
+    for(int i = 0; i < 256; i++){
+
+        if(tamanhos[i] > 0) distintos++;
+    }
+
+    return 1 + (distintos <= 32 ? distintos : 32) + (distintos + 1) / 2;
+}
+
+static unsigned char* tamanhos_presentes(unsigned int frequencia[], unsigned char tamanhos[]){ // so marca quem aparece
+
+    for(int i = 0; i < 256; i++){
+
+        tamanhos[i] = (frequencia[i] > 0);
+    }
+
+    return tamanhos;
+}
+
+static void montar_tamanhos(unsigned int frequencia[], unsigned char tamanhos[]){
+
+    ARVORE_POOL arvore;
+
+    memset(tamanhos, 0, 256);
+
+    criar_arvore_huffman(frequencia, &arvore);
+
+    calcular_tamanhos(&arvore, tamanhos);
+
+    limitar_tamanhos(tamanhos, frequencia, HUFF_MAX_BITS);
+}
+
+size_t planejar_contexto(const unsigned char *bloco, size_t quantidade, unsigned int frequencia[], size_t melhor, MODELO_CONTEXTO *m){
+
+    unsigned int (*por_contexto)[256] = calloc(256, sizeof(*por_contexto)); // 256 KB, grande demais para a pilha
+    unsigned int compartilhada[256] = {0};
+    unsigned char tamanhos_ordem0[256] = {0};
+    uint64_t total_bits = 0;
+
+    if(por_contexto == NULL || quantidade == 0){
+
+        free(por_contexto);
+        return SIZE_MAX;
+    }
+
+    unsigned char anterior = 0;
+
+    for(size_t i = 0; i < quantidade; i++){
+
+        por_contexto[anterior][bloco[i]]++;
+        anterior = bloco[i];
+    }
+
+    // a entropia condicional e um limite inferior do modelo: se nem ela ganha do melhor codec
+    // ja encontrado, nao vale montar as arvores
+
+    double bits_minimos = 0, minimo_contexto[256];
+
+    for(int c = 0; c < 256; c++){
+
+        size_t total_contexto = 0;
+
+        for(int b = 0; b < 256; b++){
+
+            total_contexto += por_contexto[c][b];
+        }
+
+        minimo_contexto[c] = (total_contexto > 0) ? estimar_entropia(por_contexto[c], total_contexto) * total_contexto : 0;
+        bits_minimos += minimo_contexto[c];
+    }
+
+    if(1 + 256 + (size_t)(bits_minimos / 8) >= melhor){
+
+        free(por_contexto);
+        return SIZE_MAX;
+    }
+
+    montar_tamanhos(frequencia, tamanhos_ordem0);
+
+    // um contexto ganha tabela propria quando o que ele economiza em relacao a tabela de ordem 0
+    // paga a sua tabela de tamanhos; os outros vao para a compartilhada
+
+    int quant_proprias = 0, usa_compartilhada = 0;
+
+    memset(m->mapa, 0, sizeof(m->mapa));
+
+    for(int c = 0; c < 256; c++){
+
+        uint64_t bits_ordem0 = tamanho_compactado_em_bits(por_contexto[c], tamanhos_ordem0);
+
+        if(bits_ordem0 == 0) continue; // contexto que nao aparece
+
+        // a entropia do contexto mais a tabela sao o minimo que a tabela propria custaria: se isso ja
+        // perde da tabela de ordem 0, nem monta a arvore
+
+        unsigned char *tamanhos = m->tamanhos[quant_proprias];
+        uint64_t bits_proprios = UINT64_MAX;
+
+        if(minimo_contexto[c] + 8 * tamanho_tabela(tamanhos_presentes(por_contexto[c], tamanhos)) < bits_ordem0){
+
+            montar_tamanhos(por_contexto[c], tamanhos);
+
+            bits_proprios = tamanho_compactado_em_bits(por_contexto[c], tamanhos) + 8 * tamanho_tabela(tamanhos);
+        }
+
+        if(bits_proprios < bits_ordem0 && quant_proprias < 255){
+
+            m->mapa[c] = (unsigned char)quant_proprias++;
+            total_bits += bits_proprios;
+        } else {
+
+            m->mapa[c] = 255; // marcado: tabela compartilhada, numerada depois das proprias
+            usa_compartilhada = 1;
+
+            for(int b = 0; b < 256; b++){
+
+                compartilhada[b] += por_contexto[c][b];
+            }
+        }
+    }
+
+    m->quant_tabelas = quant_proprias + usa_compartilhada;
+
+    if(usa_compartilhada){
+
+        unsigned char *tamanhos = m->tamanhos[quant_proprias];
+
+        montar_tamanhos(compartilhada, tamanhos);
+
+        total_bits += tamanho_compactado_em_bits(compartilhada, tamanhos) + 8 * tamanho_tabela(tamanhos);
+
+        for(int c = 0; c < 256; c++){
+
+            if(m->mapa[c] == 255) m->mapa[c] = (unsigned char)quant_proprias;
+        }
+    }
+
+    free(por_contexto);
+
+    if(m->quant_tabelas < 2) return SIZE_MAX; // uma tabela so e o modo de ordem 0 com 257 bytes a mais
+
+    return 1 + 256 + (size_t)((total_bits + 7) / 8); // total_bits ja inclui as tabelas de tamanhos
+}
+
+size_t codificar_contexto(const unsigned char *bloco, size_t quantidade, MODELO_CONTEXTO *m, unsigned char *destino){
+
+    CODIGO (*codigos)[256] = m->codigos;
+    size_t pos = 0;
+
+    destino[pos++] = (unsigned char)(m->quant_tabelas - 1);
+
+    memcpy(destino + pos, m->mapa, 256);
+    pos += 256;
+
+    for(int t = 0; t < m->quant_tabelas; t++){
+
+        pos += escrever_tabela_tamanhos(destino + pos, m->tamanhos[t]);
+
+        gerar_codigos_canonicos(m->tamanhos[t], codigos[t]);
+    }
+
+    ESCRITOR_BITS escritor = {0};
+    uint64_t acumulador = 0;
+    int bits_acumulados = 0;
+    unsigned char anterior = 0;
+
+    escritor.dados = destino + pos;
+
+    for(size_t i = 0; i < quantidade; i++){ // o mesmo laco de codificar_bytes, trocando a tabela a cada byte
+
+        CODIGO c = codigos[m->mapa[anterior]][bloco[i]];
+
+        acumulador = (acumulador << c.tamanho) | c.codigo;
+        bits_acumulados += c.tamanho;
+
+        while(bits_acumulados >= 8){
+
+            bits_acumulados -= 8;
+            escritor.dados[escritor.pos++] = (unsigned char)(acumulador >> bits_acumulados);
+        }
+
+        anterior = bloco[i];
+    }
+
+    escritor.acumulador = acumulador;
+    escritor.bits_acumulados = bits_acumulados;
+
+    finalizar_escritor(&escritor);
+
+    return pos + escritor.pos;
+}
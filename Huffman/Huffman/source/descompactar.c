@@ -2,61 +2,530 @@
 #include <string.h>
 #include <math.h>
 #include <stdlib.h>
+#include <stdint.h>
 
 #include "../headers/huffman.h"
 
-NO_HUFFMAN* reconstruir_arvore(FILE *arquivo, int tam_arvore){
+int montar_decodificador(DECODIFICADOR *d, unsigned char tamanhos[]){
 
-    unsigned char byte = 0;
+    unsigned short deslocamento[HUFF_MAX_BITS + 2];
 
-    if(tam_arvore == 0){
+    memset(d->quantidade, 0, sizeof(d->quantidade));
 
-        return NULL;
+    for(int i = 0; i < 256; i++){
+
+        if(tamanhos[i] > HUFF_MAX_BITS) return -1;
+
+        d->quantidade[tamanhos[i]]++;
+    }
+
+    d->quantidade[0] = 0;
+
+    // verifica a desigualdade de Kraft: mais codigos do que cabem em um tamanho = cabecalho corrompido
+
+    int sobra = 1;
+
+    for(int t = 1; t <= HUFF_MAX_BITS; t++){
+
+        sobra = (sobra << 1) - d->quantidade[t];
+
+        if(sobra < 0) return -1;
+    }
+
+    deslocamento[1] = 0;
+
+    for(int t = 1; t <= HUFF_MAX_BITS; t++){
+
+        deslocamento[t + 1] = deslocamento[t] + d->quantidade[t];
+    }
+
+    for(int i = 0; i < 256; i++){ // bytes em ordem de (tamanho, valor), a mesma ordem dos codigos canonicos
+
+        if(tamanhos[i] > 0){
+
+            d->simbolos[deslocamento[tamanhos[i]]++] = i;
+        }
+    }
+
+    // tabela rapida: os HUFF_BITS_RAPIDOS proximos bits indexam direto o byte e o tamanho de todo
+    // codigo curto; cada codigo de t bits ocupa 2^(HUFF_BITS_RAPIDOS - t) entradas seguidas
+
+    memset(d->rapida, 0, sizeof(d->rapida));
+
+    unsigned int codigo = 0;
+    int indice = 0;
+
+    for(int t = 1; t <= HUFF_BITS_RAPIDOS; t++){
+
+        for(int j = 0; j < d->quantidade[t]; j++, codigo++, indice++){
+
+            unsigned int primeira = codigo << (HUFF_BITS_RAPIDOS - t);
+            unsigned int ultima = (codigo + 1) << (HUFF_BITS_RAPIDOS - t);
+
+            for(unsigned int e = primeira; e < ultima; e++){
+
+                d->rapida[e] = (unsigned short)((d->simbolos[indice] << 4) | t);
+            }
+        }
+
+        codigo <<= 1;
+    }
+
+    return 0;
+}
+
+int ler_tabela_tamanhos(const unsigned char *origem, size_t tam_origem, unsigned char tamanhos[], size_t *lidos){
+
+    size_t pos = 0;
+
+    memset(tamanhos, 0, 256);
+
+    if(tam_origem < 1) return -1;
+
+    int n = origem[pos++] + 1;
+    unsigned char presentes[256];
+
+    if(n <= 32){
+
+        if(tam_origem - pos < (size_t)n) return -1;
+
+        memcpy(presentes, origem + pos, n);
+        pos += n;
+    } else {
+
+        if(tam_origem - pos < 32) return -1;
+
+        int k = 0;
+
+        for(int i = 0; i < 256; i++){
+
+            if(origem[pos + (i >> 3)] & (1 << (i & 7))){
+
+                if(k == n) return -1;
+
+                presentes[k++] = i;
+            }
+        }
+
+        if(k != n) return -1;
+
+        pos += 32;
+    }
+
+    if(tam_origem - pos < (size_t)(n + 1) / 2) return -1;
+
+    for(int i = 0; i < n; i += 2){
+
+        unsigned char byte = origem[pos++];
+
+        tamanhos[presentes[i]] = byte >> 4;
+
+        if(i + 1 < n) tamanhos[presentes[i + 1]] = byte & 0x0F;
+    }
+
+    for(int i = 0; i < n; i++){
+
+        if(tamanhos[presentes[i]] == 0) return -1;
+    }
+
+    *lidos = pos;
+    return 0;
+}
+
+// Leitor de bits usado por todos os decodificadores. As funcoes sao static inline para que cada laco
+// mantenha o acumulador em registrador; so os caminhos raros (fim dos dados, codigo longo) sao chamadas
+
+typedef struct{
+    const unsigned char *dados;
+    size_t tamanho;
+    size_t pos; // proximo byte a entrar no acumulador (pode passar do fim)
+    uint64_t acumulador; // proximos bits alinhados a esquerda
+    int bits_acumulados;
+}LEITOR_BITS;
+
+static void recarregar_fim(LEITOR_BITS *l){
+
+    while(l->bits_acumulados <= 56){
+
+        // depois do fim dos dados entram zeros; leitor_excedeu avisa se algum deles foi consumido
+        uint64_t byte = (l->pos < l->tamanho) ? l->dados[l->pos] : 0;
+
+        l->acumulador |= byte << (56 - l->bits_acumulados);
+        l->bits_acumulados += 8;
+        l->pos++;
+    }
+}
+
+static inline void recarregar_leitor(LEITOR_BITS *l){ // deixa pelo menos 56 bits no acumulador
+
+    if(l->pos + 8 > l->tamanho){ // a copia evita que o endereco do leitor escape do laco
+
+        LEITOR_BITS copia = *l;
+
+        recarregar_fim(&copia);
+        *l = copia;
+        return;
+    }
+
+    // le 8 bytes de uma vez e avanca so os bytes inteiros que couberam. Os bits que sobram abaixo
+    // sao os mesmos que a proxima recarga vai escrever por cima
+
+    const unsigned char *p = l->dados + l->pos;
+    uint64_t palavra = ((uint64_t)p[0] << 56) | ((uint64_t)p[1] << 48) | ((uint64_t)p[2] << 40) | ((uint64_t)p[3] << 32) |
+                       ((uint64_t)p[4] << 24) | ((uint64_t)p[5] << 16) | ((uint64_t)p[6] << 8) | (uint64_t)p[7];
+    int bytes = (63 - l->bits_acumulados) >> 3;
+
+    l->acumulador |= palavra >> l->bits_acumulados;
+    l->pos += bytes;
+    l->bits_acumulados += bytes * 8;
+}
+
+static void iniciar_leitor(LEITOR_BITS *l, const unsigned char *dados, size_t tam_dados){
+
+    l->dados = dados;
+    l->tamanho = tam_dados;
+    l->pos = 0;
+    l->acumulador = 0;
+    l->bits_acumulados = 0;
+
+    recarregar_leitor(l);
+}
+
+static int leitor_excedeu(const LEITOR_BITS *l){
+
+    return (uint64_t)l->pos * 8 - l->bits_acumulados > (uint64_t)l->tamanho * 8;
+}
+
+static int simbolo_longo(LEITOR_BITS *l, const DECODIFICADOR *d){
+
+    // percorre os tamanhos comparando o codigo lido com o intervalo de codigos daquele tamanho,
+    // sem precisar de arvore
+
+    int primeiro = 0, indice = 0;
+
+    for(int t = 1; t <= HUFF_MAX_BITS; t++){
+
+        int codigo = (int)(l->acumulador >> (64 - t));
+        int quantidade = d->quantidade[t];
+
+        if(codigo - primeiro < quantidade){
+
+            l->acumulador <<= t;
+            l->bits_acumulados -= t;
+            return d->simbolos[indice + (codigo - primeiro)];
+        }
+
+        indice += quantidade;
+        primeiro = (primeiro + quantidade) << 1;
+    }
+
+    return -1; // nenhum codigo casa: tabela incompleta e texto corrompido
+}
+
+static inline int ler_simbolo(LEITOR_BITS *l, const DECODIFICADOR *d){ // o acumulador precisa de HUFF_MAX_BITS bits
+
+    unsigned short entrada = d->rapida[l->acumulador >> (64 - HUFF_BITS_RAPIDOS)];
+
+    if(entrada & 0x0F){ // codigo curto: uma consulta so
+
+        l->acumulador <<= entrada & 0x0F;
+        l->bits_acumulados -= entrada & 0x0F;
+        return entrada >> 4;
+    }
+
+    LEITOR_BITS copia = *l;
+    int simbolo = simbolo_longo(&copia, d);
+
+    *l = copia;
+    return simbolo;
+}
+
+int decodificar_canonico(const unsigned char *dados, size_t tam_dados, const DECODIFICADOR *d, unsigned char *saida, size_t quant_simbolos){
+
+    LEITOR_BITS leitor;
+
+    iniciar_leitor(&leitor, dados, tam_dados);
+
+    for(size_t i = 0; i < quant_simbolos; i++){
+
+        if(leitor.bits_acumulados < HUFF_MAX_BITS) recarregar_leitor(&leitor);
+
+        int simbolo = ler_simbolo(&leitor, d);
+
+        if(simbolo < 0) return -1;
+
+        saida[i] = (unsigned char)simbolo;
+    }
+
+    return leitor_excedeu(&leitor) ? -1 : 0; // texto truncado
+}
+
+int decodificar_fluxos(const unsigned char *dados, size_t tam_dados, const DECODIFICADOR *d, unsigned char *saida, size_t quant_simbolos){
+
+    LEITOR_BITS leitor[HUFF_FLUXOS];
+    size_t pos = 4 * (HUFF_FLUXOS - 1);
+
+    if(tam_dados < pos) return -1;
+
+    for(int f = 0; f < HUFF_FLUXOS; f++){
+
+        size_t tam_fluxo = (f < HUFF_FLUXOS - 1) ? ler_u32(dados + 4 * f) : tam_dados - pos;
+
+        if(tam_fluxo > tam_dados - pos) return -1;
+
+        iniciar_leitor(&leitor[f], dados + pos, tam_fluxo);
+        pos += tam_fluxo;
+    }
+
+    // cada iteracao decodifica um byte de cada fluxo: as 4 cadeias nao dependem uma da outra, entao
+    // o processador sobrepoe as consultas em vez de esperar o tamanho do codigo anterior
+
+    size_t i = 0;
+    int erro = 0;
+
+    for(; i + 3 * HUFF_FLUXOS <= quant_simbolos; i += 3 * HUFF_FLUXOS){
+
+        // depois da recarga cada acumulador tem pelo menos 56 bits, o bastante para 3 codigos de 15
+
+        recarregar_leitor(&leitor[0]);
+        recarregar_leitor(&leitor[1]);
+        recarregar_leitor(&leitor[2]);
+        recarregar_leitor(&leitor[3]);
+
+        for(int k = 0; k < 3 * HUFF_FLUXOS; k += HUFF_FLUXOS){
+
+            int a = ler_simbolo(&leitor[0], d);
+            int b = ler_simbolo(&leitor[1], d);
+            int c = ler_simbolo(&leitor[2], d);
+            int e = ler_simbolo(&leitor[3], d);
+
+            erro |= a | b | c | e; // negativo = codigo invalido em algum fluxo
+
+            saida[i + k] = (unsigned char)a;
+            saida[i + k + 1] = (unsigned char)b;
+            saida[i + k + 2] = (unsigned char)c;
+            saida[i + k + 3] = (unsigned char)e;
+        }
+    }
+
+    for(; i < quant_simbolos; i++){ // ultimos bytes
+
+        int f = i % HUFF_FLUXOS;
+
+        if(leitor[f].bits_acumulados < HUFF_MAX_BITS) recarregar_leitor(&leitor[f]);
+
+        int simbolo = ler_simbolo(&leitor[f], d);
+
+        erro |= simbolo;
+        saida[i] = (unsigned char)simbolo;
+    }
+
+    if(erro < 0) return -1;
+
+    for(int f = 0; f < HUFF_FLUXOS; f++){
+
+        if(leitor_excedeu(&leitor[f])) return -1; // fluxo truncado
     }
 
-    tam_arvore--;
+    return 0;
+}
+
+int decodificar_contexto(const unsigned char *conteudo, size_t tam_conteudo, unsigned char *destino, size_t quantidade){
 
-    fread(&byte, 1, 1, arquivo);
+    if(tam_conteudo < 1 + 256) return -1;
 
-    if(byte == '*') { // NO interno
-        NO_HUFFMAN *no = malloc(sizeof(NO_HUFFMAN));
-        no->byte = '*';
-        no->esquerda = reconstruir_arvore(arquivo, tam_arvore);
-        no->direita = reconstruir_arvore(arquivo, tam_arvore);
-        return no;
+    int quant_tabelas = conteudo[0] + 1;
+    const unsigned char *mapa = conteudo + 1;
+    size_t pos = 1 + 256;
+
+    for(int c = 0; c < 256; c++){
+
+        if(mapa[c] >= quant_tabelas) return -1;
     }
 
-    if (byte == '\\') { // se encontrar o caracter de escape '\' l o proximo caracter que pode ser a '\' ou '*'
+    // uma tabela rapida por contexto, montada uma vez por bloco
+
+    DECODIFICADOR *tabelas = malloc(quant_tabelas * sizeof(DECODIFICADOR));
+    const DECODIFICADOR *por_contexto[256];
+
+    if(tabelas == NULL) return -1;
+
+    for(int t = 0; t < quant_tabelas; t++){
+
+        unsigned char tamanhos[256];
+        size_t lidos;
+
+        if(ler_tabela_tamanhos(conteudo + pos, tam_conteudo - pos, tamanhos, &lidos) != 0 || montar_decodificador(&tabelas[t], tamanhos) != 0){
+
+            free(tabelas);
+            return -1;
+        }
+
+        pos += lidos;
+    }
+
+    for(int c = 0; c < 256; c++){
+
+        por_contexto[c] = &tabelas[mapa[c]];
+    }
+
+    LEITOR_BITS leitor;
+    int anterior = 0, erro = 0;
+
+    iniciar_leitor(&leitor, conteudo + pos, tam_conteudo - pos);
 
-        fread(&byte, 1, 1, arquivo);
+    for(size_t i = 0; i < quantidade; i++){
+
+        if(leitor.bits_acumulados < HUFF_MAX_BITS) recarregar_leitor(&leitor);
+
+        anterior = ler_simbolo(&leitor, por_contexto[anterior]);
+
+        if(anterior < 0){
+
+            erro = -1;
+            break;
+        }
+
+        destino[i] = (unsigned char)anterior;
     }
 
-    NO_HUFFMAN *folha = malloc(sizeof(NO_HUFFMAN)); // se no for NO interno  NO folha
-    folha->byte = byte;
-    folha->esquerda = NULL;
-    folha->direita = NULL;
-    return folha;
+    if(erro == 0 && leitor_excedeu(&leitor)) erro = -1; // texto truncado
+
+    free(tabelas);
+    return erro;
 }
 
-void escrever_arquivo_descompactado(char *texto_comprimido, NO_HUFFMAN *raiz, int trash, FILE *saida){
-    
-    NO_HUFFMAN *aux = raiz;
+// ==================== Formato antigo =======================
 
-    for(int i = 0; i < (strlen(texto_comprimido) - trash); i++){
+// O formato antigo e: 3 bits de lixo + 13 bits com a quantidade de nos da arvore, a arvore em
+// pre-ordem ('*' = no interno, '\\' escapa uma folha '*' ou '\\') e o texto compactado, cujo ultimo
+// byte termina com os bits de lixo.
 
-        if(texto_comprimido[i] == '0'){
+int reconstruir_arvore(const unsigned char *cabecalho, size_t tam_cabecalho, int tam_arvore, ARVORE_POOL *a, size_t *lidos){
+
+    // uma passada so, sem recursao e sem malloc: cada no lido vira o proximo do pool (a raiz e o 0)
+    // e e pendurado no no interno do topo da pilha, que sai da pilha quando ganha o filho direito
+
+    short pilha[HUFF_MAX_NOS];
+    int topo = 0;
+    size_t pos = 0;
+
+    a->tam_arvore = 0;
+    a->raiz = -1;
+
+    if(tam_arvore < 0 || tam_arvore > HUFF_MAX_NOS) return -1;
+
+    if(tam_arvore == 0){ // arquivo original vazio
+
+        *lidos = 0;
+        return 0;
+    }
 
-            aux = aux->esquerda;
+    do{
 
-        } else { // ento texto_comprimido[i] == '1'
+        if(a->tam_arvore == tam_arvore || pos == tam_cabecalho) return -1; // mais nos que o cabecalho diz ou arvore cortada
 
-            aux = aux->direita;
+        short indice = (short)a->tam_arvore++;
+        NO_POOL *no = &a->nos[indice];
+        unsigned char byte = cabecalho[pos++];
+
+        no->frequencia = 0;
+        no->esquerda = -1;
+        no->direita = -1;
+
+        if(byte == '\\'){ // escape: o proximo byte e uma folha mesmo sendo '*' ou '\\'
+
+            if(pos == tam_cabecalho) return -1;
+
+            byte = cabecalho[pos++];
+            no->byte = byte;
+        } else if(byte == '*'){
+
+            no->byte = byte;
+            no->esquerda = 0; // marca de no interno ainda sem filhos (a raiz nunca e filho)
+        } else {
+
+            no->byte = byte;
         }
 
-        if(aux->esquerda == NULL && aux->direita == NULL){ // NO FOLHA
-            
-            fputc(aux->byte, saida);
-            aux = raiz;
+        if(topo > 0){ // pendura no pai pendente
+
+            NO_POOL *pai = &a->nos[pilha[topo - 1]];
+
+            if(pai->esquerda == 0){
+
+                pai->esquerda = indice;
+            } else {
+
+                pai->direita = indice;
+                topo--;
+            }
+        }
+
+        if(no->esquerda == 0) pilha[topo++] = indice;
+
+    } while(topo > 0);
+
+    if(a->tam_arvore != tam_arvore) return -1;
+
+    a->raiz = 0;
+    *lidos = pos;
+    return 0;
+}
+
+int escrever_arquivo_descompactado(const unsigned char *texto, size_t tam_texto, int lixo, ARVORE_POOL *a, FILE *saida){
+
+    unsigned char buffer[1 << 16];
+    size_t quant_buffer = 0;
+
+    if(a->raiz < 0) return (tam_texto == 0) ? 0 : -1; // arvore vazia so combina com texto vazio
+
+    // arvore so com a raiz: os codigos teriam 0 bits e nao ha como saber quantos bytes havia
+    if(a->nos[a->raiz].esquerda < 0) return -1;
+
+    if(tam_texto == 0 || (uint64_t)lixo > (uint64_t)tam_texto * 8) return -1;
+
+    uint64_t total_bits = (uint64_t)tam_texto * 8 - lixo;
+    int no = a->raiz;
+
+    for(uint64_t i = 0; i < total_bits; i++){
+
+        int bit = (texto[i >> 3] >> (7 - (i & 7))) & 1;
+
+        no = bit ? a->nos[no].direita : a->nos[no].esquerda;
+
+        if(a->nos[no].esquerda < 0){ // NO FOLHA
+
+            buffer[quant_buffer++] = a->nos[no].byte;
+            no = a->raiz;
+
+            if(quant_buffer == sizeof(buffer)){
+
+                if(fwrite(buffer, 1, quant_buffer, saida) != quant_buffer) return -1;
+
+                quant_buffer = 0;
+            }
         }
     }
+
+    if(no != a->raiz) return -1; // texto terminou no meio de um codigo
+
+    return (fwrite(buffer, 1, quant_buffer, saida) == quant_buffer) ? 0 : -1;
+}
+
+int descompactar_formato_antigo(const unsigned char *dados, size_t tamanho, FILE *saida){
+
+    ARVORE_POOL arvore;
+    size_t tam_cabecalho_arvore;
+
+    if(tamanho < 2) return -1;
+
+    int lixo = dados[0] >> 5;
+    int tam_arvore = ((dados[0] & 0x1F) << 8) | dados[1];
+
+    if(reconstruir_arvore(dados + 2, tamanho - 2, tam_arvore, &arvore, &tam_cabecalho_arvore) != 0) return -1;
+
+    size_t inicio_texto = 2 + tam_cabecalho_arvore;
+
+    return escrever_arquivo_descompactado(dados + inicio_texto, tamanho - inicio_texto, lixo, &arvore, saida);
 }
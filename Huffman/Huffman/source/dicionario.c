@@ -0,0 +1,245 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "../headers/huffman.h"
+
+// ==================== Dicionarios pre-treinados =======================
+
+// Para arquivos pequenos a tabela de tamanhos e os cabecalhos de bloco pesam mais que o texto.
+// Um dicionario guarda uma tabela de codigos treinada em um corpus de exemplo; cada arquivo
+// compactado com ele so referencia o id do dicionario:
+//   "HUF" + HUFF_VERSAO_DICIONARIO + id (4 bytes) + tipo (BLOCO_CRU ou BLOCO_DICIONARIO)
+//   + tamanho original (varint) + texto
+// O arquivo do dicionario e "HUFD" + id (4 bytes) + 256 tamanhos de 4 bits (128 bytes).
+
+static uint32_t calcular_id(unsigned char tamanhos[]){ // FNV-1a dos tamanhos
+
+    uint32_t hash = 2166136261u;
+
+    for(int i = 0; i < 256; i++){
+
+        hash ^= tamanhos[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+int huff_montar_dicionario(HUFF_DICIONARIO *d, unsigned char tamanhos[]){
+
+    memcpy(d->tamanhos, tamanhos, 256);
+
+    for(int i = 0; i < 256; i++){
+
+        if(tamanhos[i] == 0) return HUFF_ERRO_FORMATO; // todo byte precisa de codigo
+    }
+
+    if(montar_decodificador(&d->decodificador, d->tamanhos) != 0) return HUFF_ERRO_FORMATO;
+
+    gerar_codigos_canonicos(d->tamanhos, d->codigos);
+
+    d->id = calcular_id(d->tamanhos);
+    return HUFF_OK;
+}
+
+void huff_treinar_dicionario(HUFF_DICIONARIO *d, const uint64_t frequencia[]){
+
+    unsigned int ajustada[256];
+    uint64_t maior = 0;
+
+    for(int i = 0; i < 256; i++){
+
+        if(frequencia[i] > maior) maior = frequencia[i];
+    }
+
+    // o corpus pode passar de 32 bits por byte: reduz a escala mantendo as proporcoes. Todo byte
+    // recebe pelo menos 1, para que qualquer entrada possa ser codificada com o dicionario
+
+    uint64_t divisor = (maior >> 24) + 1;
+
+    for(int i = 0; i < 256; i++){
+
+        ajustada[i] = (unsigned int)(frequencia[i] / divisor) + 1;
+    }
+
+    ARVORE_POOL arvore;
+    unsigned char tamanhos[256] = {0};
+
+    criar_arvore_huffman(ajustada, &arvore);
+
+    calcular_tamanhos(&arvore, tamanhos);
+
+    limitar_tamanhos(tamanhos, ajustada, HUFF_MAX_BITS);
+
+    huff_montar_dicionario(d, tamanhos);
+}
+
+int huff_salvar_dicionario(const HUFF_DICIONARIO *d, const char *caminho){
+
+    unsigned char buffer[HUFF_TAMANHO_DICIONARIO];
+
+    memcpy(buffer, HUFF_MAGICO_DICIONARIO, 4);
+    escrever_u32(buffer + 4, d->id);
+
+    for(int i = 0; i < 256; i += 2){
+
+        buffer[8 + i / 2] = (unsigned char)((d->tamanhos[i] << 4) | d->tamanhos[i + 1]);
+    }
+
+    FILE *arquivo = fopen(caminho, "wb");
+
+    if(arquivo == NULL) return HUFF_ERRO_ES;
+
+    int erro = (fwrite(buffer, 1, sizeof(buffer), arquivo) == sizeof(buffer)) ? HUFF_OK : HUFF_ERRO_ES;
+
+    if(fclose(arquivo) != 0) erro = HUFF_ERRO_ES;
+
+    return erro;
+}
+
+int huff_carregar_dicionario(HUFF_DICIONARIO *d, const char *caminho){
+
+    unsigned char buffer[HUFF_TAMANHO_DICIONARIO];
+
+    FILE *arquivo = fopen(caminho, "rb");
+
+    if(arquivo == NULL) return HUFF_ERRO_ES;
+
+    size_t lidos = fread(buffer, 1, sizeof(buffer), arquivo);
+
+    fclose(arquivo);
+
+    return huff_ler_dicionario(d, buffer, lidos);
+}
+
+int huff_ler_dicionario(HUFF_DICIONARIO *d, const unsigned char *buffer, size_t tamanho){
+
+    unsigned char tamanhos[256];
+
+    if(tamanho != HUFF_TAMANHO_DICIONARIO || memcmp(buffer, HUFF_MAGICO_DICIONARIO, 4) != 0) return HUFF_ERRO_FORMATO;
+
+    for(int i = 0; i < 256; i += 2){
+
+        tamanhos[i] = buffer[8 + i / 2] >> 4;
+        tamanhos[i + 1] = buffer[8 + i / 2] & 0x0F;
+    }
+
+    // o decodificador e montado uma vez aqui e reaproveitado em todas as chamadas
+
+    if(huff_montar_dicionario(d, tamanhos) != HUFF_OK || d->id != ler_u32(buffer + 4)) return HUFF_ERRO_FORMATO;
+
+    return HUFF_OK;
+}
+
+size_t huff_limite_dicionario(size_t tamanho){
+
+    return HUFF_CABECALHO_DICIONARIO + 10 + tamanho; // varint de 64 bits ocupa no maximo 10 bytes
+}
+
+int huff_compactar_com_dicionario(const HUFF_DICIONARIO *d, const unsigned char *entrada, size_t tamanho, unsigned char *destino, size_t capacidade, size_t *tam_destino){
+
+    unsigned int frequencia[256] = {0};
+
+    if(capacidade < huff_limite_dicionario(tamanho)) return HUFF_ERRO_CAPACIDADE;
+
+    calcular_frequencia(entrada, tamanho, frequencia);
+
+    size_t tam_texto = (size_t)((tamanho_compactado_em_bits(frequencia, (unsigned char*)d->tamanhos) + 7) / 8);
+    size_t pos = 0;
+
+    memcpy(destino, HUFF_MAGICO, 3);
+    destino[3] = HUFF_VERSAO_DICIONARIO;
+    escrever_u32(destino + 4, d->id);
+    destino[8] = (tam_texto < tamanho) ? BLOCO_DICIONARIO : BLOCO_CRU; // entrada fora do perfil do corpus: copia direta
+    pos = HUFF_CABECALHO_DICIONARIO;
+
+    uint64_t resto = tamanho;
+
+    do{ // varint: 7 bits por byte, bit alto = continua
+
+        destino[pos++] = (unsigned char)((resto & 0x7F) | (resto > 0x7F ? 0x80 : 0));
+        resto >>= 7;
+    } while(resto > 0);
+
+    if(destino[8] == BLOCO_DICIONARIO){
+
+        ESCRITOR_BITS escritor = {0};
+
+        escritor.dados = destino + pos;
+
+        codificar_bytes(&escritor, entrada, tamanho, d->codigos);
+
+        finalizar_escritor(&escritor);
+
+        pos += escritor.pos;
+    } else {
+
+        memcpy(destino + pos, entrada, tamanho);
+        pos += tamanho;
+    }
+
+    *tam_destino = pos;
+    return HUFF_OK;
+}
+
+int ler_cabecalho_dicionario(const unsigned char *compactado, size_t tam_compactado, uint32_t *id, int *tipo, uint64_t *tamanho_original, size_t *lidos){
+
+    if(tam_compactado < HUFF_CABECALHO_DICIONARIO || memcmp(compactado, HUFF_MAGICO, 3) != 0 || compactado[3] != HUFF_VERSAO_DICIONARIO) return -1;
+
+    *id = ler_u32(compactado + 4);
+    *tipo = compactado[8];
+    *tamanho_original = 0;
+
+    size_t pos = HUFF_CABECALHO_DICIONARIO;
+
+    for(int deslocamento = 0; ; deslocamento += 7){
+
+        if(pos == tam_compactado || deslocamento > 63) return -1;
+
+        unsigned char byte = compactado[pos++];
+
+        *tamanho_original |= (uint64_t)(byte & 0x7F) << deslocamento;
+
+        if(!(byte & 0x80)) break;
+    }
+
+    *lidos = pos;
+    return 0;
+}
+
+int huff_descompactar_com_dicionario(const HUFF_DICIONARIO *d, const unsigned char *compactado, size_t tam_compactado, unsigned char *destino, size_t capacidade, size_t *tam_destino){
+
+    uint32_t id;
+    int tipo;
+    uint64_t tamanho_original;
+    size_t pos;
+
+    if(ler_cabecalho_dicionario(compactado, tam_compactado, &id, &tipo, &tamanho_original, &pos) != 0) return HUFF_ERRO_FORMATO;
+
+    if(d == NULL || id != d->id) return HUFF_ERRO_DICIONARIO;
+
+    if(tamanho_original > capacidade) return HUFF_ERRO_CAPACIDADE;
+
+    if(tipo == BLOCO_CRU){
+
+        if(tam_compactado - pos != tamanho_original) return HUFF_ERRO_FORMATO;
+
+        memcpy(destino, compactado + pos, (size_t)tamanho_original);
+
+    } else if(tipo == BLOCO_DICIONARIO){
+
+        if(decodificar_canonico(compactado + pos, tam_compactado - pos, &d->decodificador, destino, (size_t)tamanho_original) != 0){
+
+            return HUFF_ERRO_FORMATO;
+        }
+
+    } else {
+
+        return HUFF_ERRO_FORMATO;
+    }
+
+    *tam_destino = (size_t)tamanho_original;
+    return HUFF_OK;
+}
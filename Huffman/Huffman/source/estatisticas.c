@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../headers/huffman.h"
+
+// ==================== Estatisticas =======================
+
+static const char *nomes_fases[HUFF_QUANT_FASES] = {"leitura", "histograma", "arvore", "codificacao", "saida"};
+static const char *nomes_blocos[BLOCO_HUFFMAN_4 + 1] = {"cru", "rle", "huffman", "dicionario", "contexto", "huffman_4"};
+
+uint64_t huff_relogio_ns(){
+
+    struct timespec t;
+
+#ifdef _WIN32
+    timespec_get(&t, TIME_UTC);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &t);
+#endif
+
+    return (uint64_t)t.tv_sec * 1000000000u + (uint64_t)t.tv_nsec;
+}
+
+uint64_t huff_marcar_fase(HUFF_ESTATISTICAS *e, int fase, uint64_t inicio){
+
+    uint64_t agora = huff_relogio_ns();
+
+    e->tempo[fase] += agora - inicio;
+
+    return agora;
+}
+
+void huff_somar_estatisticas(HUFF_ESTATISTICAS *destino, const HUFF_ESTATISTICAS *origem){
+
+    for(int f = 0; f < HUFF_QUANT_FASES; f++){
+
+        destino->tempo[f] += origem->tempo[f];
+    }
+
+    for(int t = 0; t <= BLOCO_HUFFMAN_4; t++){
+
+        destino->blocos[t] += origem->blocos[t];
+    }
+
+    destino->simbolos += origem->simbolos;
+    destino->alocacoes += origem->alocacoes;
+    destino->arquivos += origem->arquivos;
+
+    if(origem->altura_arvore > destino->altura_arvore) destino->altura_arvore = origem->altura_arvore;
+    if(origem->maior_codigo > destino->maior_codigo) destino->maior_codigo = origem->maior_codigo;
+}
+
+void huff_imprimir_estatisticas(FILE *saida, const HUFF_ESTATISTICAS *e, uint64_t bytes_entrada, uint64_t bytes_saida, double segundos, int json){
+
+    // os tempos das fases sao somados de todas as threads; com -j > 1 a soma passa do tempo total
+
+    if(json){
+
+        fprintf(saida, "{\"arquivos\": %u, \"bytes_entrada\": %llu, \"bytes_saida\": %llu, \"simbolos\": %llu, ", e->arquivos,
+                (unsigned long long)bytes_entrada, (unsigned long long)bytes_saida, (unsigned long long)e->simbolos);
+        fprintf(saida, "\"altura_arvore\": %d, \"maior_codigo\": %d, \"alocacoes\": %llu, \"blocos\": {", e->altura_arvore,
+                e->maior_codigo, (unsigned long long)e->alocacoes);
+
+        for(int t = 0; t <= BLOCO_HUFFMAN_4; t++){
+
+            fprintf(saida, "%s\"%s\": %llu", t > 0 ? ", " : "", nomes_blocos[t], (unsigned long long)e->blocos[t]);
+        }
+
+        fprintf(saida, "}, \"tempo_ms\": {");
+
+        for(int f = 0; f < HUFF_QUANT_FASES; f++){
+
+            fprintf(saida, "\"%s\": %.3f, ", nomes_fases[f], e->tempo[f] / 1e6);
+        }
+
+        fprintf(saida, "\"total\": %.3f}}\n", segundos * 1e3);
+        return;
+    }
+
+    fprintf(saida, "arquivos:       %u\n", e->arquivos);
+    fprintf(saida, "bytes entrada:  %llu\n", (unsigned long long)bytes_entrada);
+    fprintf(saida, "bytes saida:    %llu", (unsigned long long)bytes_saida);
+
+    if(bytes_entrada > 0) fprintf(saida, " (%.2f%%)", 100.0 * bytes_saida / bytes_entrada);
+
+    fprintf(saida, "\nsimbolos:       %llu\n", (unsigned long long)e->simbolos);
+    fprintf(saida, "altura arvore:  %d (maior codigo: %d bits)\n", e->altura_arvore, e->maior_codigo);
+    fprintf(saida, "alocacoes:      %llu\n", (unsigned long long)e->alocacoes);
+    fprintf(saida, "blocos:        ");
+
+    for(int t = 0; t <= BLOCO_HUFFMAN_4; t++){
+
+        if(e->blocos[t] > 0) fprintf(saida, " %s=%llu", nomes_blocos[t], (unsigned long long)e->blocos[t]);
+    }
+
+    fprintf(saida, "\nfase               ms      MB/s\n");
+
+    for(int f = 0; f < HUFF_QUANT_FASES; f++){
+
+        double ms = e->tempo[f] / 1e6;
+
+        fprintf(saida, "  %-12s %9.3f %9.1f\n", nomes_fases[f], ms, ms > 0 ? bytes_entrada / (ms * 1e3) : 0.0);
+    }
+
+    fprintf(saida, "  %-12s %9.3f %9.1f\n", "total", segundos * 1e3, segundos > 0 ? bytes_entrada / segundos / 1e6 : 0.0);
+}
@@ -0,0 +1,59 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "../headers/huffman.h"
+
+// ==================== Frequencia dos bytes =======================
+
+// Contar direto em frequencia[bytes[i]]++ faz cada incremento esperar o anterior quando o mesmo byte
+// se repete (o valor acabou de ser gravado e ainda nao saiu do store buffer). Com 4 tabelas
+// intercaladas, bytes vizinhos caem em contadores diferentes e os incrementos ficam independentes.
+// As tabelas sao somadas no final; os valores sao acumulados em frequencia[], que deve vir zerado.
+
+#define TABELAS_HISTOGRAMA 4
+
+void calcular_frequencia(const unsigned char *bytes, size_t quantidade, unsigned int frequencia[]){
+
+    uint32_t tabelas[TABELAS_HISTOGRAMA][256];
+    size_t i = 0;
+
+    memset(tabelas, 0, sizeof(tabelas));
+
+    for(; i + 16 <= quantidade; i += 16){ // 16 bytes por iteracao, lidos em 2 palavras de 64 bits
+
+        uint64_t a, b;
+
+        memcpy(&a, bytes + i, 8);
+        memcpy(&b, bytes + i + 8, 8);
+
+        tabelas[0][(unsigned char)(a)]++;
+        tabelas[1][(unsigned char)(a >> 8)]++;
+        tabelas[2][(unsigned char)(a >> 16)]++;
+        tabelas[3][(unsigned char)(a >> 24)]++;
+        tabelas[0][(unsigned char)(a >> 32)]++;
+        tabelas[1][(unsigned char)(a >> 40)]++;
+        tabelas[2][(unsigned char)(a >> 48)]++;
+        tabelas[3][(unsigned char)(a >> 56)]++;
+
+        tabelas[0][(unsigned char)(b)]++;
+        tabelas[1][(unsigned char)(b >> 8)]++;
+        tabelas[2][(unsigned char)(b >> 16)]++;
+        tabelas[3][(unsigned char)(b >> 24)]++;
+        tabelas[0][(unsigned char)(b >> 32)]++;
+        tabelas[1][(unsigned char)(b >> 40)]++;
+        tabelas[2][(unsigned char)(b >> 48)]++;
+        tabelas[3][(unsigned char)(b >> 56)]++;
+    }
+
+    for(; i < quantidade; i++){ // bytes que sobraram
+
+        tabelas[0][bytes[i]]++;
+    }
+
+    for(int j = 0; j < 256; j++){
+
+        frequencia[j] += tabelas[0][j] + tabelas[1][j] + tabelas[2][j] + tabelas[3][j];
+    }
+}
@@ -4,294 +4,332 @@
 #include <stdlib.h>
 #include <stdint.h>
 
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
 #include "../headers/huffman.h"
 
-void zerar_frequencia(unsigned int frequencia[]){
+static void imprimir_uso(){
+
+    fprintf(stderr,
+        "uso: huffman [opcoes] arquivo...\n"
+        "  arquivos terminados em .huff sao descompactados, os demais sao compactados\n"
+        "  -o DIR    grava as saidas em DIR (padrao: ao lado de cada entrada)\n"
+        "  -j N      processa N arquivos ao mesmo tempo (padrao: numero de processadores)\n"
+        "  -b KB     tamanho do bloco ao compactar, em KB (padrao: %d)\n"
+        "  -w N      compacta cada arquivo em pipeline: leitura, N threads compactando e gravacao ao mesmo\n"
+        "            tempo (padrao: automatico quando ha menos arquivos que threads)\n"
+        "  -c        tenta tambem o modelo de ordem 1 (tabela pelo byte anterior; mais lento)\n"
+        "  -l LISTA  le os nomes dos arquivos de LISTA, um por linha\n"
+        "  -p        descompacta a entrada padrao para a saida padrao\n"
+        "  -r INICIO:TAMANHO  descompacta so esse intervalo de cada .huff para a saida padrao\n"
+        "  --verify  confere o CRC de todos os blocos de cada .huff, em paralelo, sem gravar nada\n"
+        "  -t DIC    treina um dicionario com os arquivos dados e grava em DIC\n"
+        "  -D DIC    compacta/descompacta usando o dicionario DIC (bom para arquivos pequenos)\n"
+        "  --stats[=json]  mostra no stderr bytes, simbolos, blocos, alocacoes e o tempo de cada fase\n",
+        HUFF_TAMANHO_BLOCO / 1024);
+}
 
-    for(int i = 0; i < 256; i++){ 
+static int adicionar_entrada(char ***entradas, int *quantidade, int *capacidade, const char *nome){
 
-        frequencia[i] = 0;
-    }
-}
+    if(*quantidade == *capacidade){
 
-char* converte_para_binario(unsigned int num, int tam){
-    
-    int resto = num;
-    char *bits = calloc((tam + 1), sizeof(char));
-    
-    for(int i = 0; i < tam; i++){
-        
-        bits[i] = '0';
-    }
-    
-    int j = tam - 1;
-    
-    while(resto > 0){
-        
-        bits[j] =  (resto % 2) + '0';
-        
-        resto = resto / 2;
-        
-        j--;
-    }
+        int nova_capacidade = (*capacidade > 0) ? *capacidade * 2 : 64;
+        char **novo = realloc(*entradas, nova_capacidade * sizeof(char*));
 
-    bits[tam] = '\0';
-    
-    return bits;
-}
+        if(novo == NULL) return -1;
 
-unsigned int binario_para_unsigned_int(char *texto, int quantidade_bits){
+        *entradas = novo;
+        *capacidade = nova_capacidade;
+    }
 
-    unsigned int soma = 0;
+    (*entradas)[*quantidade] = strdup(nome);
 
-    int aux = quantidade_bits - 1;
+    if((*entradas)[*quantidade] == NULL) return -1;
 
-    for(int i = 0; i < quantidade_bits; i++){
+    (*quantidade)++;
+    return 0;
+}
 
-        soma += (texto[i] - '0') * (int)(pow(2, aux));
+static int ler_lista(const char *caminho, char ***entradas, int *quantidade, int *capacidade){
 
-        aux--;
-    }
+    FILE *lista = fopen(caminho, "r");
+    char linha[4096];
 
-    return soma;
-}
+    if(lista == NULL) return -1;
 
-int main(int argc, char *argv[]){ // EX: ./argumentos.exe arquivo02.png | argc = 2 e argv[2] = {"C:\Users\...\argumentos.exe", "arquivo02.png"}
+    while(fgets(linha, sizeof(linha), lista) != NULL){
 
-    if(argc < 2){ // tentar executar sem passar pelo menos um arquivo retorna erro
+        linha[strcspn(linha, "\r\n")] = '\0'; // tira a quebra de linha
 
-        perror("nenhum arquivo enviado");
-        return 1;
+        if(linha[0] != '\0' && adicionar_entrada(entradas, quantidade, capacidade, linha) != 0){
+
+            fclose(lista);
+            return -1;
+        }
     }
 
-    FILE *arquivo; // Conteudo do arquivo
-    LISTA lista; // Conteudo da lista
-    ARVORE arv_huffman; // Conteudo da arvore
+    fclose(lista);
+    return 0;
+}
 
-    unsigned int frequencia[256] = {0}; // unsigned int: inteiros maiores que zero
-    unsigned char bytes[4096]; // unsigned char vai de 0 a 255 
-    size_t quant_bytes_lidos; // quantidade de bytes lida pelo fread
+static int treinar_dicionario(const char *caminho, char **entradas, int quantidade){
 
-    unsigned char byte = 0;
+    uint64_t frequencia[256] = {0};
+    HUFF_DICIONARIO dicionario;
 
-    char **tabela;
-    char *texto_compactado = malloc(sizeof(char));
-    texto_compactado[0] = '\0';
+    for(int i = 0; i < quantidade; i++){ // histograma somado de todo o corpus
 
-    for(int i = 1; i < argc; i++){
+        ARQUIVO_MAPEADO arquivo;
 
-        arquivo = fopen(argv[i], "rb"); // Abre o arquivo e guarda na variavel
+        if(mapear_entrada(entradas[i], &arquivo) != 0){
 
-        if (!arquivo) {
-            perror("Erro ao abrir o arquivo");
-            return 1;
+            perror(entradas[i]);
+            return -1;
         }
 
-        inicializar_lista(&lista);
-        inicializar_arvore(&arv_huffman);
-
-        if(strstr(argv[i], ".huff")){ // se .huff descompactar
+        for(size_t inicio = 0; inicio < arquivo.tamanho; inicio += 1u << 30){ // contadores de 32 bits
 
-            int tam_arv = 0; // Guardar tamanho da arvore
-            int trash = 0; // Guardar lixo
+            unsigned int parcial[256] = {0};
+            size_t n = arquivo.tamanho - inicio;
 
-            // ==== INICIO ======================== PEGAR OS 2 PRIMEIROS BYTES (LIXO + TAM_ARVORE) ==================================
+            if(n > 1u << 30) n = 1u << 30;
 
-            char *byte_texto = malloc(14 * sizeof(char));
-            byte_texto[0] = '\0';
+            calcular_frequencia(arquivo.dados + inicio, n, parcial);
 
-            char bits_lixo[4];
-            bits_lixo[0] = '\0';
+            for(int b = 0; b < 256; b++){
 
-            if(fread(&byte, 1, 1, arquivo) == 1){
+                frequencia[b] += parcial[b];
+            }
+        }
 
-                char *bits_8 = converte_para_binario(byte, 8);
-                strcat(byte_texto, bits_8); // byte_texto recebe o byte ex: 10100000
-                byte_texto[8] = '\0';
+        desmapear(&arquivo);
+    }
 
-                strncpy(bits_lixo, byte_texto, 3); // copia os 3 primeiros bits para bits_lixo ex: 101
-                bits_lixo[3] = '\0';
+    huff_treinar_dicionario(&dicionario, frequencia);
 
-                memmove(byte_texto, byte_texto + 3, 5); // move os 5 bits restantes para o incio de byte_texto ex: 00000
-                byte_texto[5] = '\0';
+    int erro = huff_salvar_dicionario(&dicionario, caminho);
 
-                trash = binario_para_unsigned_int(bits_lixo, 3);
+    if(erro != HUFF_OK){
 
-                free(bits_8);
-            }
+        fprintf(stderr, "%s: %s\n", caminho, huff_mensagem_erro(erro));
+        return -1;
+    }
 
-            if(fread(&byte, 1, 1, arquivo) == 1){
+    fprintf(stderr, "dicionario %08x gravado em %s (%d arquivos)\n", (unsigned int)dicionario.id, caminho, quantidade);
+    return 0;
+}
 
-                char *bits_8 = converte_para_binario(byte, 8);
+int main(int argc, char *argv[]){ // EX: ./huffman arquivo02.png | ./huffman -j 8 -o saida/ *.txt
 
-                strcat(byte_texto, bits_8); // concatena outro byte
-                byte_texto[13] = '\0';
+    HUFF_CONTEXTO ctx;
 
-                tam_arv = binario_para_unsigned_int(byte_texto, 13);
+    char **entradas = NULL; // arquivos a processar
+    int quant_entradas = 0, capacidade = 0;
 
-                free(bits_8);
-            }
+    const char *diretorio_saida = NULL;
+    int threads = 1;
+    int stream = 0;
+    int intervalo = 0;
+    int verificar = 0;
+    const char *treino = NULL; // -t: caminho do dicionario a gravar
+    HUFF_DICIONARIO dicionario;
+    unsigned long long inicio_intervalo = 0, tam_intervalo = 0;
+    HUFF_ESTATISTICAS estatisticas;
+    int formato_stats = -1; // -1 = sem --stats, 0 = texto, 1 = JSON
 
-            //printf("%d, %d ", trash, tam_arv);
-                
-            // ==== FIM =====================================================================================
+#ifndef _WIN32
+    threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
 
-            // ==== INICIO ======================== RECONSTRUIR ARVORE ==============================================
+    huff_inicializar_contexto(&ctx);
 
-            arv_huffman.raiz = reconstruir_arvore(arquivo, tam_arv);
+    for(int i = 1; i < argc; i++){
 
-            //imprimir_pre_ordem(arv_huffman.raiz);
+        if(strcmp(argv[i], "-o") == 0 && i + 1 < argc){
 
-            // ==== FIM =====================================================================================
+            diretorio_saida = argv[++i];
+        } else if(strcmp(argv[i], "-j") == 0 && i + 1 < argc){
 
-            // ==== INICIO ======================== LENDO OS BYTES COMPACTADOS ==============================================
+            threads = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "-b") == 0 && i + 1 < argc){
 
-            char *texto_comprimido = malloc(sizeof(char));
-            texto_comprimido[0] = '\0';
+            int kb = atoi(argv[++i]);
 
-            int tam_texto_comprimido = 0;
+            if(kb <= 0 || kb > (int)(HUFF_MAXIMO_BLOCO / 1024)){
 
-            while ((quant_bytes_lidos = fread(bytes, 1, 4096, arquivo)) > 0) {
-                
-                for (size_t i = 0; i < quant_bytes_lidos; i++) {
+                fprintf(stderr, "tamanho de bloco invalido: %s\n", argv[i]);
+                return 1;
+            }
 
-                    tam_texto_comprimido += 8;
-                    
-                    texto_comprimido = realloc(texto_comprimido, (tam_texto_comprimido + 1) * sizeof(char));
+            ctx.tamanho_bloco = (uint32_t)kb * 1024;
+        } else if(strcmp(argv[i], "-w") == 0 && i + 1 < argc){
 
-                    char *bits_8 = converte_para_binario(bytes[i], 8);
+            ctx.trabalhadores = atoi(argv[++i]);
 
-                    strcat(texto_comprimido, bits_8);
+            if(ctx.trabalhadores < 1){
 
-                    free(bits_8);
-                }
+                fprintf(stderr, "quantidade de threads invalida: %s\n", argv[i]);
+                return 1;
             }
+        } else if(strcmp(argv[i], "-l") == 0 && i + 1 < argc){
 
-            //printf(" %s %d", texto_comprimido, strlen(texto_comprimido));
+            if(ler_lista(argv[++i], &entradas, &quant_entradas, &capacidade) != 0){
 
-            // ==== FIM =====================================================================================
-
-            // ==== INICIO ======================== DESCOMPACTANDO TEXTO E GERAR ARQUIVO =============================
+                perror("Erro ao ler a lista de arquivos");
+                return 1;
+            }
+        } else if(strcmp(argv[i], "-r") == 0 && i + 1 < argc){
 
-            FILE *saida = fopen("../Saida/arquivo02.png", "wb");
+            if(sscanf(argv[++i], "%llu:%llu", &inicio_intervalo, &tam_intervalo) != 2){
 
-            escrever_arquivo_descompactado(texto_comprimido, arv_huffman.raiz, trash, saida);
+                fprintf(stderr, "intervalo invalido: %s\n", argv[i]);
+                return 1;
+            }
 
-            // ==== FIM =====================================================================================
+            intervalo = 1;
+        } else if(strcmp(argv[i], "-t") == 0 && i + 1 < argc){
 
-        } else { // compactar
+            treino = argv[++i];
+        } else if(strcmp(argv[i], "-D") == 0 && i + 1 < argc){
 
-            // ==== INICIO ======================== FREQUENCIA DE CADA BYTE ==================================
+            int erro = huff_carregar_dicionario(&dicionario, argv[++i]);
 
-            while ((quant_bytes_lidos = fread(bytes, 1, 4096, arquivo)) > 0) { 
-                
-                for (size_t i = 0; i < quant_bytes_lidos; i++) {
+            if(erro != HUFF_OK){
 
-                    frequencia[bytes[i]]++;
-                }
+                fprintf(stderr, "%s: %s\n", argv[i], huff_mensagem_erro(erro));
+                return 1;
             }
 
-            // ==== FIM =====================================================================================
+            ctx.dicionario = &dicionario; // as threads do lote dividem o mesmo dicionario
+        } else if(strcmp(argv[i], "--stats") == 0 || strcmp(argv[i], "--stats=json") == 0){
 
-            // ==== INICIO ======================== GERAR LISTA ENCADEADA ORDENADA ===========================
+            formato_stats = (argv[i][7] == '=');
+        } else if(strcmp(argv[i], "--verify") == 0){
 
-            for(int i = 0; i < 256; i++){ 
+            verificar = 1;
+        } else if(strcmp(argv[i], "-c") == 0){
 
-                if(frequencia[i] > 0){ 
+            ctx.ordem = 1;
+        } else if(strcmp(argv[i], "-p") == 0){
 
-                    inserir_na_lista_ordenado(&lista, i, frequencia[i], NULL);
-                }
+            stream = 1;
+        } else if(argv[i][0] == '-' && argv[i][1] != '\0'){
 
-                //printf("byte(%d): %d\n", i, frequencia[i]);
-            }
+            imprimir_uso();
+            return 1;
+        } else if(adicionar_entrada(&entradas, &quant_entradas, &capacidade, argv[i]) != 0){
 
-            // ==== FIM =====================================================================================
+            perror("Erro ao guardar o nome do arquivo");
+            return 1;
+        }
+    }
 
-            // ==== INICIO ======================== GERAR ARVORE DE HUFFMAN =================================
+    if(formato_stats >= 0){ // ex: ./huffman --stats=json arquivo.txt
 
-            criar_arvore_huffman(&lista, &arv_huffman);
+        memset(&estatisticas, 0, sizeof(HUFF_ESTATISTICAS));
+        ctx.estatisticas = &estatisticas;
+    }
 
-            // ==== FIM =====================================================================================
+    uint64_t inicio = (formato_stats >= 0) ? huff_relogio_ns() : 0;
 
-            // ==== INICIO ======================== GERAR TABELA DE BITS ====================================
+    if(stream){ // ex: ./huffman -p < arquivo.huff > arquivo
 
-            int altura_arv = altura_arvore(arv_huffman.raiz);
+        int erro = huff_descompactar_stream(&ctx, stdin, stdout);
 
-            tabela = aloca_tabela(altura_arv);
+        if(erro != HUFF_OK) fprintf(stderr, "entrada padrao: %s\n", huff_mensagem_erro(erro));
 
-            gerar_tabela(arv_huffman.raiz, tabela, "", altura_arv);
+        fflush(stdout);
 
-            // ==== FIM =====================================================================================
+        if(formato_stats >= 0){
 
-            // ==== INICIO ======================== GERAR TEXTO COMPACTADO ====================================
-            
-            int tam_texto = 0; // tamanho do texto compactado
+            huff_imprimir_estatisticas(stderr, &estatisticas, ctx.bytes_entrada, ctx.bytes_saida, (huff_relogio_ns() - inicio) / 1e9, formato_stats);
+        }
+
+        return erro != HUFF_OK;
+    }
 
-            fclose(arquivo);
+    if(quant_entradas == 0){ // tentar executar sem passar pelo menos um arquivo retorna erro
 
-            arquivo = fopen(argv[i], "rb"); // abre o arquivo novamente do inicio
+        imprimir_uso();
+        return 1;
+    }
 
+    int falhas = 0;
 
-            while ((quant_bytes_lidos = fread(bytes, 1, 4096, arquivo)) > 0) {
-                
-                for (size_t i = 0; i < quant_bytes_lidos; i++) {
-                    
-                    tam_texto += strlen(tabela[bytes[i]]);
+    if(treino != NULL){ // ex: ./huffman -t textos.hufd amostras/*.txt
 
-                    texto_compactado = realloc(texto_compactado, (tam_texto + 1) * sizeof(char));
+        falhas = (treinar_dicionario(treino, entradas, quant_entradas) != 0);
 
-                    char *bits_8 = tabela[bytes[i]];
+    } else if(verificar){ // ex: ./huffman --verify -j 8 arquivo.huff
 
-                    strcat(texto_compactado, bits_8);
-                }
-            }
+        for(int i = 0; i < quant_entradas; i++){
 
-            int trash = 8 - (tam_texto % 8); // bits lixo 
+            HUFF_RESULTADO_VERIFICACAO resultado;
+            int erro = huff_verificar_arquivo(entradas[i], threads, &resultado);
 
-            if(trash == 8) trash = 0;
+            if(resultado.invalidos > 0){
 
-            tam_texto += trash;
+                fprintf(stderr, "%s: %u de %u blocos invalidos (primeiro: bloco %lld, offset %llu)\n", entradas[i], resultado.invalidos,
+                        resultado.blocos, resultado.primeiro_invalido, (unsigned long long)resultado.offset_invalido);
+                falhas++;
+            } else if(resultado.indice_invalido){
 
-            texto_compactado = realloc(texto_compactado, (tam_texto + 1) * sizeof(char));
+                fprintf(stderr, "%s: indice de blocos inconsistente (%u blocos conferidos pelos cabecalhos)\n", entradas[i], resultado.blocos);
+                falhas++;
+            } else if(erro != HUFF_OK){
 
-            for(int i = trash; i > 0; i--){
+                fprintf(stderr, "%s: %s\n", entradas[i], huff_mensagem_erro(erro));
+                falhas++;
+            } else {
 
-                strcat(texto_compactado, "0");
+                printf("%s: ok (%u blocos%s)\n", entradas[i], resultado.blocos, resultado.sem_crc > 0 ? ", alguns sem CRC" : "");
             }
+        }
+
+    } else if(intervalo){ // ex: ./huffman -r 1048576:4096 arquivo.huff > trecho
+
+        unsigned char *trecho = malloc(tam_intervalo > 0 ? tam_intervalo : 1);
+
+        for(int i = 0; trecho != NULL && i < quant_entradas; i++){
 
-            // ==== FIM =====================================================================================
+            HUFF_ARQUIVO arquivo;
+            int erro = huff_abrir(&arquivo, entradas[i]);
+            long long lidos = (erro == HUFF_OK) ? huff_pread(&arquivo, trecho, tam_intervalo, inicio_intervalo) : erro;
 
-            // ==== INICIO ======================== GERAR O ARQUIVO COMPACTADO ================================
+            if(lidos < 0){
 
-            char nome_saida[150];
+                fprintf(stderr, "%s: %s\n", entradas[i], huff_mensagem_erro((int)lidos));
+                falhas++;
+            } else {
 
-            char base[100]; 
+                fwrite(trecho, 1, (size_t)lidos, stdout);
+            }
 
-            strncpy(base, argv[i], (strlen(argv[i]) - strlen(strstr(argv[i], ".")))); // ex: se argv[i] = arquivo.png || base = arquivo
+            if(erro == HUFF_OK) huff_fechar(&arquivo);
+        }
 
-            base[strlen(base)] = '\0';
+        if(trecho == NULL) falhas++;
 
-            sprintf(nome_saida, "../Saida/%s.huff", base); // se base = arquivo || nome_saida = Saida/arquivo.huff
+        free(trecho);
 
-            FILE *saida = fopen(nome_saida, "wb");
+    } else {
 
-            escrever_arquivo_compactado(saida, trash, arv_huffman.tam_arvore, arv_huffman.raiz, texto_compactado, tam_texto);
+        falhas = huff_processar_lote(&ctx, entradas, quant_entradas, diretorio_saida, threads);
 
-            // ==== FIM =====================================================================================
+        if(formato_stats >= 0){
 
-            trash = 0;
-            tam_texto = 0;
-            fclose(saida);
-            liberar_tabela(tabela);
+            huff_imprimir_estatisticas(stderr, &estatisticas, ctx.bytes_entrada, ctx.bytes_saida, (huff_relogio_ns() - inicio) / 1e9, formato_stats);
         }
+    }
+
+    for(int i = 0; i < quant_entradas; i++){
 
-        zerar_frequencia(frequencia);
-        free(lista.inicio);
-        free(arv_huffman.raiz);
-        fclose(arquivo);
-        
-        //printf("\n");
+        free(entradas[i]);
     }
 
-    return 0;
-}
\ No newline at end of file
+    free(entradas);
+
+    return falhas > 0;
+}
@@ -0,0 +1,289 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "../headers/huffman.h"
+
+// ==================== Indice de blocos =======================
+
+// Depois do ultimo bloco vem o indice: uma entrada por bloco com (offset original, offset
+// compactado, tipo), seguida de um rodape com a quantidade de blocos, o offset do indice e o
+// magico "HUFI". Quem descompacta em sequencia para depois de tamanho_original bytes e nem chega a
+// ler o indice; huff_pread usa o indice para descompactar so os blocos que cobrem o intervalo.
+
+void escrever_entrada_indice(unsigned char *destino, uint64_t offset_original, uint64_t offset_compactado, unsigned char tipo){
+
+    escrever_u64(destino, offset_original);
+    escrever_u64(destino + 8, offset_compactado);
+    destino[16] = tipo;
+}
+
+void escrever_rodape_indice(unsigned char *destino, uint32_t quantidade, uint64_t inicio_indice){
+
+    escrever_u32(destino, quantidade);
+    escrever_u64(destino + 4, inicio_indice);
+    memcpy(destino + 12, HUFF_MAGICO_INDICE, 4);
+}
+
+size_t escrever_indice(unsigned char *arquivo, size_t fim_blocos){
+
+    size_t pos = fim_blocos;
+    size_t bloco = HUFF_CABECALHO_ARQUIVO;
+    uint64_t original = 0;
+    uint32_t quantidade = 0;
+
+    while(bloco < fim_blocos){ // os offsets saem dos proprios cabecalhos dos blocos
+
+        escrever_entrada_indice(arquivo + pos, original, bloco, arquivo[bloco]);
+
+        original += ler_u32(arquivo + bloco + 1);
+        bloco += HUFF_CABECALHO_BLOCO + ler_u32(arquivo + bloco + 5);
+        pos += HUFF_ENTRADA_INDICE;
+        quantidade++;
+    }
+
+    escrever_rodape_indice(arquivo + pos, quantidade, fim_blocos);
+
+    return pos + HUFF_RODAPE_INDICE;
+}
+
+static int ler_indice(HUFF_ARQUIVO *a){ // 0 = indice valido carregado, -1 = sem indice, -2 = indice inconsistente
+
+    const unsigned char *d = a->dados;
+    size_t n = a->tamanho;
+
+    if(n < HUFF_CABECALHO_ARQUIVO + HUFF_RODAPE_INDICE || memcmp(d + n - 4, HUFF_MAGICO_INDICE, 4) != 0) return -1;
+
+    uint32_t quantidade = ler_u32(d + n - HUFF_RODAPE_INDICE);
+    uint64_t inicio = ler_u64(d + n - HUFF_RODAPE_INDICE + 4);
+
+    if(inicio < HUFF_CABECALHO_ARQUIVO || inicio > n || (n - HUFF_RODAPE_INDICE - inicio) != (uint64_t)quantidade * HUFF_ENTRADA_INDICE) return -2;
+
+    if((quantidade == 0) != (a->tamanho_original == 0)) return -2; // indice vazio so para arquivo vazio
+
+    a->blocos = malloc((quantidade > 0 ? quantidade : 1) * sizeof(ENTRADA_INDICE));
+
+    if(a->blocos == NULL) return -1;
+
+    for(uint32_t i = 0; i < quantidade; i++){
+
+        const unsigned char *e = d + inicio + (size_t)i * HUFF_ENTRADA_INDICE;
+
+        a->blocos[i].offset_original = ler_u64(e);
+        a->blocos[i].offset_compactado = ler_u64(e + 8);
+        a->blocos[i].tipo = e[16];
+
+        // offsets crescentes e dentro da area de blocos; os blocos sao contiguos a partir do offset 0
+        // e nenhum passa do tamanho de bloco do cabecalho
+        int valido = a->blocos[i].offset_compactado >= HUFF_CABECALHO_ARQUIVO && a->blocos[i].offset_compactado < inicio && a->blocos[i].offset_original < a->tamanho_original;
+
+        if(i == 0) valido = valido && a->blocos[i].offset_original == 0 && a->blocos[i].offset_compactado == HUFF_CABECALHO_ARQUIVO;
+
+        if(i > 0) valido = valido && a->blocos[i].offset_original > a->blocos[i - 1].offset_original && a->blocos[i].offset_compactado > a->blocos[i - 1].offset_compactado &&
+                           a->blocos[i].offset_original - a->blocos[i - 1].offset_original <= a->tamanho_bloco;
+
+        if(i == quantidade - 1) valido = valido && a->tamanho_original - a->blocos[i].offset_original <= a->tamanho_bloco; // o ultimo fecha o arquivo
+
+        if(!valido){
+
+            free(a->blocos);
+            a->blocos = NULL;
+            return -2;
+        }
+    }
+
+    a->quant_blocos = quantidade;
+    a->fim_blocos = inicio;
+    return 0;
+}
+
+static int varrer_blocos(HUFF_ARQUIVO *a){ // arquivo sem indice: percorre os cabecalhos, sem descompactar
+
+    size_t capacidade = 16;
+    size_t pos = HUFF_CABECALHO_ARQUIVO;
+    uint64_t original = 0;
+
+    a->blocos = malloc(capacidade * sizeof(ENTRADA_INDICE));
+    a->quant_blocos = 0;
+
+    while(a->blocos != NULL && original < a->tamanho_original){
+
+        if(a->tamanho - pos < HUFF_CABECALHO_BLOCO) break;
+
+        if(a->quant_blocos == capacidade){
+
+            ENTRADA_INDICE *novo = realloc(a->blocos, 2 * capacidade * sizeof(ENTRADA_INDICE));
+
+            if(novo == NULL) break;
+
+            a->blocos = novo;
+            capacidade *= 2;
+        }
+
+        ENTRADA_INDICE *e = &a->blocos[a->quant_blocos++];
+
+        e->offset_original = original;
+        e->offset_compactado = pos;
+        e->tipo = a->dados[pos];
+
+        original += ler_u32(a->dados + pos + 1);
+        pos += HUFF_CABECALHO_BLOCO + (size_t)ler_u32(a->dados + pos + 5);
+
+        if(pos > a->tamanho) break;
+    }
+
+    if(original != a->tamanho_original){
+
+        free(a->blocos);
+        a->blocos = NULL;
+        return -1;
+    }
+
+    a->fim_blocos = pos;
+    return 0;
+}
+
+int huff_abrir_buffer(HUFF_ARQUIVO *a, const unsigned char *dados, size_t tamanho){
+
+    uint32_t tamanho_bloco;
+
+    memset(a, 0, sizeof(HUFF_ARQUIVO));
+    a->mapa.descritor = -1;
+    a->dados = dados;
+    a->tamanho = tamanho;
+    a->bloco_em_cache = -1;
+
+    if(ler_cabecalho_arquivo(dados, tamanho, &a->tamanho_original, &tamanho_bloco) != 0) return HUFF_ERRO_FORMATO;
+
+    a->tamanho_bloco = tamanho_bloco;
+
+    int indice = ler_indice(a);
+
+    a->indice_invalido = (indice == -2);
+
+    if(indice != 0 && varrer_blocos(a) != 0) return HUFF_ERRO_FORMATO;
+
+    a->cache = malloc(tamanho_bloco);
+
+    if(a->cache == NULL){
+
+        free(a->blocos);
+        a->blocos = NULL;
+        return HUFF_ERRO_MEMORIA;
+    }
+
+    return HUFF_OK;
+}
+
+int huff_abrir(HUFF_ARQUIVO *a, const char *caminho){
+
+    ARQUIVO_MAPEADO mapa;
+
+    if(mapear_entrada(caminho, &mapa) != 0) return HUFF_ERRO_ES;
+
+    int erro = huff_abrir_buffer(a, mapa.dados, mapa.tamanho);
+
+    a->mapa = mapa;
+
+    if(erro != HUFF_OK) huff_fechar(a);
+
+    return erro;
+}
+
+void huff_fechar(HUFF_ARQUIVO *a){
+
+    free(a->blocos);
+    free(a->cache);
+
+    a->blocos = NULL;
+    a->cache = NULL;
+
+    if(a->mapa.descritor >= 0 || a->mapa.dados != NULL) desmapear(&a->mapa);
+}
+
+static uint64_t fim_do_bloco(HUFF_ARQUIVO *a, uint32_t i){ // offset original logo apos o bloco i
+
+    return (i + 1 < a->quant_blocos) ? a->blocos[i + 1].offset_original : a->tamanho_original;
+}
+
+static int descompactar_bloco_indice(HUFF_ARQUIVO *a, uint32_t i, unsigned char *destino){
+
+    size_t lidos, escritos;
+    uint64_t offset = a->blocos[i].offset_compactado;
+    size_t quantidade = (size_t)(fim_do_bloco(a, i) - a->blocos[i].offset_original);
+
+    if(quantidade > a->tamanho_bloco) return HUFF_ERRO_FORMATO;
+
+    if(descompactar_bloco(a->dados + offset, a->tamanho - offset, destino, quantidade, &lidos, &escritos) != 0 || escritos != quantidade){
+
+        return HUFF_ERRO_FORMATO;
+    }
+
+    return HUFF_OK;
+}
+
+long long huff_pread(HUFF_ARQUIVO *a, void *destino, size_t quantidade, uint64_t offset){
+
+    unsigned char *saida = destino;
+
+    if(offset >= a->tamanho_original || quantidade == 0) return 0;
+
+    if(quantidade > a->tamanho_original - offset) quantidade = (size_t)(a->tamanho_original - offset);
+
+    if(a->quant_blocos == 0) return HUFF_ERRO_FORMATO; // huff_abrir so aceita indice vazio para arquivo vazio
+
+    // busca binaria pelo bloco que contem o offset
+
+    uint32_t esq = 0, dir = a->quant_blocos - 1;
+
+    while(esq < dir){
+
+        uint32_t meio = esq + (dir - esq + 1) / 2;
+
+        if(a->blocos[meio].offset_original <= offset) esq = meio;
+        else dir = meio - 1;
+    }
+
+    size_t copiados = 0;
+
+    for(uint32_t i = esq; copiados < quantidade && i < a->quant_blocos; i++){
+
+        uint64_t inicio_bloco = a->blocos[i].offset_original;
+        uint64_t fim_bloco = fim_do_bloco(a, i);
+        uint64_t de = offset + copiados;
+        if(de < inicio_bloco || de >= fim_bloco) return HUFF_ERRO_FORMATO; // indice inconsistente; huff_abrir ja rejeita
+
+        size_t parte = (size_t)(fim_bloco - de);
+
+        if(parte > quantidade - copiados) parte = quantidade - copiados;
+
+        if(de == inicio_bloco && parte == fim_bloco - inicio_bloco){ // bloco inteiro: direto no destino
+
+            int erro = descompactar_bloco_indice(a, i, saida + copiados);
+
+            if(erro != HUFF_OK) return erro;
+
+        } else { // pedaco do bloco: passa pelo cache (leituras pequenas seguidas caem no mesmo bloco)
+
+            if(a->bloco_em_cache != (long long)i){
+
+                int erro = descompactar_bloco_indice(a, i, a->cache);
+
+                if(erro != HUFF_OK){
+
+                    a->bloco_em_cache = -1;
+                    return erro;
+                }
+
+                a->bloco_em_cache = i;
+            }
+
+            memcpy(saida + copiados, a->cache + (de - inicio_bloco), parte);
+        }
+
+        copiados += parte;
+    }
+
+    return (long long)copiados;
+}
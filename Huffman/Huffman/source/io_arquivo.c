@@ -0,0 +1,187 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "../headers/huffman.h"
+
+// ==================== Arquivos mapeados em memoria =======================
+
+// A entrada e mapeada somente para leitura e a saida e criada ja com o tamanho maximo (ftruncate)
+// e mapeada para escrita, entao o codificador escreve direto no arquivo final, sem fread/fwrite
+// nem buffers intermediarios. No Windows (sem mmap) o mesmo contrato e cumprido com um buffer
+// unico lido/escrito de uma vez.
+
+#ifndef _WIN32
+
+int mapear_entrada(const char *caminho, ARQUIVO_MAPEADO *m){
+
+    struct stat info;
+
+    m->dados = NULL;
+    m->tamanho = 0;
+    m->descritor = open(caminho, O_RDONLY);
+
+    if(m->descritor < 0) return -1;
+
+    if(fstat(m->descritor, &info) != 0){
+
+        close(m->descritor);
+        return -1;
+    }
+
+    m->tamanho = (size_t)info.st_size;
+
+    if(m->tamanho > 0){ // mmap de tamanho zero falha
+
+        m->dados = mmap(NULL, m->tamanho, PROT_READ, MAP_PRIVATE, m->descritor, 0);
+
+        if(m->dados == MAP_FAILED){
+
+            close(m->descritor);
+            return -1;
+        }
+
+        madvise(m->dados, m->tamanho, MADV_SEQUENTIAL);
+    }
+
+    return 0;
+}
+
+int criar_saida_mapeada(const char *caminho, size_t tamanho, ARQUIVO_MAPEADO *m){
+
+    m->dados = NULL;
+    m->tamanho = tamanho;
+    m->descritor = open(caminho, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+    if(m->descritor < 0) return -1;
+
+    if(tamanho > 0){
+
+        // reserva os blocos no disco antes de mapear: com so ftruncate o arquivo fica esparso e
+        // um disco cheio so apareceria como SIGBUS ao escrever no mapeamento
+        if(posix_fallocate(m->descritor, 0, (off_t)tamanho) != 0){
+
+            close(m->descritor);
+            unlink(caminho); // o que chegou a ser reservado volta para o disco
+            return -1;
+        }
+
+        m->dados = mmap(NULL, tamanho, PROT_READ | PROT_WRITE, MAP_SHARED, m->descritor, 0);
+
+        if(m->dados == MAP_FAILED){
+
+            close(m->descritor);
+            unlink(caminho);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+void desmapear(ARQUIVO_MAPEADO *m){
+
+    if(m->dados != NULL) munmap(m->dados, m->tamanho);
+
+    if(m->descritor >= 0) close(m->descritor);
+
+    m->dados = NULL;
+    m->descritor = -1;
+}
+
+int fechar_saida_mapeada(ARQUIVO_MAPEADO *m, size_t tamanho_final){ // corta a sobra reservada
+
+    int erro = 0;
+
+    if(m->dados != NULL) munmap(m->dados, m->tamanho);
+
+    if(ftruncate(m->descritor, (off_t)tamanho_final) != 0) erro = -1;
+
+    close(m->descritor);
+
+    m->dados = NULL;
+    m->descritor = -1;
+    return erro;
+}
+
+#else
+
+int mapear_entrada(const char *caminho, ARQUIVO_MAPEADO *m){
+
+    FILE *arquivo = fopen(caminho, "rb");
+
+    m->dados = NULL;
+    m->tamanho = 0;
+    m->descritor = -1;
+    m->arquivo = NULL;
+
+    if(arquivo == NULL) return -1;
+
+    fseek(arquivo, 0, SEEK_END);
+
+    m->tamanho = (size_t)ftell(arquivo);
+
+    rewind(arquivo);
+
+    m->dados = malloc(m->tamanho > 0 ? m->tamanho : 1);
+
+    if(m->dados == NULL || fread(m->dados, 1, m->tamanho, arquivo) != m->tamanho){
+
+        free(m->dados);
+        fclose(arquivo);
+        return -1;
+    }
+
+    fclose(arquivo);
+    return 0;
+}
+
+int criar_saida_mapeada(const char *caminho, size_t tamanho, ARQUIVO_MAPEADO *m){
+
+    m->tamanho = tamanho;
+    m->descritor = -1;
+    m->arquivo = fopen(caminho, "wb");
+    m->dados = malloc(tamanho > 0 ? tamanho : 1);
+
+    if(m->arquivo == NULL || m->dados == NULL){
+
+        if(m->arquivo != NULL){
+
+            fclose(m->arquivo);
+            remove(caminho);
+        }
+
+        free(m->dados);
+        return -1;
+    }
+
+    return 0;
+}
+
+void desmapear(ARQUIVO_MAPEADO *m){
+
+    free(m->dados);
+    m->dados = NULL;
+}
+
+int fechar_saida_mapeada(ARQUIVO_MAPEADO *m, size_t tamanho_final){
+
+    int erro = (fwrite(m->dados, 1, tamanho_final, m->arquivo) == tamanho_final) ? 0 : -1;
+
+    fclose(m->arquivo);
+    free(m->dados);
+
+    m->dados = NULL;
+    m->arquivo = NULL;
+    return erro;
+}
+
+#endif
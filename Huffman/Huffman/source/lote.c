@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "../headers/huffman.h"
+
+// ==================== Modo lote =======================
+
+typedef struct{
+    char **entradas;
+    int quantidade;
+    const char *diretorio_saida; // NULL = saida ao lado da entrada
+    HUFF_CONTEXTO modelo; // configuracao copiada para o contexto de cada thread
+    int proximo; // proximo arquivo ainda nao processado
+    int falhas;
+    uint64_t bytes_entrada; // soma dos contadores das threads
+    uint64_t bytes_saida;
+    pthread_mutex_t trava;
+}LOTE;
+
+static int termina_com(const char *texto, const char *sufixo){
+
+    size_t a = strlen(texto), b = strlen(sufixo);
+
+    return a >= b && strcmp(texto + a - b, sufixo) == 0;
+}
+
+char* huff_caminho_saida(const char *entrada, const char *diretorio_saida, int descompactar){
+
+    // compactar: arquivo.png -> arquivo.png.huff | descompactar: arquivo.png.huff -> arquivo.png
+    // com diretorio_saida, o arquivo vai para diretorio_saida/<nome sem o caminho>
+
+    const char *nome = entrada;
+
+    if(diretorio_saida != NULL){
+
+        for(const char *c = entrada; *c; c++){
+
+            if(*c == '/' || *c == '\\') nome = c + 1;
+        }
+    }
+
+    size_t tam_nome = strlen(nome);
+    size_t tam_diretorio = (diretorio_saida != NULL) ? strlen(diretorio_saida) : 0;
+
+    if(descompactar && termina_com(nome, ".huff")) tam_nome -= 5;
+
+    char *caminho = malloc(tam_diretorio + 1 + tam_nome + 6 + 4 + 1);
+
+    if(caminho == NULL) return NULL;
+
+    size_t pos = 0;
+
+    if(diretorio_saida != NULL){
+
+        memcpy(caminho, diretorio_saida, tam_diretorio);
+        pos = tam_diretorio;
+
+        if(pos > 0 && caminho[pos - 1] != '/' && caminho[pos - 1] != '\\') caminho[pos++] = '/';
+    }
+
+    memcpy(caminho + pos, nome, tam_nome);
+    pos += tam_nome;
+
+    if(!descompactar){
+
+        memcpy(caminho + pos, ".huff", 5);
+        pos += 5;
+    } else if(!termina_com(nome, ".huff")){ // sem a extensao nao ha como tirar: evita sobrescrever a entrada
+
+        memcpy(caminho + pos, ".out", 4);
+        pos += 4;
+    }
+
+    caminho[pos] = '\0';
+    return caminho;
+}
+
+static void* trabalhar(void *arg){
+
+    LOTE *lote = arg;
+    HUFF_CONTEXTO ctx = lote->modelo; // cada thread tem o seu contexto
+    HUFF_ESTATISTICAS estatisticas; // e as suas estatisticas, somadas no final sem disputar a trava
+
+    if(ctx.estatisticas != NULL){
+
+        memset(&estatisticas, 0, sizeof(HUFF_ESTATISTICAS));
+        ctx.estatisticas = &estatisticas;
+    }
+
+    for(;;){
+
+        pthread_mutex_lock(&lote->trava);
+
+        int i = lote->proximo++;
+
+        pthread_mutex_unlock(&lote->trava);
+
+        if(i >= lote->quantidade) break;
+
+        const char *entrada = lote->entradas[i];
+        int descompactar = termina_com(entrada, ".huff");
+        char *saida = huff_caminho_saida(entrada, lote->diretorio_saida, descompactar);
+        int erro = HUFF_ERRO_MEMORIA;
+
+        if(saida != NULL){
+
+            if(ctx.estatisticas != NULL) ctx.estatisticas->alocacoes++;
+
+            erro = descompactar ? huff_descompactar_arquivo(&ctx, entrada, saida) : huff_compactar_arquivo(&ctx, entrada, saida);
+        }
+
+        if(erro != HUFF_OK){
+
+            fprintf(stderr, "%s: %s\n", entrada, huff_mensagem_erro(erro));
+
+            pthread_mutex_lock(&lote->trava);
+            lote->falhas++;
+            pthread_mutex_unlock(&lote->trava);
+        }
+
+        free(saida);
+    }
+
+    pthread_mutex_lock(&lote->trava);
+
+    lote->bytes_entrada += ctx.bytes_entrada - lote->modelo.bytes_entrada;
+    lote->bytes_saida += ctx.bytes_saida - lote->modelo.bytes_saida;
+
+    if(ctx.estatisticas != NULL) huff_somar_estatisticas(lote->modelo.estatisticas, ctx.estatisticas);
+
+    pthread_mutex_unlock(&lote->trava);
+
+    return NULL;
+}
+
+int huff_processar_lote(HUFF_CONTEXTO *modelo, char **entradas, int quantidade, const char *diretorio_saida, int threads){
+
+    LOTE lote;
+
+    lote.entradas = entradas;
+    lote.quantidade = quantidade;
+    lote.diretorio_saida = diretorio_saida;
+    lote.modelo = *modelo;
+    lote.proximo = 0;
+    lote.falhas = 0;
+    lote.bytes_entrada = 0;
+    lote.bytes_saida = 0;
+
+    pthread_mutex_init(&lote.trava, NULL);
+
+    if(lote.modelo.trabalhadores == 0 && quantidade > 0 && threads / quantidade >= 2){ // menos arquivos que threads: as que sobram compactam blocos
+
+        lote.modelo.trabalhadores = threads / quantidade;
+    }
+
+    if(threads > quantidade) threads = quantidade;
+    if(threads < 1) threads = 1;
+
+    pthread_t *trabalhadores = malloc(threads * sizeof(pthread_t));
+    int criadas = 0;
+
+    for(int i = 0; trabalhadores != NULL && i < threads - 1; i++){ // a thread atual tambem trabalha
+
+        if(pthread_create(&trabalhadores[criadas], NULL, trabalhar, &lote) == 0) criadas++;
+    }
+
+    trabalhar(&lote);
+
+    for(int i = 0; i < criadas; i++){
+
+        pthread_join(trabalhadores[i], NULL);
+    }
+
+    free(trabalhadores);
+    pthread_mutex_destroy(&lote.trava);
+
+    modelo->bytes_entrada += lote.bytes_entrada;
+    modelo->bytes_saida += lote.bytes_saida;
+
+    return lote.falhas;
+}
@@ -0,0 +1,718 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "../headers/huffman.h"
+
+#ifndef _WIN32
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+// io_uring pelas chamadas de sistema, sem a liburing. Compile com -DHUFF_SEM_IO_URING para forcar
+// a versao com pread/pwrite
+
+#if defined(__linux__) && defined(__has_include) && !defined(HUFF_SEM_IO_URING)
+#if __has_include(<linux/io_uring.h>)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#define HUFF_IO_URING
+#endif
+#endif
+
+// ==================== Pipeline assincrono =======================
+
+// Tres estagios ligados por um anel de slots: uma thread le os blocos da entrada, N threads
+// compactam, e uma thread grava os blocos na ordem e monta o indice. O bloco k sempre usa o slot
+// k % quant_slots, entao ler e gravar em ordem basta para que cada slot so seja reaproveitado
+// depois de gravado. Com io_uring a leitura e a gravacao mantem varias operacoes em voo; sem ele
+// as mesmas threads fazem pread/pwrite. O disco e a CPU trabalham ao mesmo tempo, e o tempo total
+// fica perto do mais lento dos dois em vez da soma.
+
+#define PIPELINE_MAX_SLOTS 64
+
+#define SLOT_LIVRE 0
+#define SLOT_LENDO 1
+#define SLOT_LIDO 2
+#define SLOT_CODIFICANDO 3
+#define SLOT_CODIFICADO 4
+#define SLOT_GRAVANDO 5
+
+typedef struct{
+    unsigned char *entrada; // bytes originais do bloco
+    unsigned char *saida; // bloco compactado (cabecalho + conteudo + CRC)
+    size_t quantidade;
+    size_t tam_saida;
+    size_t feito; // bytes ja transferidos pela leitura/gravacao em andamento
+    uint64_t offset; // offset da leitura/gravacao em andamento
+    uint64_t bloco;
+    struct iovec vetor; // o io_uring le o iovec ate a operacao terminar
+    int estado;
+}SLOT_PIPELINE;
+
+typedef struct{
+    HUFF_CONTEXTO *ctx;
+    int entrada, saida; // descritores
+    uint64_t tamanho_original;
+    uint64_t quant_blocos;
+    SLOT_PIPELINE slots[PIPELINE_MAX_SLOTS];
+    int quant_slots;
+    uint64_t proximo_codificar;
+    uint64_t tam_saida; // bytes gravados, sem o indice
+    unsigned char *indice; // entradas + rodape, gravado no final
+    HUFF_ESTATISTICAS *estatisticas; // uma por thread (leitura, gravacao, compactadores), NULL = desligadas
+    int erro;
+    pthread_mutex_t trava;
+    pthread_cond_t mudou;
+}PIPELINE;
+
+// ==================== Fila de leitura/gravacao =======================
+
+typedef struct{
+    int anel; // descritor do io_uring, -1 = pread/pwrite na propria thread
+    unsigned pendentes; // sqes preenchidas e ainda nao enviadas ao kernel
+    uint64_t feitos_id[PIPELINE_MAX_SLOTS]; // sem io_uring: operacoes ja concluidas
+    long long feitos_resultado[PIPELINE_MAX_SLOTS];
+    int quant_feitos;
+#ifdef HUFF_IO_URING
+    unsigned *sq_cabeca, *sq_cauda, *sq_mascara, *sq_vetor;
+    unsigned *cq_cabeca, *cq_cauda, *cq_mascara;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *mapa_sq, *mapa_cq;
+    size_t tam_sq, tam_cq, tam_sqes;
+#endif
+}FILA_ES;
+
+static void iniciar_fila(FILA_ES *f, unsigned profundidade){
+
+    f->anel = -1;
+    f->pendentes = 0;
+    f->quant_feitos = 0;
+
+#ifdef HUFF_IO_URING
+    struct io_uring_params p;
+
+    memset(&p, 0, sizeof(p));
+
+    int anel = (int)syscall(__NR_io_uring_setup, profundidade, &p);
+
+    if(anel < 0) return; // kernel antigo ou io_uring bloqueado: fica com pread/pwrite
+
+    f->tam_sq = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    f->tam_cq = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    f->tam_sqes = p.sq_entries * sizeof(struct io_uring_sqe);
+
+    if(p.features & IORING_FEAT_SINGLE_MMAP){ // os dois aneis no mesmo mapeamento
+
+        if(f->tam_cq > f->tam_sq) f->tam_sq = f->tam_cq;
+
+        f->tam_cq = f->tam_sq;
+    }
+
+    f->mapa_sq = mmap(NULL, f->tam_sq, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, anel, IORING_OFF_SQ_RING);
+    f->mapa_cq = f->mapa_sq;
+
+    if(f->mapa_sq != MAP_FAILED && !(p.features & IORING_FEAT_SINGLE_MMAP)){
+
+        f->mapa_cq = mmap(NULL, f->tam_cq, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, anel, IORING_OFF_CQ_RING);
+    }
+
+    f->sqes = MAP_FAILED;
+
+    if(f->mapa_sq != MAP_FAILED && f->mapa_cq != MAP_FAILED){
+
+        f->sqes = mmap(NULL, f->tam_sqes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, anel, IORING_OFF_SQES);
+    }
+
+    if(f->sqes == MAP_FAILED){
+
+        if(f->mapa_cq != MAP_FAILED && f->mapa_cq != f->mapa_sq) munmap(f->mapa_cq, f->tam_cq);
+        if(f->mapa_sq != MAP_FAILED) munmap(f->mapa_sq, f->tam_sq);
+
+        close(anel);
+        return;
+    }
+
+    unsigned char *sq = f->mapa_sq, *cq = f->mapa_cq;
+
+    f->sq_cabeca = (unsigned*)(sq + p.sq_off.head);
+    f->sq_cauda = (unsigned*)(sq + p.sq_off.tail);
+    f->sq_mascara = (unsigned*)(sq + p.sq_off.ring_mask);
+    f->sq_vetor = (unsigned*)(sq + p.sq_off.array);
+    f->cq_cabeca = (unsigned*)(cq + p.cq_off.head);
+    f->cq_cauda = (unsigned*)(cq + p.cq_off.tail);
+    f->cq_mascara = (unsigned*)(cq + p.cq_off.ring_mask);
+    f->cqes = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+
+    f->anel = anel;
+#else
+    (void)profundidade;
+#endif
+}
+
+static void fechar_fila(FILA_ES *f){
+
+#ifdef HUFF_IO_URING
+    if(f->anel < 0) return;
+
+    munmap(f->sqes, f->tam_sqes);
+
+    if(f->mapa_cq != f->mapa_sq) munmap(f->mapa_cq, f->tam_cq);
+
+    munmap(f->mapa_sq, f->tam_sq);
+    close(f->anel);
+#else
+    (void)f;
+#endif
+}
+
+static void enviar(FILA_ES *f, int gravar, int descritor, SLOT_PIPELINE *s, uint64_t id){ // le/grava o que falta do slot
+
+    unsigned char *dados = (gravar ? s->saida : s->entrada) + s->feito;
+    size_t quantidade = (gravar ? s->tam_saida : s->quantidade) - s->feito;
+    uint64_t offset = s->offset + s->feito;
+
+#ifdef HUFF_IO_URING
+    if(f->anel >= 0){
+
+        unsigned cauda = *f->sq_cauda;
+        unsigned i = cauda & *f->sq_mascara;
+        struct io_uring_sqe *sqe = &f->sqes[i];
+
+        s->vetor.iov_base = dados;
+        s->vetor.iov_len = quantidade;
+
+        memset(sqe, 0, sizeof(struct io_uring_sqe));
+        sqe->opcode = gravar ? IORING_OP_WRITEV : IORING_OP_READV; // disponiveis desde o primeiro io_uring
+        sqe->fd = descritor;
+        sqe->addr = (uint64_t)(uintptr_t)&s->vetor;
+        sqe->len = 1;
+        sqe->off = offset;
+        sqe->user_data = id;
+
+        f->sq_vetor[i] = i;
+
+        __atomic_store_n(f->sq_cauda, cauda + 1, __ATOMIC_RELEASE);
+
+        f->pendentes++;
+        return;
+    }
+#endif
+
+    long long total = 0;
+
+    while((size_t)total < quantidade){
+
+        ssize_t n = gravar ? pwrite(descritor, dados + total, quantidade - total, (off_t)(offset + total))
+                           : pread(descritor, dados + total, quantidade - total, (off_t)(offset + total));
+
+        if(n < 0 && errno == EINTR) continue;
+
+        if(n < 0){
+
+            total = -errno;
+            break;
+        }
+
+        if(n == 0) break; // fim inesperado da entrada: quem espera ve a transferencia incompleta
+
+        total += n;
+    }
+
+    f->feitos_id[f->quant_feitos] = id;
+    f->feitos_resultado[f->quant_feitos] = total;
+    f->quant_feitos++;
+}
+
+static int esperar(FILA_ES *f, uint64_t *id, long long *resultado){ // uma operacao concluida (0) ou erro (-1)
+
+#ifdef HUFF_IO_URING
+    while(f->anel >= 0){
+
+        unsigned cabeca = *f->cq_cabeca;
+
+        if(cabeca != __atomic_load_n(f->cq_cauda, __ATOMIC_ACQUIRE)){
+
+            struct io_uring_cqe *cqe = &f->cqes[cabeca & *f->cq_mascara];
+
+            *id = cqe->user_data;
+            *resultado = cqe->res; // bytes transferidos ou -errno
+
+            __atomic_store_n(f->cq_cabeca, cabeca + 1, __ATOMIC_RELEASE);
+            return 0;
+        }
+
+        // envia o que estiver pendente e dorme ate a proxima conclusao, numa chamada so
+        int enviados = (int)syscall(__NR_io_uring_enter, f->anel, f->pendentes, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+
+        if(enviados < 0){
+
+            if(errno == EINTR) continue;
+
+            return -1;
+        }
+
+        f->pendentes -= (unsigned)enviados;
+    }
+#endif
+
+    if(f->quant_feitos == 0) return -1;
+
+    f->quant_feitos--;
+    *id = f->feitos_id[f->quant_feitos];
+    *resultado = f->feitos_resultado[f->quant_feitos];
+    return 0;
+}
+
+static int concluir(SLOT_PIPELINE *s, long long resultado, size_t total){ // 1 = terminou, 0 = falta um pedaco, -1 = erro
+
+    if(resultado <= 0) return -1; // erro de E/S ou entrada menor que o tamanho visto no inicio
+
+    s->feito += (size_t)resultado;
+
+    return s->feito == total;
+}
+
+static void falhar(PIPELINE *p){
+
+    pthread_mutex_lock(&p->trava);
+
+    p->erro = HUFF_ERRO_ES;
+    pthread_cond_broadcast(&p->mudou);
+
+    pthread_mutex_unlock(&p->trava);
+}
+
+// ==================== Estagios =======================
+
+static void* ler_blocos(void *arg){
+
+    PIPELINE *p = arg;
+    HUFF_ESTATISTICAS *est = (p->estatisticas != NULL) ? &p->estatisticas[0] : NULL;
+    uint32_t tamanho_bloco = p->ctx->tamanho_bloco;
+    uint64_t proximo = 0;
+    int em_voo = 0;
+    FILA_ES fila;
+
+    iniciar_fila(&fila, (unsigned)p->quant_slots);
+
+    for(;;){
+
+        int enviar_slots[PIPELINE_MAX_SLOTS];
+        int quant_enviar = 0;
+
+        pthread_mutex_lock(&p->trava);
+
+        while(!p->erro && proximo < p->quant_blocos && p->slots[proximo % p->quant_slots].estado == SLOT_LIVRE){
+
+            SLOT_PIPELINE *s = &p->slots[proximo % p->quant_slots];
+            uint64_t resto = p->tamanho_original - proximo * tamanho_bloco;
+
+            s->estado = SLOT_LENDO;
+            s->bloco = proximo;
+            s->quantidade = (resto < tamanho_bloco) ? (size_t)resto : tamanho_bloco;
+            s->offset = proximo * tamanho_bloco;
+            s->feito = 0;
+
+            enviar_slots[quant_enviar++] = (int)(proximo % p->quant_slots);
+            proximo++;
+        }
+
+        if(quant_enviar == 0 && em_voo == 0){
+
+            if(p->erro || proximo >= p->quant_blocos){
+
+                pthread_mutex_unlock(&p->trava);
+                break;
+            }
+
+            pthread_cond_wait(&p->mudou, &p->trava); // todos os slots esperando compactacao/gravacao
+            pthread_mutex_unlock(&p->trava);
+            continue;
+        }
+
+        pthread_mutex_unlock(&p->trava);
+
+        uint64_t relogio = (est != NULL) ? huff_relogio_ns() : 0;
+
+        for(int i = 0; i < quant_enviar; i++){
+
+            enviar(&fila, 0, p->entrada, &p->slots[enviar_slots[i]], (uint64_t)enviar_slots[i]);
+            em_voo++;
+        }
+
+        uint64_t id;
+        long long resultado;
+
+        if(esperar(&fila, &id, &resultado) != 0){
+
+            falhar(p);
+            break;
+        }
+
+        em_voo--;
+
+        SLOT_PIPELINE *s = &p->slots[id];
+        int estado = concluir(s, resultado, s->quantidade);
+
+        if(estado == 0){ // leitura curta: pede o resto
+
+            enviar(&fila, 0, p->entrada, s, id);
+            em_voo++;
+        } else if(estado < 0){
+
+            falhar(p);
+        } else {
+
+            pthread_mutex_lock(&p->trava);
+
+            s->estado = SLOT_LIDO;
+            pthread_cond_broadcast(&p->mudou);
+
+            pthread_mutex_unlock(&p->trava);
+        }
+
+        if(est != NULL) huff_marcar_fase(est, HUFF_FASE_LEITURA, relogio);
+    }
+
+    while(em_voo > 0){ // nenhum buffer pode ser liberado com leitura em voo
+
+        uint64_t id;
+        long long resultado;
+
+        if(esperar(&fila, &id, &resultado) != 0) break;
+
+        em_voo--;
+    }
+
+    fechar_fila(&fila);
+    return NULL;
+}
+
+typedef struct{
+    PIPELINE *pipeline;
+    HUFF_ESTATISTICAS *estatisticas;
+}COMPACTADOR;
+
+static void* compactar_blocos(void *arg){
+
+    COMPACTADOR *c = arg;
+    PIPELINE *p = c->pipeline;
+
+    for(;;){
+
+        pthread_mutex_lock(&p->trava);
+
+        while(!p->erro && p->proximo_codificar < p->quant_blocos && p->slots[p->proximo_codificar % p->quant_slots].estado != SLOT_LIDO){
+
+            pthread_cond_wait(&p->mudou, &p->trava);
+        }
+
+        if(p->erro || p->proximo_codificar >= p->quant_blocos){
+
+            pthread_mutex_unlock(&p->trava);
+            break;
+        }
+
+        SLOT_PIPELINE *s = &p->slots[p->proximo_codificar % p->quant_slots];
+
+        s->estado = SLOT_CODIFICANDO;
+        p->proximo_codificar++;
+
+        pthread_mutex_unlock(&p->trava);
+
+        s->tam_saida = compactar_bloco(s->entrada, s->quantidade, s->saida, p->ctx->ordem, c->estatisticas);
+
+        pthread_mutex_lock(&p->trava);
+
+        s->estado = SLOT_CODIFICADO;
+        pthread_cond_broadcast(&p->mudou);
+
+        pthread_mutex_unlock(&p->trava);
+    }
+
+    return NULL;
+}
+
+static int gravar_tudo(int descritor, const unsigned char *dados, size_t quantidade, uint64_t offset){
+
+    while(quantidade > 0){
+
+        ssize_t n = pwrite(descritor, dados, quantidade, (off_t)offset);
+
+        if(n < 0 && errno == EINTR) continue;
+
+        if(n <= 0) return -1;
+
+        dados += n;
+        quantidade -= (size_t)n;
+        offset += (uint64_t)n;
+    }
+
+    return 0;
+}
+
+static void* gravar_blocos(void *arg){
+
+    PIPELINE *p = arg;
+    HUFF_ESTATISTICAS *est = (p->estatisticas != NULL) ? &p->estatisticas[1] : NULL;
+    uint64_t proximo = 0, gravados = 0;
+    uint64_t pos = HUFF_CABECALHO_ARQUIVO;
+    int em_voo = 0;
+    FILA_ES fila;
+    unsigned char cabecalho[HUFF_CABECALHO_ARQUIVO];
+
+    escrever_cabecalho_arquivo(cabecalho, p->tamanho_original, p->ctx->tamanho_bloco);
+
+    if(gravar_tudo(p->saida, cabecalho, HUFF_CABECALHO_ARQUIVO, 0) != 0){
+
+        falhar(p);
+        return NULL;
+    }
+
+    iniciar_fila(&fila, (unsigned)p->quant_slots);
+
+    while(gravados < p->quant_blocos){
+
+        int enviar_slots[PIPELINE_MAX_SLOTS];
+        int quant_enviar = 0;
+
+        pthread_mutex_lock(&p->trava);
+
+        // os offsets so sao conhecidos em ordem: cada bloco pronto em sequencia ja pode ir para o disco
+
+        while(!p->erro && proximo < p->quant_blocos && p->slots[proximo % p->quant_slots].estado == SLOT_CODIFICADO){
+
+            SLOT_PIPELINE *s = &p->slots[proximo % p->quant_slots];
+
+            s->estado = SLOT_GRAVANDO;
+            s->offset = pos;
+            s->feito = 0;
+
+            escrever_entrada_indice(p->indice + proximo * HUFF_ENTRADA_INDICE, proximo * p->ctx->tamanho_bloco, pos, s->saida[0]);
+
+            pos += s->tam_saida;
+            enviar_slots[quant_enviar++] = (int)(proximo % p->quant_slots);
+            proximo++;
+        }
+
+        if(quant_enviar == 0 && em_voo == 0){
+
+            if(p->erro){
+
+                pthread_mutex_unlock(&p->trava);
+                break;
+            }
+
+            pthread_cond_wait(&p->mudou, &p->trava);
+            pthread_mutex_unlock(&p->trava);
+            continue;
+        }
+
+        pthread_mutex_unlock(&p->trava);
+
+        uint64_t relogio = (est != NULL) ? huff_relogio_ns() : 0;
+
+        for(int i = 0; i < quant_enviar; i++){
+
+            enviar(&fila, 1, p->saida, &p->slots[enviar_slots[i]], (uint64_t)enviar_slots[i]);
+            em_voo++;
+        }
+
+        uint64_t id;
+        long long resultado;
+
+        if(esperar(&fila, &id, &resultado) != 0){
+
+            falhar(p);
+            break;
+        }
+
+        em_voo--;
+
+        SLOT_PIPELINE *s = &p->slots[id];
+        int estado = concluir(s, resultado, s->tam_saida);
+
+        if(estado == 0){
+
+            enviar(&fila, 1, p->saida, s, id);
+            em_voo++;
+        } else if(estado < 0){
+
+            falhar(p);
+        } else {
+
+            pthread_mutex_lock(&p->trava);
+
+            s->estado = SLOT_LIVRE;
+            pthread_cond_broadcast(&p->mudou);
+
+            pthread_mutex_unlock(&p->trava);
+
+            gravados++;
+        }
+
+        if(est != NULL) huff_marcar_fase(est, HUFF_FASE_SAIDA, relogio);
+    }
+
+    while(em_voo > 0){
+
+        uint64_t id;
+        long long resultado;
+
+        if(esperar(&fila, &id, &resultado) != 0) break;
+
+        em_voo--;
+    }
+
+    fechar_fila(&fila);
+
+    p->tam_saida = pos;
+    return NULL;
+}
+
+// ==================== Compactacao em pipeline =======================
+
+int huff_compactar_pipeline(HUFF_CONTEXTO *ctx, const char *caminho_entrada, const char *caminho_saida, int trabalhadores){
+
+    PIPELINE p;
+    struct stat info;
+    int erro = HUFF_OK;
+
+    if(trabalhadores < 1) trabalhadores = 1;
+
+    memset(&p, 0, sizeof(PIPELINE));
+
+    p.ctx = ctx;
+    p.quant_slots = 2 * trabalhadores + 2; // cada compactador com um bloco, mais folga para leitura e gravacao
+
+    if(p.quant_slots > PIPELINE_MAX_SLOTS) p.quant_slots = PIPELINE_MAX_SLOTS;
+
+    p.entrada = open(caminho_entrada, O_RDONLY);
+
+    if(p.entrada < 0) return HUFF_ERRO_ES;
+
+    if(fstat(p.entrada, &info) != 0 || (p.saida = open(caminho_saida, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0){
+
+        close(p.entrada);
+        return HUFF_ERRO_ES;
+    }
+
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(p.entrada, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    p.tamanho_original = (uint64_t)info.st_size;
+    p.quant_blocos = (p.tamanho_original + ctx->tamanho_bloco - 1) / ctx->tamanho_bloco;
+    p.indice = malloc((size_t)p.quant_blocos * HUFF_ENTRADA_INDICE + HUFF_RODAPE_INDICE);
+
+    if(ctx->estatisticas != NULL){ // leitura, gravacao e um por compactador
+
+        p.estatisticas = calloc(2 + trabalhadores, sizeof(HUFF_ESTATISTICAS));
+
+        if(p.estatisticas == NULL) erro = HUFF_ERRO_MEMORIA;
+    }
+
+    for(int i = 0; i < p.quant_slots && erro == HUFF_OK; i++){
+
+        p.slots[i].entrada = malloc(ctx->tamanho_bloco);
+        p.slots[i].saida = malloc(HUFF_CABECALHO_BLOCO + (size_t)ctx->tamanho_bloco + HUFF_TAMANHO_CRC);
+
+        if(p.slots[i].entrada == NULL || p.slots[i].saida == NULL) erro = HUFF_ERRO_MEMORIA;
+    }
+
+    COMPACTADOR *compactadores = malloc(trabalhadores * sizeof(COMPACTADOR));
+    pthread_t *threads = malloc((2 + trabalhadores) * sizeof(pthread_t));
+    int criadas = 0;
+
+    if(p.indice == NULL || compactadores == NULL || threads == NULL) erro = HUFF_ERRO_MEMORIA;
+
+    pthread_mutex_init(&p.trava, NULL);
+    pthread_cond_init(&p.mudou, NULL);
+
+    if(erro == HUFF_OK){
+
+        // a leitura e a gravacao so esperam o disco, entao rodam em threads proprias alem dos compactadores
+
+        int ok = pthread_create(&threads[criadas], NULL, ler_blocos, &p) == 0;
+
+        criadas += ok;
+        ok = ok && pthread_create(&threads[criadas], NULL, gravar_blocos, &p) == 0;
+        criadas += ok;
+
+        for(int i = 0; ok && i < trabalhadores; i++){
+
+            compactadores[i].pipeline = &p;
+            compactadores[i].estatisticas = (p.estatisticas != NULL) ? &p.estatisticas[2 + i] : NULL;
+
+            ok = pthread_create(&threads[criadas], NULL, compactar_blocos, &compactadores[i]) == 0;
+            criadas += ok;
+        }
+
+        if(criadas < 2 + trabalhadores){ // sem todas as threads o pipeline pode travar: cancela
+
+            falhar(&p);
+            erro = HUFF_ERRO_MEMORIA;
+        }
+
+        for(int i = 0; i < criadas; i++){
+
+            pthread_join(threads[i], NULL);
+        }
+
+        if(erro == HUFF_OK) erro = p.erro;
+    }
+
+    if(erro == HUFF_OK){ // indice e rodape depois do ultimo bloco
+
+        size_t tam_indice = (size_t)p.quant_blocos * HUFF_ENTRADA_INDICE;
+
+        escrever_rodape_indice(p.indice + tam_indice, (uint32_t)p.quant_blocos, p.tam_saida);
+
+        if(gravar_tudo(p.saida, p.indice, tam_indice + HUFF_RODAPE_INDICE, p.tam_saida) != 0) erro = HUFF_ERRO_ES;
+
+        ctx->bytes_entrada += p.tamanho_original;
+        ctx->bytes_saida += p.tam_saida + tam_indice + HUFF_RODAPE_INDICE;
+    }
+
+    if(close(p.saida) != 0 && erro == HUFF_OK) erro = HUFF_ERRO_ES;
+
+    if(erro != HUFF_OK) unlink(caminho_saida); // nao deixa uma saida pela metade
+
+    close(p.entrada);
+
+    if(p.estatisticas != NULL){
+
+        for(int i = 0; i < 2 + trabalhadores; i++){
+
+            huff_somar_estatisticas(ctx->estatisticas, &p.estatisticas[i]);
+        }
+
+        ctx->estatisticas->arquivos++;
+        ctx->estatisticas->alocacoes += 2 * p.quant_slots + 4;
+    }
+
+    for(int i = 0; i < p.quant_slots; i++){
+
+        free(p.slots[i].entrada);
+        free(p.slots[i].saida);
+    }
+
+    pthread_mutex_destroy(&p.trava);
+    pthread_cond_destroy(&p.mudou);
+
+    free(p.estatisticas);
+    free(p.indice);
+    free(compactadores);
+    free(threads);
+    return erro;
+}
+
+#endif
@@ -0,0 +1,233 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <nmmintrin.h>
+#define HUFF_CRC_SSE42
+#endif
+
+#include "../headers/huffman.h"
+
+// ==================== CRC32C =======================
+
+// CRC32C (polinomio de Castagnoli, o mesmo do iSCSI e do ext4). Em processadores x86 com SSE4.2 a
+// instrucao crc32 calcula 8 bytes por vez; nos outros a versao por tabela processa 8 bytes por
+// iteracao com 8 tabelas de 256 entradas (slicing-by-8).
+
+static uint32_t tabela_crc[8][256];
+static uint32_t (*crc_atualizar)(uint32_t crc, const unsigned char *dados, size_t quantidade);
+static pthread_once_t crc_iniciado = PTHREAD_ONCE_INIT;
+
+static uint32_t crc_tabela(uint32_t crc, const unsigned char *dados, size_t quantidade){
+
+    while(quantidade >= 8){
+
+        uint32_t baixo = crc ^ ((uint32_t)dados[0] | (uint32_t)dados[1] << 8 | (uint32_t)dados[2] << 16 | (uint32_t)dados[3] << 24);
+
+        crc = tabela_crc[7][baixo & 0xFF] ^ tabela_crc[6][(baixo >> 8) & 0xFF] ^ tabela_crc[5][(baixo >> 16) & 0xFF] ^ tabela_crc[4][baixo >> 24] ^
+              tabela_crc[3][dados[4]] ^ tabela_crc[2][dados[5]] ^ tabela_crc[1][dados[6]] ^ tabela_crc[0][dados[7]];
+
+        dados += 8;
+        quantidade -= 8;
+    }
+
+    while(quantidade-- > 0){
+
+        crc = tabela_crc[0][(crc ^ *dados++) & 0xFF] ^ (crc >> 8);
+    }
+
+    return crc;
+}
+
+#ifdef HUFF_CRC_SSE42
+
+__attribute__((target("sse4.2"))) static uint32_t crc_sse42(uint32_t crc, const unsigned char *dados, size_t quantidade){
+
+#ifdef __x86_64__
+    uint64_t crc64 = crc;
+
+    for(; quantidade >= 8; dados += 8, quantidade -= 8){
+
+        uint64_t palavra;
+
+        memcpy(&palavra, dados, 8);
+        crc64 = _mm_crc32_u64(crc64, palavra);
+    }
+
+    crc = (uint32_t)crc64;
+#endif
+
+    for(; quantidade >= 4; dados += 4, quantidade -= 4){
+
+        uint32_t palavra;
+
+        memcpy(&palavra, dados, 4);
+        crc = _mm_crc32_u32(crc, palavra);
+    }
+
+    while(quantidade-- > 0){
+
+        crc = _mm_crc32_u8(crc, *dados++);
+    }
+
+    return crc;
+}
+
+#endif
+
+static void iniciar_crc(){
+
+    for(uint32_t i = 0; i < 256; i++){
+
+        uint32_t crc = i;
+
+        for(int bit = 0; bit < 8; bit++){
+
+            crc = (crc & 1) ? (crc >> 1) ^ 0x82F63B78u : crc >> 1; // polinomio refletido
+        }
+
+        tabela_crc[0][i] = crc;
+    }
+
+    for(int t = 1; t < 8; t++){
+
+        for(int i = 0; i < 256; i++){
+
+            tabela_crc[t][i] = (tabela_crc[t - 1][i] >> 8) ^ tabela_crc[0][tabela_crc[t - 1][i] & 0xFF];
+        }
+    }
+
+    crc_atualizar = crc_tabela;
+
+#ifdef HUFF_CRC_SSE42
+    if(__builtin_cpu_supports("sse4.2")) crc_atualizar = crc_sse42;
+#endif
+}
+
+uint32_t huff_crc32c(const unsigned char *dados, size_t quantidade){
+
+    pthread_once(&crc_iniciado, iniciar_crc);
+
+    return ~crc_atualizar(~0u, dados, quantidade);
+}
+
+// ==================== Verificacao em paralelo =======================
+
+typedef struct{
+    HUFF_ARQUIVO *arquivo;
+    uint32_t proximo; // proximo bloco ainda nao verificado
+    uint32_t invalidos;
+    uint32_t sem_crc;
+    long long primeiro_invalido; // -1 = nenhum
+    pthread_mutex_t trava;
+}VERIFICACAO;
+
+static void* verificar_blocos(void *arg){
+
+    VERIFICACAO *v = arg;
+    HUFF_ARQUIVO *a = v->arquivo;
+    unsigned char *texto = malloc(a->tamanho_bloco > 0 ? a->tamanho_bloco : 1); // descartado: so o CRC importa
+
+    for(;;){
+
+        pthread_mutex_lock(&v->trava);
+
+        uint32_t i = v->proximo++;
+
+        pthread_mutex_unlock(&v->trava);
+
+        if(i >= a->quant_blocos) break;
+
+        // cada bloco precisa descompactar exatamente ate o inicio do proximo, nos dois lados: a entrada
+        // do indice tem de bater com o tipo e com o tamanho gravados no cabecalho do bloco
+
+        ENTRADA_INDICE *e = &a->blocos[i];
+        uint64_t fim = (i + 1 < a->quant_blocos) ? a->blocos[i + 1].offset_original : a->tamanho_original;
+        uint64_t fim_compactado = (i + 1 < a->quant_blocos) ? a->blocos[i + 1].offset_compactado : a->fim_blocos;
+        size_t lidos, escritos;
+        int valido = texto != NULL && fim - e->offset_original <= a->tamanho_bloco && a->dados[e->offset_compactado] == e->tipo;
+
+        valido = valido && descompactar_bloco(a->dados + e->offset_compactado, a->tamanho - e->offset_compactado, texto, a->tamanho_bloco, &lidos, &escritos) == 0;
+        valido = valido && escritos == fim - e->offset_original && lidos == fim_compactado - e->offset_compactado;
+
+        pthread_mutex_lock(&v->trava);
+
+        if(!valido){
+
+            v->invalidos++;
+
+            if(v->primeiro_invalido < 0 || i < v->primeiro_invalido) v->primeiro_invalido = i;
+        }
+
+        if(!(a->dados[e->offset_compactado] & BLOCO_VERIFICADO)) v->sem_crc++;
+
+        pthread_mutex_unlock(&v->trava);
+    }
+
+    free(texto);
+    return NULL;
+}
+
+int huff_verificar_arquivo(const char *caminho, int threads, HUFF_RESULTADO_VERIFICACAO *resultado){
+
+    HUFF_ARQUIVO arquivo;
+    VERIFICACAO v;
+
+    memset(resultado, 0, sizeof(HUFF_RESULTADO_VERIFICACAO));
+    resultado->primeiro_invalido = -1;
+
+    int erro = huff_abrir(&arquivo, caminho); // le o indice ou percorre os cabecalhos
+
+    if(erro != HUFF_OK) return erro;
+
+    // huff_abrir so aceita um indice que comeca no offset 0, e contiguo e soma tamanho_original; um
+    // indice recusado nao impede descompactar em sequencia, mas o arquivo nao passa na verificacao
+
+    resultado->indice_invalido = arquivo.indice_invalido;
+
+    v.arquivo = &arquivo;
+    v.proximo = 0;
+    v.invalidos = 0;
+    v.sem_crc = 0;
+    v.primeiro_invalido = -1;
+
+    pthread_mutex_init(&v.trava, NULL);
+
+    if(threads > (int)arquivo.quant_blocos) threads = (int)arquivo.quant_blocos;
+    if(threads < 1) threads = 1;
+
+    pthread_t *trabalhadores = malloc(threads * sizeof(pthread_t));
+    int criadas = 0;
+
+    for(int i = 0; trabalhadores != NULL && i < threads - 1; i++){ // a thread atual tambem verifica
+
+        if(pthread_create(&trabalhadores[criadas], NULL, verificar_blocos, &v) == 0) criadas++;
+    }
+
+    verificar_blocos(&v);
+
+    for(int i = 0; i < criadas; i++){
+
+        pthread_join(trabalhadores[i], NULL);
+    }
+
+    free(trabalhadores);
+    pthread_mutex_destroy(&v.trava);
+
+    resultado->blocos = arquivo.quant_blocos;
+    resultado->invalidos = v.invalidos;
+    resultado->sem_crc = v.sem_crc;
+
+    if(v.primeiro_invalido >= 0){
+
+        resultado->primeiro_invalido = v.primeiro_invalido;
+        resultado->offset_invalido = arquivo.blocos[v.primeiro_invalido].offset_compactado;
+    }
+
+    huff_fechar(&arquivo);
+
+    return (v.invalidos > 0 || resultado->indice_invalido) ? HUFF_ERRO_FORMATO : HUFF_OK;
+}